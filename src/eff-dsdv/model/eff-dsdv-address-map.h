@@ -0,0 +1,415 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+#ifndef EFFDSDV_ADDRESS_MAP_H
+#define EFFDSDV_ADDRESS_MAP_H
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+/**
+ * \ingroup dsdv
+ * \brief Open-addressing hash map keyed on IPv4 addresses
+ *
+ * Drop-in replacement for the std::map<Ipv4Address, T> containers of the
+ * routing table. Slot states and the 32-bit keys are kept in their own
+ * arrays, so a probe sequence only walks a few contiguous words and the
+ * mapped value is touched on a hit only. Collisions are resolved by linear
+ * probing. Erased slots are turned into tombstones which are reclaimed on
+ * the next rehash; erase () therefore never moves other elements and
+ * iterators stay valid across it. insert () may rehash and invalidates all
+ * iterators. Iteration order is unspecified.
+ */
+template <typename T>
+class AddressMap
+{
+public:
+  /// Element type, laid out like the one of std::map
+  typedef std::pair<Ipv4Address, T> value_type;
+
+  /// Forward iterator over the occupied slots
+  template <typename M, typename V>
+  class Iterator
+  {
+  public:
+    /// Default c-tor
+    Iterator ()
+      : m_map (0),
+        m_pos (0)
+    {
+    }
+    /**
+     * c-tor
+     * \param map the map to iterate
+     * \param pos first slot to consider
+     */
+    Iterator (M *map, uint32_t pos)
+      : m_map (map),
+        m_pos (pos)
+    {
+      SkipFree ();
+    }
+    /**
+     * Conversion from a mutable to a constant iterator
+     * \param o the iterator to convert
+     */
+    template <typename M2, typename V2>
+    Iterator (Iterator<M2, V2> const & o)
+      : m_map (o.m_map),
+        m_pos (o.m_pos)
+    {
+    }
+    /// \returns the element
+    V &
+    operator* () const
+    {
+      return m_map->m_values[m_pos];
+    }
+    /// \returns the element
+    V *
+    operator-> () const
+    {
+      return &m_map->m_values[m_pos];
+    }
+    /// Advance to the next occupied slot
+    Iterator &
+    operator++ ()
+    {
+      ++m_pos;
+      SkipFree ();
+      return *this;
+    }
+    /// Advance to the next occupied slot
+    Iterator
+    operator++ (int)
+    {
+      Iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+    /// \returns true if both iterators point to the same slot
+    template <typename M2, typename V2>
+    bool
+    operator== (Iterator<M2, V2> const & o) const
+    {
+      return m_pos == o.m_pos;
+    }
+    /// \returns true if the iterators point to different slots
+    template <typename M2, typename V2>
+    bool
+    operator!= (Iterator<M2, V2> const & o) const
+    {
+      return m_pos != o.m_pos;
+    }
+
+  private:
+    template <typename M2, typename V2> friend class Iterator;
+    friend class AddressMap;
+    /// Move forward until an occupied slot or the end is reached
+    void
+    SkipFree ()
+    {
+      while (m_pos < m_map->m_states.size () && m_map->m_states[m_pos] != FULL)
+        {
+          ++m_pos;
+        }
+    }
+    M *m_map;        ///< the map being iterated
+    uint32_t m_pos;  ///< current slot
+  };
+
+  /// Mutable iterator
+  typedef Iterator<AddressMap, value_type> iterator;
+  /// Constant iterator
+  typedef Iterator<const AddressMap, const value_type> const_iterator;
+
+  /// c-tor
+  AddressMap ()
+    : m_size (0),
+      m_tombstones (0)
+  {
+  }
+
+  /// \returns iterator to the first element
+  iterator begin ()
+  {
+    return iterator (this, 0);
+  }
+  /// \returns past-the-end iterator
+  iterator end ()
+  {
+    return iterator (this, m_states.size ());
+  }
+  /// \returns iterator to the first element
+  const_iterator begin () const
+  {
+    return const_iterator (this, 0);
+  }
+  /// \returns past-the-end iterator
+  const_iterator end () const
+  {
+    return const_iterator (this, m_states.size ());
+  }
+  /// \returns the number of elements
+  uint32_t size () const
+  {
+    return m_size;
+  }
+  /// \returns true if there are no elements
+  bool empty () const
+  {
+    return m_size == 0;
+  }
+  /// \returns the number of slots currently allocated
+  uint32_t capacity () const
+  {
+    return m_states.size ();
+  }
+
+  /**
+   * Lookup an element
+   * \param key the address to look for
+   * \returns iterator to the element or end ()
+   */
+  iterator
+  find (Ipv4Address key)
+  {
+    return iterator (this, FindSlot (key.Get ()));
+  }
+  /**
+   * Lookup an element
+   * \param key the address to look for
+   * \returns iterator to the element or end ()
+   */
+  const_iterator
+  find (Ipv4Address key) const
+  {
+    return const_iterator (this, FindSlot (key.Get ()));
+  }
+  /**
+   * Insert an element unless its key is already present
+   * \param value the element
+   * \returns iterator to the element with that key and true if it was inserted
+   */
+  std::pair<iterator, bool>
+  insert (value_type const & value)
+  {
+    uint32_t key = value.first.Get ();
+    uint32_t pos = FindSlot (key);
+    if (pos != m_states.size ())
+      {
+        return std::make_pair (iterator (this, pos), false);
+      }
+    Reserve (m_size + 1);
+    uint32_t mask = m_states.size () - 1;
+    pos = Hash (key) & mask;
+    while (m_states[pos] == FULL)
+      {
+        pos = (pos + 1) & mask;
+      }
+    if (m_states[pos] == TOMBSTONE)
+      {
+        --m_tombstones;
+      }
+    m_states[pos] = FULL;
+    m_keys[pos] = key;
+    m_values[pos] = value;
+    ++m_size;
+    return std::make_pair (iterator (this, pos), true);
+  }
+  /**
+   * Access an element, inserting a default constructed one if needed
+   * \param key the address
+   * \returns the mapped value
+   */
+  T &
+  operator[] (Ipv4Address key)
+  {
+    return insert (std::make_pair (key, T ())).first->second;
+  }
+  /**
+   * Remove the element with the given key
+   * \param key the address
+   * \returns the number of removed elements (0 or 1)
+   */
+  uint32_t
+  erase (Ipv4Address key)
+  {
+    uint32_t pos = FindSlot (key.Get ());
+    if (pos == m_states.size ())
+      {
+        return 0;
+      }
+    EraseSlot (pos);
+    return 1;
+  }
+  /**
+   * Remove the element the iterator points to. Other iterators remain valid.
+   * \param it iterator to an element of this map
+   */
+  void
+  erase (iterator it)
+  {
+    EraseSlot (it.m_pos);
+  }
+  /// Remove all elements, keeping the allocated slots
+  void
+  clear ()
+  {
+    for (uint32_t i = 0; i < m_states.size (); ++i)
+      {
+        if (m_states[i] == FULL)
+          {
+            m_values[i] = value_type ();
+          }
+        m_states[i] = EMPTY;
+      }
+    m_size = 0;
+    m_tombstones = 0;
+  }
+  /**
+   * Make room for n elements without further rehashing
+   * \param n the number of elements
+   */
+  void
+  Reserve (uint32_t n)
+  {
+    if ((n + m_tombstones) * 4 < m_states.size () * 3)
+      {
+        return;
+      }
+    uint32_t slots = 16;
+    while (n * 2 > slots)
+      {
+        slots *= 2;
+      }
+    Rehash (slots);
+  }
+
+private:
+  /// Slot states
+  enum SlotState
+  {
+    EMPTY = 0,     //!< never used since the last rehash, terminates probing
+    FULL = 1,      //!< holds an element
+    TOMBSTONE = 2, //!< element erased, probing continues
+  };
+  /**
+   * Mix the address bits so that consecutive addresses spread over the table
+   * \param key the address
+   * \returns the hash value
+   */
+  static uint32_t
+  Hash (uint32_t key)
+  {
+    key *= 0x9e3779b1u;
+    return key ^ (key >> 16);
+  }
+  /**
+   * Find the slot holding the key
+   * \param key the address
+   * \returns the slot index or capacity () if not found
+   */
+  uint32_t
+  FindSlot (uint32_t key) const
+  {
+    if (m_size == 0)
+      {
+        return m_states.size ();
+      }
+    uint32_t mask = m_states.size () - 1;
+    for (uint32_t pos = Hash (key) & mask;; pos = (pos + 1) & mask)
+      {
+        if (m_states[pos] == EMPTY)
+          {
+            return m_states.size ();
+          }
+        if (m_states[pos] == FULL && m_keys[pos] == key)
+          {
+            return pos;
+          }
+      }
+  }
+  /**
+   * Turn an occupied slot into a tombstone
+   * \param pos the slot
+   */
+  void
+  EraseSlot (uint32_t pos)
+  {
+    m_states[pos] = TOMBSTONE;
+    m_values[pos] = value_type ();
+    --m_size;
+    ++m_tombstones;
+  }
+  /**
+   * Move all elements into a table with the given number of slots
+   * \param slots the new number of slots, a power of two
+   */
+  void
+  Rehash (uint32_t slots)
+  {
+    std::vector<uint8_t> states (slots, EMPTY);
+    std::vector<uint32_t> keys (slots);
+    std::vector<value_type> values (slots);
+    uint32_t mask = slots - 1;
+    for (uint32_t i = 0; i < m_states.size (); ++i)
+      {
+        if (m_states[i] != FULL)
+          {
+            continue;
+          }
+        uint32_t pos = Hash (m_keys[i]) & mask;
+        while (states[pos] == FULL)
+          {
+            pos = (pos + 1) & mask;
+          }
+        states[pos] = FULL;
+        keys[pos] = m_keys[i];
+        values[pos] = m_values[i];
+      }
+    m_states.swap (states);
+    m_keys.swap (keys);
+    m_values.swap (values);
+    m_tombstones = 0;
+  }
+
+  /// Slot states, see SlotState
+  std::vector<uint8_t> m_states;
+  /// Raw address of every occupied slot
+  std::vector<uint32_t> m_keys;
+  /// Elements
+  std::vector<value_type> m_values;
+  /// Number of elements
+  uint32_t m_size;
+  /// Number of erased slots since the last rehash
+  uint32_t m_tombstones;
+};
+
+}
+}
+#endif /* EFFDSDV_ADDRESS_MAP_H */
@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+
+#include <algorithm>
+#include "ns3/assert.h"
+#include "eff-dsdv-alt-routes.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+AlternativeRoutes::AlternativeRoutes (uint32_t maxCandidates)
+{
+  SetMaxCandidates (maxCandidates);
+}
+
+void
+AlternativeRoutes::SetMaxCandidates (uint32_t maxCandidates)
+{
+  NS_ASSERT (maxCandidates > 0);
+  m_maxCandidates = maxCandidates;
+  for (AddressMap<std::vector<RoutingTableEntry> >::iterator i = m_candidates.begin (); i != m_candidates.end (); ++i)
+    {
+      if (i->second.size () > m_maxCandidates)
+        {
+          i->second.resize (m_maxCandidates);
+        }
+    }
+}
+
+bool
+AlternativeRoutes::IsBetter (RoutingTableEntry const & a, RoutingTableEntry const & b)
+{
+  if (a.GetHop () != b.GetHop ())
+    {
+      return a.GetHop () < b.GetHop ();
+    }
+  if (a.GetLifeTime () != b.GetLifeTime ())
+    {
+      return a.GetLifeTime () < b.GetLifeTime ();
+    }
+  return a.GetInstallTime () < b.GetInstallTime ();
+}
+
+bool
+AlternativeRoutes::Offer (RoutingTableEntry const & rt)
+{
+  std::vector<RoutingTableEntry> & candidates = m_candidates[rt.GetDestination ()];
+  std::vector<RoutingTableEntry>::iterator i = candidates.begin ();
+  while (i != candidates.end () && i->GetNextHop () != rt.GetNextHop ())
+    {
+      ++i;
+    }
+  if (i != candidates.end ())
+    {
+      candidates.erase (i);
+    }
+  // candidates are kept sorted, so the route goes in front of the first one it beats
+  i = candidates.begin ();
+  while (i != candidates.end () && !IsBetter (rt, *i))
+    {
+      ++i;
+    }
+  if (uint32_t (i - candidates.begin ()) >= m_maxCandidates)
+    {
+      if (candidates.empty ())
+        {
+          m_candidates.erase (rt.GetDestination ());
+        }
+      return false;
+    }
+  candidates.insert (i, rt);
+  if (candidates.size () > m_maxCandidates)
+    {
+      candidates.pop_back ();
+    }
+  return true;
+}
+
+bool
+AlternativeRoutes::Remove (Ipv4Address dst, Ipv4Address nextHop)
+{
+  AddressMap<std::vector<RoutingTableEntry> >::iterator i = m_candidates.find (dst);
+  if (i == m_candidates.end ())
+    {
+      return false;
+    }
+  for (std::vector<RoutingTableEntry>::iterator j = i->second.begin (); j != i->second.end (); ++j)
+    {
+      if (j->GetNextHop () == nextHop)
+        {
+          i->second.erase (j);
+          if (i->second.empty ())
+            {
+              m_candidates.erase (i);
+            }
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+AlternativeRoutes::GetBest (Ipv4Address dst, RoutingTableEntry & rt) const
+{
+  AddressMap<std::vector<RoutingTableEntry> >::const_iterator i = m_candidates.find (dst);
+  if (i == m_candidates.end ())
+    {
+      return false;
+    }
+  rt = i->second.front ();
+  return true;
+}
+
+std::vector<RoutingTableEntry> const *
+AlternativeRoutes::GetCandidates (Ipv4Address dst) const
+{
+  AddressMap<std::vector<RoutingTableEntry> >::const_iterator i = m_candidates.find (dst);
+  return i == m_candidates.end () ? 0 : &i->second;
+}
+
+}
+}
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+
+#ifndef EFFDSDV_ALT_ROUTES_H
+#define EFFDSDV_ALT_ROUTES_H
+
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "eff-dsdv-address-map.h"
+#include "eff-dsdv-rtable.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+/**
+ * \ingroup dsdv
+ * \brief Keeps the best few alternative routes learned for each destination
+ *
+ * Candidates are ranked by hop count, then by the age of the acknowledged
+ * information (GetLifeTime), then by the time they were installed
+ * (GetInstallTime). There is at most one candidate per next hop, and at
+ * most a configurable number per destination. Whether a next hop is still
+ * alive is up to the caller, which drops a candidate with Remove () once
+ * it turns out to be unusable; the next one then becomes the best.
+ */
+class AlternativeRoutes
+{
+public:
+  /**
+   * c-tor
+   * \param maxCandidates number of candidates kept per destination
+   */
+  AlternativeRoutes (uint32_t maxCandidates = 3);
+  /**
+   * Set the number of candidates kept per destination
+   * \param maxCandidates the number, at least one
+   */
+  void
+  SetMaxCandidates (uint32_t maxCandidates);
+  /// \returns the number of candidates kept per destination
+  uint32_t
+  GetMaxCandidates () const
+  {
+    return m_maxCandidates;
+  }
+  /**
+   * Offer a route, replacing the candidate with the same next hop
+   * \param rt the route
+   * \returns true if the route ranks among the best candidates of its destination
+   */
+  bool
+  Offer (RoutingTableEntry const & rt);
+  /**
+   * Drop the candidate of a destination via a next hop
+   * \param dst the destination
+   * \param nextHop the next hop
+   * \returns true if there was such a candidate
+   */
+  bool
+  Remove (Ipv4Address dst, Ipv4Address nextHop);
+  /**
+   * Get the best candidate of a destination
+   * \param dst the destination
+   * \param rt the candidate, if any
+   * \returns true if the destination has a candidate
+   */
+  bool
+  GetBest (Ipv4Address dst, RoutingTableEntry & rt) const;
+  /**
+   * \param dst the destination
+   * \returns the candidates of the destination, best first, or 0 if there are none
+   */
+  std::vector<RoutingTableEntry> const *
+  GetCandidates (Ipv4Address dst) const;
+  /**
+   * Drop all candidates of a destination
+   * \param dst the destination
+   */
+  void
+  Erase (Ipv4Address dst)
+  {
+    m_candidates.erase (dst);
+  }
+  /// \returns the number of destinations with candidates
+  uint32_t
+  GetSize () const
+  {
+    return m_candidates.size ();
+  }
+  /// Drop all candidates
+  void
+  Clear ()
+  {
+    m_candidates.clear ();
+  }
+  /**
+   * \param a a route
+   * \param b another route to the same destination
+   * \returns true if a ranks before b
+   */
+  static bool
+  IsBetter (RoutingTableEntry const & a, RoutingTableEntry const & b);
+
+private:
+  /// destination -> its candidates, best first
+  AddressMap<std::vector<RoutingTableEntry> > m_candidates;
+  /// number of candidates kept per destination
+  uint32_t m_maxCandidates;
+};
+
+}
+}
+#endif /* EFFDSDV_ALT_ROUTES_H */
@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+
+#include "ns3/simulator.h"
+#include "eff-dsdv-forwarding-table.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+ForwardingTable::ForwardingTable ()
+  : m_version (0),
+    m_hits (0),
+    m_misses (0)
+{
+}
+
+Ptr<Ipv4Route>
+ForwardingTable::Lookup (Ipv4Address dst)
+{
+  AddressMap<Entry>::iterator i = m_entries.find (dst);
+  if (i == m_entries.end ())
+    {
+      ++m_misses;
+      return 0;
+    }
+  if (i->second.version != m_version || i->second.expires <= Simulator::Now ())
+    {
+      m_entries.erase (i);
+      ++m_misses;
+      return 0;
+    }
+  ++m_hits;
+  return i->second.route;
+}
+
+void
+ForwardingTable::Install (Ipv4Address dst, Ptr<Ipv4Route> route, Time expires)
+{
+  Entry & entry = m_entries[dst];
+  entry.route = route;
+  entry.expires = expires;
+  entry.version = m_version;
+}
+
+}
+}
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+
+#ifndef EFFDSDV_FORWARDING_TABLE_H
+#define EFFDSDV_FORWARDING_TABLE_H
+
+#include <stdint.h>
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/nstime.h"
+#include "eff-dsdv-address-map.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+/**
+ * \ingroup dsdv
+ * \brief Ready-made routes for the data path
+ *
+ * Maps a destination to the Ipv4Route the routing tables resolve it to, so a
+ * forwarded packet costs one lookup instead of a walk through the routing
+ * tables. An entry is good until its expiry, the time the routes it was
+ * resolved from stop being alive, and is dropped by Invalidate () as soon
+ * as one of them changes. Every entry carries the version of the table it
+ * was installed under; InvalidateAll () bumps the version and so drops all
+ * entries at once, leaving them to be overwritten lazily.
+ */
+class ForwardingTable
+{
+public:
+  /// c-tor
+  ForwardingTable ();
+  /**
+   * Get the route to a destination
+   * \param dst the destination
+   * \returns the route, or 0 if there is no current entry
+   */
+  Ptr<Ipv4Route>
+  Lookup (Ipv4Address dst);
+  /**
+   * Add or replace the route to a destination
+   * \param dst the destination
+   * \param route the route
+   * \param expires the entry is not used from this time on
+   */
+  void
+  Install (Ipv4Address dst, Ptr<Ipv4Route> route, Time expires);
+  /**
+   * Drop the route to a destination
+   * \param dst the destination
+   */
+  void
+  Invalidate (Ipv4Address dst)
+  {
+    m_entries.erase (dst);
+  }
+  /// Drop all routes
+  void
+  InvalidateAll ()
+  {
+    ++m_version;
+  }
+  /// Drop all routes and release their memory
+  void
+  Clear ()
+  {
+    m_entries.clear ();
+    ++m_version;
+  }
+  /// \returns the current version
+  uint32_t
+  GetVersion () const
+  {
+    return m_version;
+  }
+  /// \returns the number of lookups answered by the table
+  uint64_t
+  GetHits () const
+  {
+    return m_hits;
+  }
+  /// \returns the number of lookups left to the routing tables
+  uint64_t
+  GetMisses () const
+  {
+    return m_misses;
+  }
+
+private:
+  /// A ready-made route
+  struct Entry
+  {
+    Ptr<Ipv4Route> route; ///< the route
+    Time expires;         ///< the entry is not used from this time on
+    uint32_t version;     ///< version of the table the entry was installed under
+  };
+  /// destination -> its route
+  AddressMap<Entry> m_entries;
+  /// entries installed under another version are stale
+  uint32_t m_version;
+  /// lookups answered by the table
+  uint64_t m_hits;
+  /// lookups left to the routing tables
+  uint64_t m_misses;
+};
+
+}
+}
+#endif /* EFFDSDV_FORWARDING_TABLE_H */
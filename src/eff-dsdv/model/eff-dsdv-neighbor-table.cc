@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+#include "eff-dsdv-neighbor-table.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+NeighborTable::NeighborTable ()
+{
+}
+
+Ptr<Ipv4Route>
+NeighborTable::GetRoute (Ipv4Address neighbor, Ptr<NetDevice> dev, Ipv4Address source)
+{
+  std::vector<Slot> & slots = m_routes[neighbor];
+  Slot *slot = 0;
+  for (std::vector<Slot>::iterator i = slots.begin (); i != slots.end (); ++i)
+    {
+      if (i->dev == dev)
+        {
+          slot = &*i;
+          break;
+        }
+    }
+  if (slot != 0 && slot->route->GetSource () == source)
+    {
+      return slot->route;
+    }
+  if (slot == 0)
+    {
+      slots.push_back (Slot ());
+      slot = &slots.back ();
+      slot->dev = dev;
+    }
+  slot->route = Create<Ipv4Route> ();
+  slot->route->SetDestination (neighbor);
+  slot->route->SetGateway (neighbor);
+  slot->route->SetSource (source);
+  slot->route->SetOutputDevice (dev);
+  return slot->route;
+}
+
+void
+NeighborTable::Remove (Ipv4Address neighbor)
+{
+  m_routes.erase (neighbor);
+}
+
+uint32_t
+NeighborTable::GetSize () const
+{
+  uint32_t size = 0;
+  for (AddressMap<std::vector<Slot> >::const_iterator i = m_routes.begin (); i != m_routes.end (); ++i)
+    {
+      size += i->second.size ();
+    }
+  return size;
+}
+
+}
+}
@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+#ifndef EFFDSDV_NEIGHBOR_TABLE_H
+#define EFFDSDV_NEIGHBOR_TABLE_H
+
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/net-device.h"
+#include "eff-dsdv-address-map.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+/**
+ * \ingroup dsdv
+ * \brief Routes towards the neighbors of a node
+ *
+ * Owns one Ipv4Route per (neighbor, output device) pair. Every destination forwarded
+ * over a neighbor is handed the same route object, so the forwarding path does not
+ * allocate. Routes are never modified once handed out; if the source address of a
+ * neighbor changes, a new route replaces the old one.
+ */
+class NeighborTable
+{
+public:
+  /// c-tor
+  NeighborTable ();
+  /**
+   * Get the route towards a neighbor, creating it on first use
+   * \param neighbor the neighbor, used as gateway and destination of the route
+   * \param dev the output device
+   * \param source the source address of the route
+   * \returns the route
+   */
+  Ptr<Ipv4Route>
+  GetRoute (Ipv4Address neighbor, Ptr<NetDevice> dev, Ipv4Address source);
+  /**
+   * Forget the routes towards a neighbor
+   * \param neighbor the neighbor
+   */
+  void
+  Remove (Ipv4Address neighbor);
+  /// Forget all routes
+  void
+  Clear ()
+  {
+    m_routes.clear ();
+  }
+  /// \returns the number of routes held
+  uint32_t
+  GetSize () const;
+
+private:
+  /// Route towards a neighbor over one device
+  struct Slot
+  {
+    Ptr<NetDevice> dev;   ///< output device
+    Ptr<Ipv4Route> route; ///< route handed out for this device
+  };
+  /// neighbor -> its routes, usually a single one
+  AddressMap<std::vector<Slot> > m_routes;
+};
+
+}
+}
+#endif /* EFFDSDV_NEIGHBOR_TABLE_H */
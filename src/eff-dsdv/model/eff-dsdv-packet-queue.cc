@@ -35,7 +35,7 @@ uint32_t
 PacketQueue::GetSize ()
 {
   Purge ();
-  return m_queue.size ();
+  return m_size;
 }
 
 bool
@@ -43,32 +43,40 @@ PacketQueue::Enqueue (QueueEntry & entry)
 {
   NS_LOG_FUNCTION ("Enqueing packet destined for" << entry.GetIpv4Header ().GetDestination ());
   Purge ();
-  uint32_t numPacketswithdst;
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  if (m_uids.count (GetKey (entry)) > 0)
     {
-      if ((i->GetPacket ()->GetUid () == entry.GetPacket ()->GetUid ())
-          && (i->GetIpv4Header ().GetDestination ()
-              == entry.GetIpv4Header ().GetDestination ()))
-        {
-          return false;
-        }
+      Drop (entry, DROP_DUPLICATE);
+      return false;
     }
-  numPacketswithdst = GetCountForPacketsWithDst (entry.GetIpv4Header ().GetDestination ());
-  NS_LOG_DEBUG ("Number of packets with this destination: " << numPacketswithdst);
+  uint32_t bytes = GetEntrySize (entry);
+  DropReason reason;
   /** For Brock Paper comparision*/
-  if (numPacketswithdst >= m_maxLenPerDst || m_queue.size () >= m_maxLen)
+  if (!MakeRoom (entry.GetIpv4Header ().GetDestination (), bytes, reason))
     {
-      NS_LOG_DEBUG ("Max packets reached for this destination. Not queuing any further packets");
+      NS_LOG_DEBUG ("Max packets or bytes reached for this destination. Not queuing any further packets");
+      Drop (entry, reason);
       return false;
     }
+  // NS_LOG_DEBUG("Packet size while enqueing "<<entry.GetPacket()->GetSize());
+  entry.SetExpireTime (m_queueTimeout);
+  PushBack (entry, bytes);
+  ++m_stats.enqueued;
+  m_stats.highWater = std::max (m_stats.highWater, m_size);
+  m_stats.highWaterBytes = std::max (m_stats.highWaterBytes, m_bytes);
+  if (m_expiries.size () > 4 * m_size + 64)
+    {
+      // mostly deadlines of packets that already left the queue
+      RescheduleExpiries ();
+    }
   else
     {
-      // NS_LOG_DEBUG("Packet size while enqueing "<<entry.GetPacket()->GetSize());
-      entry.SetExpireTime (m_queueTimeout);
-      m_queue.push_back (entry);
-      return true;
+      Expiry expiry;
+      expiry.deadline = entry.GetExpireDeadline ();
+      expiry.dst = entry.GetIpv4Header ().GetDestination ();
+      m_expiries.push_back (expiry);
+      std::push_heap (m_expiries.begin (), m_expiries.end (), std::greater<Expiry> ());
     }
+  return true;
 }
 
 void
@@ -76,16 +84,16 @@ PacketQueue::DropPacketWithDst (Ipv4Address dst)
 {
   NS_LOG_FUNCTION ("Dropping packet to " << dst);
   Purge ();
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  AddressMap<Bucket>::iterator bucket = m_buckets.find (dst);
+  if (bucket == m_buckets.end ())
     {
-      if (IsEqual (*i, dst))
-        {
-          Drop (*i, "DropPacketWithDst ");
-        }
+      return;
+    }
+  do
+    {
+      Drop (m_slots[bucket->second.front].entry, DROP_FLUSHED);
     }
-  m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (),
-                                 std::bind2nd (std::ptr_fun (PacketQueue::IsEqual), dst)), m_queue.end ());
+  while (PopFront (bucket));
 }
 
 bool
@@ -93,29 +101,47 @@ PacketQueue::Dequeue (Ipv4Address dst, QueueEntry & entry)
 {
   NS_LOG_FUNCTION ("Dequeueing packet destined for" << dst);
   Purge ();
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+  AddressMap<Bucket>::iterator bucket = m_buckets.find (dst);
+  if (bucket == m_buckets.end ())
+    {
+      return false;
+    }
+  if (m_policy == SOJOURN)
     {
-      if (i->GetIpv4Header ().GetDestination () == dst)
+      // stale packets are worth less than a drop
+      while (IsSojournExceeded (bucket->second.front))
         {
-          entry = *i;
-          m_queue.erase (i);
-          return true;
+          Drop (m_slots[bucket->second.front].entry, DROP_SOJOURN);
+          if (!PopFront (bucket))
+            {
+              return false;
+            }
         }
     }
-  return false;
+  entry = m_slots[bucket->second.front].entry;
+  Time sojourn = Simulator::Now () - m_slots[bucket->second.front].enqueued;
+  PopFront (bucket);
+  ++m_stats.dequeued;
+  uint32_t bin = 0;
+  while (bin + 1 < SOJOURN_BINS && sojourn >= GetSojournBinLimit (bin))
+    {
+      ++bin;
+    }
+  ++m_stats.sojourn[bin];
+  if (!m_dequeueCallback.IsNull ())
+    {
+      m_dequeueCallback (entry.GetPacket (), entry.GetIpv4Header (), sojourn);
+    }
+  return true;
 }
 
 bool
 PacketQueue::Find (Ipv4Address dst)
 {
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  if (m_buckets.find (dst) != m_buckets.end ())
     {
-      if (i->GetIpv4Header ().GetDestination () == dst)
-        {
-          NS_LOG_DEBUG ("Find");
-          return true;
-        }
+      NS_LOG_DEBUG ("Find");
+      return true;
     }
   return false;
 }
@@ -123,61 +149,329 @@ PacketQueue::Find (Ipv4Address dst)
 uint32_t
 PacketQueue::GetCountForPacketsWithDst (Ipv4Address dst)
 {
-  uint32_t count = 0;
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  AddressMap<Bucket>::const_iterator bucket = m_buckets.find (dst);
+  if (bucket == m_buckets.end ())
+    {
+      return 0;
+    }
+  return bucket->second.size;
+}
+
+bool
+PacketQueue::Fits (Ipv4Address dst, uint32_t bytes, DropReason & reason)
+{
+  uint32_t numPacketswithdst = GetCountForPacketsWithDst (dst);
+  NS_LOG_DEBUG ("Number of packets with this destination: " << numPacketswithdst);
+  if (numPacketswithdst >= m_maxLenPerDst)
+    {
+      reason = DROP_DESTINATION_LIMIT;
+      return false;
+    }
+  if (m_size >= m_maxLen)
+    {
+      reason = DROP_QUEUE_LIMIT;
+      return false;
+    }
+  if (m_maxBytes != 0 && m_bytes + bytes > m_maxBytes)
+    {
+      reason = DROP_BYTE_LIMIT;
+      return false;
+    }
+  return true;
+}
+
+bool
+PacketQueue::MakeRoom (Ipv4Address dst, uint32_t bytes, DropReason & reason)
+{
+  if (m_maxLenPerDst == 0 || m_maxLen == 0 || (m_maxBytes != 0 && bytes > m_maxBytes))
+    {
+      // would not fit into an empty queue either
+      reason = m_maxLenPerDst == 0 ? DROP_DESTINATION_LIMIT : m_maxLen == 0 ? DROP_QUEUE_LIMIT : DROP_BYTE_LIMIT;
+      return false;
+    }
+  while (!Fits (dst, bytes, reason))
     {
-      if (i->GetIpv4Header ().GetDestination () == dst)
+      Ipv4Address victim;
+      switch (m_policy)
         {
-          count++;
+        case DROP_TAIL:
+          return false;
+        case DROP_OLDEST:
+          if (GetCountForPacketsWithDst (dst) >= m_maxLenPerDst)
+            {
+              victim = dst;
+            }
+          else if (!FindOldest (victim))
+            {
+              return false;
+            }
+          break;
+        case FAIR_SHARE:
+          if (GetCountForPacketsWithDst (dst) >= m_maxLenPerDst)
+            {
+              victim = dst;
+            }
+          else
+            {
+              // take from the longest bucket, unless that would make it shorter than ours
+              uint32_t longest = GetCountForPacketsWithDst (dst) + 1;
+              for (AddressMap<Bucket>::const_iterator i = m_buckets.begin (); i != m_buckets.end (); ++i)
+                {
+                  if (i->second.size > longest)
+                    {
+                      longest = i->second.size;
+                      victim = i->first;
+                    }
+                }
+              if (longest == GetCountForPacketsWithDst (dst) + 1)
+                {
+                  return false;
+                }
+            }
+          break;
+        case SOJOURN:
+          if (GetCountForPacketsWithDst (dst) >= m_maxLenPerDst)
+            {
+              // only a packet of our own destination makes room in its bucket
+              victim = dst;
+            }
+          else if (!FindOldest (victim))
+            {
+              return false;
+            }
+          if (!IsSojournExceeded (m_buckets.find (victim)->second.front))
+            {
+              return false;
+            }
+          break;
+        }
+      if (!DropFront (victim, m_policy == SOJOURN ? DROP_SOJOURN : DROP_EVICTED))
+        {
+          return false;
         }
     }
-  return count;
+  return true;
 }
 
-/**
- * IsExpired structure
- */
-struct IsExpired
-{
-  /**
-   * \brief Check for expired entry
-   * \param e QueueEntry to check
-   * \return true if expired
-   */
-  bool
-  operator() (QueueEntry const & e) const
-  {
-    // NS_LOG_DEBUG("Expire time for packet in req queue: "<<e.GetExpireTime ());
-    return (e.GetExpireTime () < Seconds (0));
-  }
-};
+bool
+PacketQueue::DropFront (Ipv4Address dst, DropReason reason)
+{
+  AddressMap<Bucket>::iterator bucket = m_buckets.find (dst);
+  if (bucket == m_buckets.end ())
+    {
+      return false;
+    }
+  Drop (m_slots[bucket->second.front].entry, reason);
+  PopFront (bucket);
+  return true;
+}
+
+bool
+PacketQueue::FindOldest (Ipv4Address & dst)
+{
+  // the first deadline still belonging to the front of its bucket is the oldest packet
+  while (!m_expiries.empty ())
+    {
+      AddressMap<Bucket>::const_iterator i = m_buckets.find (m_expiries.front ().dst);
+      if (i != m_buckets.end () && m_slots[i->second.front].entry.GetExpireDeadline () == m_expiries.front ().deadline)
+        {
+          dst = i->first;
+          return true;
+        }
+      std::pop_heap (m_expiries.begin (), m_expiries.end (), std::greater<Expiry> ());
+      m_expiries.pop_back ();
+    }
+  return false;
+}
+
+void
+PacketQueue::PushBack (QueueEntry const & entry, uint32_t bytes)
+{
+  uint32_t slot = m_freeSlots;
+  if (slot == NO_SLOT)
+    {
+      slot = m_slots.size ();
+      m_slots.push_back (Slot ());
+    }
+  else
+    {
+      m_freeSlots = m_slots[slot].next;
+    }
+  m_slots[slot].entry = entry;
+  m_slots[slot].enqueued = Simulator::Now ();
+  m_slots[slot].bytes = bytes;
+  m_slots[slot].next = NO_SLOT;
+  Bucket & bucket = m_buckets[entry.GetIpv4Header ().GetDestination ()];
+  if (bucket.size == 0)
+    {
+      bucket.front = slot;
+    }
+  else
+    {
+      m_slots[bucket.back].next = slot;
+    }
+  bucket.back = slot;
+  ++bucket.size;
+  m_uids.insert (GetKey (entry));
+  ++m_size;
+  m_bytes += bytes;
+}
+
+bool
+PacketQueue::PopFront (AddressMap<Bucket>::iterator bucket)
+{
+  uint32_t slot = bucket->second.front;
+  m_uids.erase (GetKey (m_slots[slot].entry));
+  --m_size;
+  m_bytes -= m_slots[slot].bytes;
+  bucket->second.front = m_slots[slot].next;
+  // release the packet and the callbacks, keep the slot
+  m_slots[slot].entry = QueueEntry ();
+  m_slots[slot].next = m_freeSlots;
+  m_freeSlots = slot;
+  if (--bucket->second.size == 0)
+    {
+      m_buckets.erase (bucket);
+      return false;
+    }
+  return true;
+}
 
 void
 PacketQueue::Purge ()
 {
   // NS_LOG_DEBUG("Purging Queue");
-  IsExpired pred;
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  if (m_expiries.empty ())
+    {
+      return;
+    }
+  Time now = Simulator::Now ();
+  while (!m_expiries.empty () && m_expiries.front ().deadline < now)
     {
-      if (pred (*i))
+      Ipv4Address dst = m_expiries.front ().dst;
+      std::pop_heap (m_expiries.begin (), m_expiries.end (), std::greater<Expiry> ());
+      m_expiries.pop_back ();
+      AddressMap<Bucket>::iterator i = m_buckets.find (dst);
+      if (i == m_buckets.end ())
+        {
+          continue;
+        }
+      // every packet gets the same timeout, so a bucket expires from its front
+      while (m_slots[i->second.front].entry.GetExpireDeadline () < now)
         {
           NS_LOG_DEBUG ("Dropping outdated Packets");
-          Drop (*i, "Drop outdated packet ");
+          Drop (m_slots[i->second.front].entry, DROP_TIMEOUT);
+          if (!PopFront (i))
+            {
+              break;
+            }
         }
     }
-  m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (), pred),
-                 m_queue.end ());
 }
 
 void
-PacketQueue::Drop (QueueEntry en, std::string reason)
+PacketQueue::RescheduleExpiries ()
 {
-  NS_LOG_LOGIC (reason << en.GetPacket ()->GetUid () << " " << en.GetIpv4Header ().GetDestination ());
+  m_expiries.clear ();
+  for (AddressMap<Bucket>::const_iterator i = m_buckets.begin (); i != m_buckets.end (); ++i)
+    {
+      for (uint32_t slot = i->second.front; slot != NO_SLOT; slot = m_slots[slot].next)
+        {
+          Expiry expiry;
+          expiry.deadline = m_slots[slot].entry.GetExpireDeadline ();
+          expiry.dst = i->first;
+          m_expiries.push_back (expiry);
+        }
+    }
+  std::make_heap (m_expiries.begin (), m_expiries.end (), std::greater<Expiry> ());
+}
+
+void
+PacketQueue::Drop (QueueEntry const & en, DropReason reason)
+{
+  NS_LOG_LOGIC (GetDropReasonName (reason) << " " << en.GetPacket ()->GetUid () << " " << en.GetIpv4Header ().GetDestination ());
   // en.GetErrorCallback () (en.GetPacket (), en.GetIpv4Header (),
   //   Socket::ERROR_NOROUTETOHOST);
-  return;
+  ++m_stats.drops[reason];
+  if (!m_dropCallback.IsNull ())
+    {
+      m_dropCallback (en.GetPacket (), en.GetIpv4Header (), reason);
+    }
+}
+
+void
+PacketQueue::ResetStats ()
+{
+  m_stats = Stats ();
+  m_stats.highWater = m_size;
+  m_stats.highWaterBytes = m_bytes;
+}
+
+std::string
+PacketQueue::GetDropReasonName (DropReason reason)
+{
+  switch (reason)
+    {
+    case DROP_TIMEOUT:
+      return "Timeout";
+    case DROP_DUPLICATE:
+      return "Duplicate";
+    case DROP_DESTINATION_LIMIT:
+      return "DestinationLimit";
+    case DROP_QUEUE_LIMIT:
+      return "QueueLimit";
+    case DROP_BYTE_LIMIT:
+      return "ByteLimit";
+    case DROP_EVICTED:
+      return "Evicted";
+    case DROP_SOJOURN:
+      return "Sojourn";
+    case DROP_FLUSHED:
+      return "Flushed";
+    default:
+      return "Unknown";
+    }
+}
+
+Time
+PacketQueue::GetSojournBinLimit (uint32_t bin)
+{
+  return MilliSeconds (static_cast<uint64_t> (1) << bin);
+}
+
+PacketQueue::Stats::Stats ()
+  : enqueued (0),
+    dequeued (0),
+    highWater (0),
+    highWaterBytes (0)
+{
+  std::fill (drops, drops + DROP_REASONS, 0);
+  std::fill (sojourn, sojourn + SOJOURN_BINS, 0);
+}
+
+void
+PacketQueue::Stats::Print (std::ostream &os) const
+{
+  os << "Enqueued " << enqueued << ", dequeued " << dequeued << ", high-water mark " << highWater
+     << " packets / " << highWaterBytes << " bytes\n";
+  os << "Drops:";
+  for (uint32_t i = 0; i < DROP_REASONS; ++i)
+    {
+      os << " " << GetDropReasonName (static_cast<DropReason> (i)) << " " << drops[i];
+    }
+  os << "\nSojourn times:";
+  for (uint32_t i = 0; i < SOJOURN_BINS; ++i)
+    {
+      if (i + 1 < SOJOURN_BINS)
+        {
+          os << " <" << GetSojournBinLimit (i).GetMilliSeconds () << "ms " << sojourn[i];
+        }
+      else
+        {
+          os << " more " << sojourn[i];
+        }
+    }
+  os << "\n";
 }
 
 }
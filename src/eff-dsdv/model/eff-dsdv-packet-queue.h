@@ -23,9 +23,12 @@
 #ifndef EFF_DSDV_PACKETQUEUE_H
 #define EFF_DSDV_PACKETQUEUE_H
 
+#include <functional>
 #include <vector>
+#include <unordered_set>
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/simulator.h"
+#include "eff-dsdv-address-map.h"
 
 namespace ns3 {
 namespace effdsdv {
@@ -150,6 +153,14 @@ public:
   {
     return m_expire - Simulator::Now ();
   }
+  /**
+   * Get the absolute time the entry expires at
+   * \returns the expiry deadline
+   */
+  Time GetExpireDeadline () const
+  {
+    return m_expire;
+  }
 
 private:
   /// Data packet
@@ -170,12 +181,83 @@ private:
  * When a route is not available, the packets are queued. Every node can buffer up to 5 packets per
  * destination. We have implemented a "drop front on full" queue where the first queued packet will be dropped
  * to accommodate newer packets.
+ *
+ * Packets are kept in one FIFO bucket per destination, so enqueueing, dequeueing and the per
+ * destination queries do not depend on the number of packets buffered for other destinations.
+ * Duplicates are detected through a hash set of (packet UID, destination) pairs.
+ *
+ * Besides the packet counts, admission is limited by a byte budget covering the packets and
+ * their IPv4 headers. Entries live in a pool of slots that is reused once a packet leaves the
+ * queue; a bucket is a list threaded through the pool.
+ *
+ * What happens to a packet that does not fit is decided by the drop policy, see DropPolicy.
  */
 class PacketQueue
 {
 public:
+  /// What to drop when a packet does not fit into the queue
+  enum DropPolicy
+  {
+    DROP_TAIL,   //!< reject the new packet
+    DROP_OLDEST, //!< drop the oldest packet of the destination, or of the whole queue if that is full
+    FAIR_SHARE,  //!< like DROP_OLDEST, but a full queue gives way only to destinations with fewer packets than the longest one
+    SOJOURN      //!< drop packets queued for longer than the sojourn target, when dequeued or to make room
+  };
+  /// Why a packet left the queue, or was not admitted, without being sent
+  enum DropReason
+  {
+    DROP_TIMEOUT,           //!< queued for longer than the queue timeout
+    DROP_DUPLICATE,         //!< the packet is already queued for the destination
+    DROP_DESTINATION_LIMIT, //!< too many packets queued for the destination
+    DROP_QUEUE_LIMIT,       //!< too many packets queued
+    DROP_BYTE_LIMIT,        //!< the byte budget is exhausted
+    DROP_EVICTED,           //!< dropped by the drop policy to make room for a newer packet
+    DROP_SOJOURN,           //!< queued for longer than the sojourn target
+    DROP_FLUSHED,           //!< all packets to the destination were dropped
+    DROP_REASONS            //!< number of drop reasons
+  };
+  /// Number of bins of the sojourn time histogram
+  static const uint32_t SOJOURN_BINS = 18;
+  /// Counters of the queue
+  struct Stats
+  {
+    /// c-tor, all counters zero
+    Stats ();
+    /**
+     * Print the counters
+     * \param os the output stream
+     */
+    void Print (std::ostream &os) const;
+    uint32_t drops[DROP_REASONS];     ///< drops by reason
+    uint32_t enqueued;                ///< packets admitted to the queue
+    uint32_t dequeued;                ///< packets handed out for sending
+    uint32_t highWater;               ///< largest number of packets queued at once
+    uint32_t highWaterBytes;          ///< largest number of bytes queued at once
+    uint32_t sojourn[SOJOURN_BINS];   ///< sojourn time of the dequeued packets, see GetSojournBinLimit
+  };
+  /// Callback invoked for every dropped packet
+  typedef Callback<void, Ptr<const Packet>, Ipv4Header const &, DropReason> DropCallback;
+  /// Callback invoked for every dequeued packet, with the time it was queued for
+  typedef Callback<void, Ptr<const Packet>, Ipv4Header const &, Time> DequeueCallback;
+  /**
+   * \param reason the drop reason
+   * \returns the name of the drop reason
+   */
+  static std::string GetDropReasonName (DropReason reason);
+  /**
+   * Bin 0 counts sojourn times below 1 ms, bin i times from 2^(i-1) up to 2^i ms and the
+   * last bin everything above.
+   * \param bin the bin of the sojourn time histogram
+   * \returns the exclusive upper limit of the bin
+   */
+  static Time GetSojournBinLimit (uint32_t bin);
   /// Default c-tor
   PacketQueue ()
+    : m_freeSlots (NO_SLOT),
+      m_size (0),
+      m_bytes (0),
+      m_maxBytes (0),
+      m_policy (DROP_TAIL)
   {
   }
   /**
@@ -215,6 +297,22 @@ public:
    * \returns the number of entries
    */
   uint32_t GetSize ();
+  /**
+   * Get the number of destinations with queued packets
+   * \returns the number of destinations
+   */
+  uint32_t GetDestinationCount () const
+  {
+    return m_buckets.size ();
+  }
+  /**
+   * Get the number of bytes held by the queued packets
+   * \returns the number of bytes
+   */
+  uint32_t GetBytes () const
+  {
+    return m_bytes;
+  }
 
   // Fields
   /**
@@ -249,6 +347,22 @@ public:
   {
     m_maxLenPerDst = len;
   }
+  /**
+   * Get the byte budget
+   * \returns the maximum number of bytes buffered, 0 if unlimited
+   */
+  uint32_t GetMaxQueueBytes () const
+  {
+    return m_maxBytes;
+  }
+  /**
+   * Set the byte budget
+   * \param bytes the maximum number of bytes buffered, 0 for no limit
+   */
+  void SetMaxQueueBytes (uint32_t bytes)
+  {
+    m_maxBytes = bytes;
+  }
   /**
    * Get queue timeout
    * \returns the queue timeout
@@ -265,33 +379,238 @@ public:
   {
     m_queueTimeout = t;
   }
+  /**
+   * Get the counters
+   * \returns the counters since the queue was created or the counters were reset
+   */
+  Stats const & GetStats () const
+  {
+    return m_stats;
+  }
+  /// Reset all counters, the high-water marks start over from the current occupancy
+  void ResetStats ();
+  /**
+   * Set the callback invoked for every dropped packet
+   * \param cb the callback
+   */
+  void SetDropCallback (DropCallback cb)
+  {
+    m_dropCallback = cb;
+  }
+  /**
+   * Set the callback invoked for every dequeued packet
+   * \param cb the callback
+   */
+  void SetDequeueCallback (DequeueCallback cb)
+  {
+    m_dequeueCallback = cb;
+  }
+  /**
+   * Get the drop policy
+   * \returns the drop policy
+   */
+  DropPolicy GetDropPolicy () const
+  {
+    return m_policy;
+  }
+  /**
+   * Set the drop policy
+   * \param policy the drop policy
+   */
+  void SetDropPolicy (DropPolicy policy)
+  {
+    m_policy = policy;
+  }
+  /**
+   * Get the sojourn target of the SOJOURN policy
+   * \returns the longest time a packet may be queued before it is dropped
+   */
+  Time GetSojournTarget () const
+  {
+    return m_sojournTarget;
+  }
+  /**
+   * Set the sojourn target of the SOJOURN policy
+   * \param target the longest time a packet may be queued before it is dropped
+   */
+  void SetSojournTarget (Time target)
+  {
+    m_sojournTarget = target;
+  }
 
 private:
-  std::vector<QueueEntry> m_queue; ///< the queue
-  /// Remove all expired entries
+  /// Marks the end of a slot list
+  static const uint32_t NO_SLOT = 0xffffffff;
+  /// Pooled storage of one queue entry
+  struct Slot
+  {
+    QueueEntry entry; ///< the queued packet
+    Time enqueued;    ///< time the packet was queued at
+    uint32_t bytes;   ///< bytes charged to the budget for it
+    uint32_t next;    ///< next slot of the same bucket or of the free list
+  };
+  /// Packets queued for one destination, oldest first
+  struct Bucket
+  {
+    Bucket ()
+      : front (NO_SLOT),
+        back (NO_SLOT),
+        size (0)
+    {
+    }
+    uint32_t front; ///< slot of the oldest packet
+    uint32_t back;  ///< slot of the newest packet
+    uint32_t size;  ///< number of packets
+  };
+  /// Key of the duplicate detection set
+  struct UidKey
+  {
+    uint64_t uid;    ///< packet UID
+    uint32_t dst;    ///< destination address
+    /**
+     * \param o the other key
+     * \returns true if equal
+     */
+    bool operator== (UidKey const & o) const
+    {
+      return uid == o.uid && dst == o.dst;
+    }
+  };
+  /// Hash function of UidKey
+  struct UidKeyHash
+  {
+    /**
+     * \param k the key
+     * \returns the hash value
+     */
+    std::size_t operator() (UidKey const & k) const
+    {
+      return std::hash<uint64_t> () (k.uid ^ (static_cast<uint64_t> (k.dst) << 32));
+    }
+  };
+  /**
+   * \param entry the queue entry
+   * \returns the duplicate detection key of the entry
+   */
+  static UidKey GetKey (QueueEntry const & entry)
+  {
+    UidKey key;
+    key.uid = entry.GetPacket ()->GetUid ();
+    key.dst = entry.GetIpv4Header ().GetDestination ().Get ();
+    return key;
+  }
+  /// Expiry deadline of a queued packet
+  struct Expiry
+  {
+    Time deadline;   ///< the packet expires once this time has passed
+    Ipv4Address dst; ///< destination of the packet
+    /**
+     * \param o the other expiry
+     * \returns true if this one is due later, used to build a min-heap
+     */
+    bool operator> (Expiry const & o) const
+    {
+      return deadline > o.deadline;
+    }
+  };
+  /// Rebuild m_expiries from the queued packets
+  void RescheduleExpiries ();
+  /**
+   * \param entry the queue entry
+   * \returns the number of bytes charged to the budget for the entry
+   */
+  static uint32_t GetEntrySize (QueueEntry const & entry)
+  {
+    return entry.GetPacket ()->GetSize () + entry.GetIpv4Header ().GetSerializedSize ();
+  }
+  /**
+   * Append an entry to the bucket of its destination
+   * \param entry the queue entry
+   * \param bytes bytes charged to the budget for it
+   */
+  void PushBack (QueueEntry const & entry, uint32_t bytes);
+  /**
+   * Remove the oldest entry of a bucket
+   * \param bucket the bucket, erased from m_buckets once empty
+   * \returns true if the bucket still holds packets
+   */
+  bool PopFront (AddressMap<Bucket>::iterator bucket);
+  /**
+   * \param dst the destination of the new packet
+   * \param bytes bytes charged to the budget for it
+   * \param reason set to the limit the packet exceeds
+   * \returns true if the packet fits without dropping anything
+   */
+  bool Fits (Ipv4Address dst, uint32_t bytes, DropReason & reason);
+  /**
+   * Drop queued packets according to the drop policy until a new packet fits
+   * \param dst the destination of the new packet
+   * \param bytes bytes charged to the budget for it
+   * \param reason set to the limit the packet exceeds if it does not fit
+   * \returns true if the packet fits
+   */
+  bool MakeRoom (Ipv4Address dst, uint32_t bytes, DropReason & reason);
+  /**
+   * Drop the oldest packet of a destination
+   * \param dst the destination
+   * \param reason the reason for the packet drop
+   * \returns false if no packet is queued for the destination
+   */
+  bool DropFront (Ipv4Address dst, DropReason reason);
+  /**
+   * Find the destination of the oldest packet in the queue
+   * \param dst set to the destination
+   * \returns false if the queue is empty
+   */
+  bool FindOldest (Ipv4Address & dst);
+  /**
+   * \param slot a slot holding a queued packet
+   * \returns true if the packet stayed longer than the sojourn target
+   */
+  bool IsSojournExceeded (uint32_t slot) const
+  {
+    return Simulator::Now () - m_slots[slot].enqueued > m_sojournTarget;
+  }
+  /// destination -> its queued packets, only destinations with packets are present
+  AddressMap<Bucket> m_buckets;
+  /// the slot pool, grows up to the largest number of packets queued at once
+  std::vector<Slot> m_slots;
+  /// first unused slot of the pool
+  uint32_t m_freeSlots;
+  /// (packet UID, destination) of every queued packet
+  std::unordered_set<UidKey, UidKeyHash> m_uids;
+  /// number of queued packets
+  uint32_t m_size;
+  /// bytes held by the queued packets
+  uint32_t m_bytes;
+  /// min-heap of packet deadlines; deadlines of packets dequeued or dropped meanwhile are simply dropped
+  std::vector<Expiry> m_expiries;
+  /// Remove all expired entries, visiting only the destinations with a due deadline
   void Purge ();
   /**
-   * Notify that the packet is dropped from queue due to timeout
+   * Notify that the packet is dropped from queue, or not admitted to it
    * \param en the queue entry
    * \param reason the reason for the packet drop
    */
-  void Drop (QueueEntry en, std::string reason);
+  void Drop (QueueEntry const & en, DropReason reason);
   /// The maximum number of packets that we allow a routing protocol to buffer.
   uint32_t m_maxLen;
   /// The maximum number of packets that we allow per destination to buffer.
   uint32_t m_maxLenPerDst;
+  /// The maximum number of bytes that we allow a routing protocol to buffer, 0 if unlimited.
+  uint32_t m_maxBytes;
   /// The maximum period of time that a routing protocol is allowed to buffer a packet for, seconds.
   Time m_queueTimeout;
-  /**
-   * Determine if queue entries are equal
-   * \param en the queue entry
-   * \param dst the IPv4 destination address
-   * \returns true if the entry is for the destination address
-   */
-  static bool IsEqual (QueueEntry en, const Ipv4Address dst)
-  {
-    return (en.GetIpv4Header ().GetDestination () == dst);
-  }
+  /// What to drop when a packet does not fit
+  DropPolicy m_policy;
+  /// The longest time a packet may be queued under the SOJOURN policy
+  Time m_sojournTarget;
+  /// the counters
+  Stats m_stats;
+  /// invoked for every dropped packet
+  DropCallback m_dropCallback;
+  /// invoked for every dequeued packet
+  DequeueCallback m_dequeueCallback;
 };
 }
 }
@@ -22,6 +22,8 @@
 #include "eff-dsdv-packet.h"
 #include "ns3/address-utils.h"
 #include "ns3/packet.h"
+#include <algorithm>
+#include <limits>
 
 namespace ns3 {
 namespace effdsdv {
@@ -74,6 +76,9 @@ TypeHeader::Deserialize (Buffer::Iterator start)
     case DSDVTYPE_DSDV:
     case DSDVTYPE_RREQ:
     case DSDVTYPE_RACK:
+    case DSDVTYPE_BULK:
+    case DSDVTYPE_BULK_RREQ:
+    case DSDVTYPE_BULK_RACK:
       {
         m_type = (MessageType) type;
         break;
@@ -106,6 +111,21 @@ TypeHeader::Print (std::ostream &os) const
         os << "RACK";
         break;
       }
+    case DSDVTYPE_BULK:
+      {
+        os << "BULK";
+        break;
+      }
+    case DSDVTYPE_BULK_RREQ:
+      {
+        os << "BULK_RREQ";
+        break;
+      }
+    case DSDVTYPE_BULK_RACK:
+      {
+        os << "BULK_RACK";
+        break;
+      }
     default:
       os << "UNKNOWN_TYPE";
     }
@@ -200,13 +220,187 @@ DsdvHeader::Print (std::ostream &os) const
      << " SequenceNumber: " << m_dstSeqNo;
 }
 //-----------------------------------------------------------------------------
+// DSDV batch
+//-----------------------------------------------------------------------------
+NS_OBJECT_ENSURE_REGISTERED (DsdvBatchHeader);
+
+DsdvBatchHeader::DsdvBatchHeader ()
+{
+}
+
+DsdvBatchHeader::~DsdvBatchHeader ()
+{
+}
+
+TypeId
+DsdvBatchHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::effdsdv::DsdvBatchHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("EffDsdv")
+    .AddConstructor<DsdvBatchHeader> ();
+  return tid;
+}
+
+TypeId
+DsdvBatchHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+DsdvBatchHeader::GetSerializedSize () const
+{
+  return PAIR_SIZE * m_entries.size ();
+}
+
+void
+DsdvBatchHeader::Serialize (Buffer::Iterator i) const
+{
+  for (std::vector<DsdvHeader>::const_iterator j = m_entries.begin (); j != m_entries.end (); ++j)
+    {
+      // same layout as TypeHeader followed by DsdvHeader
+      i.WriteU16 ((uint16_t) DSDVTYPE_DSDV);
+      WriteTo (i, j->GetDst ());
+      i.WriteHtonU16 (j->GetHopCount ());
+      i.WriteHtonU32 (j->GetDstSeqno ());
+    }
+}
+
+uint32_t
+DsdvBatchHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_entries.clear ();
+  while (i.GetRemainingSize () >= PAIR_SIZE)
+    {
+      Buffer::Iterator pair = i;
+      if (i.ReadU16 () != DSDVTYPE_DSDV)
+        {
+          i = pair;
+          break;
+        }
+      Ipv4Address dst;
+      ReadFrom (i, dst);
+      uint16_t hopCount = i.ReadNtohU16 ();
+      uint32_t dstSeqNo = i.ReadNtohU32 ();
+      m_entries.push_back (DsdvHeader (dst, hopCount, dstSeqNo));
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+std::ostream &
+operator<< (std::ostream & os, DsdvBatchHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+void
+DsdvBatchHeader::Print (std::ostream &os) const
+{
+  os << "Entries: " << m_entries.size ();
+  for (std::vector<DsdvHeader>::const_iterator j = m_entries.begin (); j != m_entries.end (); ++j)
+    {
+      os << " [" << *j << "]";
+    }
+}
+//-----------------------------------------------------------------------------
+// BULK
+//-----------------------------------------------------------------------------
+NS_OBJECT_ENSURE_REGISTERED (BulkDsdvHeader);
+
+BulkDsdvHeader::BulkDsdvHeader ()
+{
+}
+
+BulkDsdvHeader::~BulkDsdvHeader ()
+{
+}
+
+TypeId
+BulkDsdvHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::effdsdv::BulkDsdvHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("EffDsdv")
+    .AddConstructor<BulkDsdvHeader> ();
+  return tid;
+}
+
+TypeId
+BulkDsdvHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+BulkDsdvHeader::GetSerializedSize () const
+{
+  return COUNT_SIZE + ENTRY_SIZE * m_entries.size ();
+}
+
+void
+BulkDsdvHeader::Serialize (Buffer::Iterator i) const
+{
+  NS_ASSERT (m_entries.size () <= 0xffff);
+  i.WriteHtonU16 (m_entries.size ());
+  for (std::vector<DsdvHeader>::const_iterator j = m_entries.begin (); j != m_entries.end (); ++j)
+    {
+      WriteTo (i, j->GetDst ());
+      i.WriteU8 (std::min<uint16_t> (j->GetHopCount (), 0xff));
+      i.WriteHtonU32 (j->GetDstSeqno ());
+    }
+}
+
+uint32_t
+BulkDsdvHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint16_t count = i.ReadNtohU16 ();
+  m_entries.clear ();
+  m_entries.reserve (count);
+  for (uint16_t n = 0; n < count; ++n)
+    {
+      Ipv4Address dst;
+      ReadFrom (i, dst);
+      uint8_t hopCount = i.ReadU8 ();
+      uint32_t dstSeqNo = i.ReadNtohU32 ();
+      m_entries.push_back (DsdvHeader (dst, hopCount, dstSeqNo));
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+std::ostream &
+operator<< (std::ostream & os, BulkDsdvHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+void
+BulkDsdvHeader::Print (std::ostream &os) const
+{
+  os << "Entries: " << m_entries.size ();
+  for (std::vector<DsdvHeader>::const_iterator j = m_entries.begin (); j != m_entries.end (); ++j)
+    {
+      os << " [" << *j << "]";
+    }
+}
+//-----------------------------------------------------------------------------
 // RREQ
 //-----------------------------------------------------------------------------
 NS_OBJECT_ENSURE_REGISTERED (RreqHeader);
 
-RreqHeader::RreqHeader (Ipv4Address dst, uint8_t reserved)
+RreqHeader::RreqHeader (Ipv4Address dst, uint16_t requestId)
   : m_dst (dst),
-	m_reserved (reserved)
+	m_requestId (requestId)
 {
 }
 
@@ -240,7 +434,7 @@ void
 RreqHeader::Serialize (Buffer::Iterator i) const
 {
   WriteTo (i, m_dst);
-  i.WriteU16 (m_reserved);
+  i.WriteHtonU16 (m_requestId);
 }
 
 uint32_t
@@ -248,7 +442,7 @@ RreqHeader::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
   ReadFrom (i, m_dst);
-  m_reserved = i.ReadU16 ();
+  m_requestId = i.ReadNtohU16 ();
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
   return dist;
@@ -263,7 +457,7 @@ operator<< (std::ostream & os, RreqHeader const & h)
 void
 RreqHeader::Print (std::ostream &os) const
 {
-  os << "DestinationIpv4: " << m_dst;
+  os << "DestinationIpv4: " << m_dst << " RequestId: " << m_requestId;
 }
 //-----------------------------------------------------------------------------
 // RACK
@@ -340,5 +534,366 @@ RackHeader::Print (std::ostream &os) const
      << " UpdateTime: " << m_updateTime;
 }
 
+//-----------------------------------------------------------------------------
+// BULK RREQ
+//-----------------------------------------------------------------------------
+NS_OBJECT_ENSURE_REGISTERED (BulkRreqHeader);
+
+BulkRreqHeader::BulkRreqHeader (uint16_t requestId)
+  : m_requestId (requestId)
+{
+}
+
+BulkRreqHeader::~BulkRreqHeader ()
+{
+}
+
+TypeId
+BulkRreqHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::effdsdv::BulkRreqHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("EffDsdv")
+    .AddConstructor<BulkRreqHeader> ();
+  return tid;
+}
+
+TypeId
+BulkRreqHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+BulkRreqHeader::GetSerializedSize () const
+{
+  return FIXED_SIZE + ENTRY_SIZE * m_dsts.size ();
+}
+
+void
+BulkRreqHeader::Serialize (Buffer::Iterator i) const
+{
+  NS_ASSERT (m_dsts.size () <= 0xffff);
+  i.WriteHtonU16 (m_requestId);
+  i.WriteHtonU16 (m_dsts.size ());
+  for (std::vector<Ipv4Address>::const_iterator j = m_dsts.begin (); j != m_dsts.end (); ++j)
+    {
+      WriteTo (i, *j);
+    }
+}
+
+uint32_t
+BulkRreqHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_requestId = i.ReadNtohU16 ();
+  uint16_t count = i.ReadNtohU16 ();
+  m_dsts.clear ();
+  m_dsts.reserve (count);
+  for (uint16_t n = 0; n < count; ++n)
+    {
+      Ipv4Address dst;
+      ReadFrom (i, dst);
+      m_dsts.push_back (dst);
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+std::ostream &
+operator<< (std::ostream & os, BulkRreqHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+void
+BulkRreqHeader::Print (std::ostream &os) const
+{
+  os << "RequestId: " << m_requestId << " Destinations:";
+  for (std::vector<Ipv4Address>::const_iterator j = m_dsts.begin (); j != m_dsts.end (); ++j)
+    {
+      os << " " << *j;
+    }
+}
+//-----------------------------------------------------------------------------
+// BULK RACK
+//-----------------------------------------------------------------------------
+NS_OBJECT_ENSURE_REGISTERED (BulkRackHeader);
+
+BulkRackHeader::BulkRackHeader ()
+{
+}
+
+BulkRackHeader::~BulkRackHeader ()
+{
+}
+
+TypeId
+BulkRackHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::effdsdv::BulkRackHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("EffDsdv")
+    .AddConstructor<BulkRackHeader> ();
+  return tid;
+}
+
+TypeId
+BulkRackHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+BulkRackHeader::GetSerializedSize () const
+{
+  return COUNT_SIZE + ENTRY_SIZE * m_entries.size ();
+}
+
+void
+BulkRackHeader::Serialize (Buffer::Iterator i) const
+{
+  NS_ASSERT (m_entries.size () <= 0xffff);
+  i.WriteHtonU16 (m_entries.size ());
+  for (std::vector<RackHeader>::const_iterator j = m_entries.begin (); j != m_entries.end (); ++j)
+    {
+      WriteTo (i, j->GetDst ());
+      i.WriteHtonU16 (j->GetHopCount ());
+      i.WriteHtonU32 (j->GetUpdateTime ().GetMilliSeconds ());
+    }
+}
+
+uint32_t
+BulkRackHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint16_t count = i.ReadNtohU16 ();
+  m_entries.clear ();
+  m_entries.reserve (count);
+  for (uint16_t n = 0; n < count; ++n)
+    {
+      Ipv4Address dst;
+      ReadFrom (i, dst);
+      uint16_t hopCount = i.ReadNtohU16 ();
+      uint32_t updateTime = i.ReadNtohU32 ();
+      m_entries.push_back (RackHeader (dst, hopCount, MilliSeconds (updateTime)));
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+std::ostream &
+operator<< (std::ostream & os, BulkRackHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+void
+BulkRackHeader::Print (std::ostream &os) const
+{
+  os << "Entries: " << m_entries.size ();
+  for (std::vector<RackHeader>::const_iterator j = m_entries.begin (); j != m_entries.end (); ++j)
+    {
+      os << " [" << *j << "]";
+    }
+}
+//-----------------------------------------------------------------------------
+// Parser
+//-----------------------------------------------------------------------------
+NS_OBJECT_ENSURE_REGISTERED (ControlPacketParser);
+
+ControlPacketParser::ControlPacketParser ()
+  : m_size (0),
+    m_complete (true)
+{
+}
+
+ControlPacketParser::~ControlPacketParser ()
+{
+}
+
+TypeId
+ControlPacketParser::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::effdsdv::ControlPacketParser")
+    .SetParent<Header> ()
+    .SetGroupName ("EffDsdv")
+    .AddConstructor<ControlPacketParser> ();
+  return tid;
+}
+
+TypeId
+ControlPacketParser::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+ControlPacketParser::GetSerializedSize () const
+{
+  return m_size;
+}
+
+void
+ControlPacketParser::Serialize (Buffer::Iterator) const
+{
+  NS_FATAL_ERROR ("ControlPacketParser can not serialize");
+}
+
+void
+ControlPacketParser::Add (MessageType type, Ipv4Address dst, uint16_t hopCount, uint32_t value)
+{
+  Message m;
+  m.type = type;
+  m.dst = dst;
+  m.hopCount = hopCount;
+  m.value = value;
+  m_messages.push_back (m);
+}
+
+uint32_t
+ControlPacketParser::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_messages.clear ();
+  m_complete = true;
+  // sizes of the messages behind the type header
+  const uint32_t typeSize = 2, dsdvSize = 10, rreqSize = 6, rackSize = 10;
+  while (!i.IsEnd ())
+    {
+      if (i.GetRemainingSize () < typeSize)
+        {
+          m_complete = false;
+          break;
+        }
+      Buffer::Iterator message = i;
+      uint16_t type = i.ReadU16 ();
+      uint32_t needed;
+      switch (type)
+        {
+        case DSDVTYPE_DSDV:
+          needed = dsdvSize;
+          break;
+        case DSDVTYPE_RREQ:
+          needed = rreqSize;
+          break;
+        case DSDVTYPE_RACK:
+          needed = rackSize;
+          break;
+        case DSDVTYPE_BULK:
+          {
+            Buffer::Iterator count = i;
+            needed = BulkDsdvHeader::COUNT_SIZE;
+            if (i.GetRemainingSize () >= needed)
+              {
+                needed += count.ReadNtohU16 () * BulkDsdvHeader::ENTRY_SIZE;
+              }
+            break;
+          }
+        case DSDVTYPE_BULK_RREQ:
+          {
+            Buffer::Iterator count = i;
+            needed = BulkRreqHeader::FIXED_SIZE;
+            if (i.GetRemainingSize () >= needed)
+              {
+                count.ReadNtohU16 ();
+                needed += count.ReadNtohU16 () * BulkRreqHeader::ENTRY_SIZE;
+              }
+            break;
+          }
+        case DSDVTYPE_BULK_RACK:
+          {
+            Buffer::Iterator count = i;
+            needed = BulkRackHeader::COUNT_SIZE;
+            if (i.GetRemainingSize () >= needed)
+              {
+                needed += count.ReadNtohU16 () * BulkRackHeader::ENTRY_SIZE;
+              }
+            break;
+          }
+        default:
+          needed = std::numeric_limits<uint32_t>::max ();
+        }
+      if (i.GetRemainingSize () < needed)
+        {
+          // unknown type or truncated message
+          i = message;
+          m_complete = false;
+          break;
+        }
+      Ipv4Address dst;
+      switch (type)
+        {
+        case DSDVTYPE_DSDV:
+          {
+            ReadFrom (i, dst);
+            uint16_t hopCount = i.ReadNtohU16 ();
+            Add (DSDVTYPE_DSDV, dst, hopCount, i.ReadNtohU32 ());
+            break;
+          }
+        case DSDVTYPE_BULK:
+          {
+            uint16_t count = i.ReadNtohU16 ();
+            for (uint16_t n = 0; n < count; ++n)
+              {
+                ReadFrom (i, dst);
+                uint8_t hopCount = i.ReadU8 ();
+                Add (DSDVTYPE_DSDV, dst, hopCount, i.ReadNtohU32 ());
+              }
+            break;
+          }
+        case DSDVTYPE_RREQ:
+          {
+            ReadFrom (i, dst);
+            Add (DSDVTYPE_RREQ, dst, 0, i.ReadNtohU16 ());
+            break;
+          }
+        case DSDVTYPE_RACK:
+          {
+            ReadFrom (i, dst);
+            uint16_t hopCount = i.ReadNtohU16 ();
+            Add (DSDVTYPE_RACK, dst, hopCount, i.ReadNtohU32 ());
+            break;
+          }
+        case DSDVTYPE_BULK_RREQ:
+          {
+            uint16_t requestId = i.ReadNtohU16 ();
+            uint16_t count = i.ReadNtohU16 ();
+            for (uint16_t n = 0; n < count; ++n)
+              {
+                ReadFrom (i, dst);
+                Add (DSDVTYPE_RREQ, dst, 0, requestId);
+              }
+            break;
+          }
+        case DSDVTYPE_BULK_RACK:
+          {
+            uint16_t count = i.ReadNtohU16 ();
+            for (uint16_t n = 0; n < count; ++n)
+              {
+                ReadFrom (i, dst);
+                uint16_t hopCount = i.ReadNtohU16 ();
+                Add (DSDVTYPE_RACK, dst, hopCount, i.ReadNtohU32 ());
+              }
+            break;
+          }
+        }
+    }
+  m_size = i.GetDistanceFrom (start);
+  return m_size;
+}
+
+void
+ControlPacketParser::Print (std::ostream &os) const
+{
+  os << "Messages: " << m_messages.size () << (m_complete ? "" : " (truncated)");
+}
+
 }
 }
@@ -24,6 +24,7 @@
 #define EFFDSDV_PACKET_H
 
 #include <iostream>
+#include <vector>
 #include "ns3/header.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/nstime.h"
@@ -41,7 +42,9 @@ enum MessageType
   DSDVTYPE_DSDV  = 1,   //!< AODVTYPE_DSDV
   DSDVTYPE_RREQ  = 2,   //!< AODVTYPE_RREP
   DSDVTYPE_RACK  = 3,   //!< AODVTYPE_RERR
-  	  	  	  	  	  	 //!< 4 = Undefined
+  DSDVTYPE_BULK  = 4,   //!< Several DSDV entries behind one type header
+  DSDVTYPE_BULK_RREQ = 5, //!< Route request for several destinations
+  DSDVTYPE_BULK_RACK = 6, //!< Several RACK entries behind one type header
 };
 
 /**
@@ -206,6 +209,164 @@ private:
 */
 std::ostream & operator<< (std::ostream & os, DsdvHeader const &);
 
+/**
+ * \ingroup effdsdv
+ * \brief A run of (TypeHeader, DsdvHeader) pairs serialized in one go.
+ *
+ * Produces the same bytes as adding a TypeHeader (DSDVTYPE_DSDV) and a DsdvHeader
+ * per route to a packet, so receivers see ordinary DSDV messages, but grows the
+ * packet buffer only once. Entries are written in the order they were added.
+ */
+class DsdvBatchHeader : public Header
+{
+public:
+  /// Constructor
+  DsdvBatchHeader ();
+  virtual ~DsdvBatchHeader ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  /// Reads DSDV messages until the data ends or another message type follows
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /// Serialized size of one type header and DSDV header pair
+  static const uint32_t PAIR_SIZE = 12;
+
+  /**
+   * Append an entry
+   * \param entry destination, hop count and sequence number to advertise
+   */
+  void
+  AddEntry (DsdvHeader const & entry)
+  {
+    m_entries.push_back (entry);
+  }
+  /**
+   * Get the entries
+   * \returns the entries in wire order
+   */
+  std::vector<DsdvHeader> const &
+  GetEntries () const
+  {
+    return m_entries;
+  }
+  /**
+   * Get the number of entries
+   * \returns the number of entries
+   */
+  uint32_t
+  GetEntryCount () const
+  {
+    return m_entries.size ();
+  }
+  /// Remove all entries
+  void
+  Clear ()
+  {
+    m_entries.clear ();
+  }
+private:
+  std::vector<DsdvHeader> m_entries; ///< Advertised routes
+};
+/**
+* \brief Stream output operator
+* \param os output stream
+* \return updated stream
+*/
+std::ostream & operator<< (std::ostream & os, DsdvBatchHeader const &);
+
+/**
+ * \ingroup effdsdv
+ * \brief EFFDSDV_BULK Update Packet Format.
+ *
+ * Carries the entries of a whole update behind a single type header. Hop
+ * counts are packed into one byte, so each entry takes 9 instead of 12 bytes.
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |              TYPE             |          Entry Count          |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                      Destination Address                      |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |   HopCount    |         Sequence Number ----------------------
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   ----------    |    next entry ...
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * \endverbatim
+ */
+
+class BulkDsdvHeader : public Header
+{
+public:
+  /// Constructor
+  BulkDsdvHeader ();
+  virtual ~BulkDsdvHeader ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /// Serialized size of the entry count
+  static const uint32_t COUNT_SIZE = 2;
+  /// Serialized size of one entry
+  static const uint32_t ENTRY_SIZE = 9;
+
+  /**
+   * Append an entry. Hop counts above 255 are sent as 255.
+   * \param entry destination, hop count and sequence number to advertise
+   */
+  void
+  AddEntry (DsdvHeader const & entry)
+  {
+    m_entries.push_back (entry);
+  }
+  /**
+   * Get the entries
+   * \returns the entries in the order they were added
+   */
+  std::vector<DsdvHeader> const &
+  GetEntries () const
+  {
+    return m_entries;
+  }
+  /**
+   * Get the number of entries
+   * \returns the number of entries
+   */
+  uint32_t
+  GetEntryCount () const
+  {
+    return m_entries.size ();
+  }
+  /// Remove all entries
+  void
+  Clear ()
+  {
+    m_entries.clear ();
+  }
+private:
+  std::vector<DsdvHeader> m_entries; ///< Advertised routes
+};
+/**
+* \brief Stream output operator
+* \param os output stream
+* \return updated stream
+*/
+std::ostream & operator<< (std::ostream & os, BulkDsdvHeader const &);
+
 /**
  * \ingroup effdsdv
  * \brief EFFDSDV_RREQ Update Packet Format.
@@ -215,9 +376,12 @@ std::ostream & operator<< (std::ostream & os, DsdvHeader const &);
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  |      TYPE                     |               Destination Add-
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  ress                           |            Reserved           |
+  ress                           |          Request ID           |
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  * \endverbatim
+ *
+ * The request ID takes the place of the former reserved field. Together with the
+ * address of the sender it identifies a request, so receivers can drop duplicates.
  */
 
 class RreqHeader : public Header
@@ -226,10 +390,10 @@ public:
   /**
    * Constructor
    *
-   * \param type packet type (Rreq)
    * \param dst destination IP address
+   * \param requestId the request ID
    */
-	RreqHeader (Ipv4Address dst = Ipv4Address (), uint8_t reserved = 0);
+	RreqHeader (Ipv4Address dst = Ipv4Address (), uint16_t requestId = 0);
   virtual ~RreqHeader ();
   /**
    * \brief Get the type ID.
@@ -260,10 +424,28 @@ public:
   {
     return m_dst;
   }
+  /**
+   * Set the request ID
+   * \param id the request ID
+   */
+  void
+  SetRequestId (uint16_t id)
+  {
+    m_requestId = id;
+  }
+  /**
+   * Get the request ID
+   * \returns the request ID
+   */
+  uint16_t
+  GetRequestId () const
+  {
+    return m_requestId;
+  }
 
 private:
   Ipv4Address m_dst; ///< Destination IP Address
-  uint8_t     m_reserved;       ///< Not used (must be 0)
+  uint16_t    m_requestId;      ///< Request ID, unique per sender
 };
 /**
 * \brief Stream output operator
@@ -376,6 +558,300 @@ private:
 */
 std::ostream & operator<< (std::ostream & os, RackHeader const &);
 
+/**
+ * \ingroup effdsdv
+ * \brief EFFDSDV_BULK_RREQ Packet Format.
+ *
+ * Asks the neighbors for routes to several destinations at once. All
+ * destinations share one request ID.
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |              TYPE             |          Request ID           |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |          Entry Count          |        Destination Add-
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  ress                           |    next destination ...
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * \endverbatim
+ */
+
+class BulkRreqHeader : public Header
+{
+public:
+  /**
+   * Constructor
+   * \param requestId the request ID
+   */
+  BulkRreqHeader (uint16_t requestId = 0);
+  virtual ~BulkRreqHeader ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /// Serialized size of the request ID and the entry count
+  static const uint32_t FIXED_SIZE = 4;
+  /// Serialized size of one destination
+  static const uint32_t ENTRY_SIZE = 4;
+
+  /**
+   * Set the request ID
+   * \param id the request ID
+   */
+  void
+  SetRequestId (uint16_t id)
+  {
+    m_requestId = id;
+  }
+  /**
+   * Get the request ID
+   * \returns the request ID
+   */
+  uint16_t
+  GetRequestId () const
+  {
+    return m_requestId;
+  }
+  /**
+   * Append a destination
+   * \param dst the destination a route is asked for
+   */
+  void
+  AddDst (Ipv4Address dst)
+  {
+    m_dsts.push_back (dst);
+  }
+  /**
+   * Get the destinations
+   * \returns the destinations in the order they were added
+   */
+  std::vector<Ipv4Address> const &
+  GetDsts () const
+  {
+    return m_dsts;
+  }
+  /**
+   * Get the number of destinations
+   * \returns the number of destinations
+   */
+  uint32_t
+  GetEntryCount () const
+  {
+    return m_dsts.size ();
+  }
+  /// Remove all destinations
+  void
+  Clear ()
+  {
+    m_dsts.clear ();
+  }
+private:
+  uint16_t m_requestId;            ///< Request ID, unique per sender
+  std::vector<Ipv4Address> m_dsts; ///< Requested destinations
+};
+/**
+* \brief Stream output operator
+* \param os output stream
+* \return updated stream
+*/
+std::ostream & operator<< (std::ostream & os, BulkRreqHeader const &);
+
+/**
+ * \ingroup effdsdv
+ * \brief EFFDSDV_BULK_RACK Packet Format.
+ *
+ * Answers route requests for several destinations at once, each entry laid
+ * out like a RACK message.
+ * \verbatim
+ |      0        |      1        |      2        |       3       |
+  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |              TYPE             |          Entry Count          |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                      Destination Address                      |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |            HopCount           |         UPDATE TIME ----------
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   ----------                    |    next entry ...
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * \endverbatim
+ */
+
+class BulkRackHeader : public Header
+{
+public:
+  /// Constructor
+  BulkRackHeader ();
+  virtual ~BulkRackHeader ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /// Serialized size of the entry count
+  static const uint32_t COUNT_SIZE = 2;
+  /// Serialized size of one entry
+  static const uint32_t ENTRY_SIZE = 10;
+
+  /**
+   * Append an entry
+   * \param entry destination, hop count and update time to acknowledge
+   */
+  void
+  AddEntry (RackHeader const & entry)
+  {
+    m_entries.push_back (entry);
+  }
+  /**
+   * Get the entries
+   * \returns the entries in the order they were added
+   */
+  std::vector<RackHeader> const &
+  GetEntries () const
+  {
+    return m_entries;
+  }
+  /**
+   * Get the number of entries
+   * \returns the number of entries
+   */
+  uint32_t
+  GetEntryCount () const
+  {
+    return m_entries.size ();
+  }
+  /// Remove all entries
+  void
+  Clear ()
+  {
+    m_entries.clear ();
+  }
+private:
+  std::vector<RackHeader> m_entries; ///< Acknowledged routes
+};
+/**
+* \brief Stream output operator
+* \param os output stream
+* \return updated stream
+*/
+std::ostream & operator<< (std::ostream & os, BulkRackHeader const &);
+
+/**
+ * \ingroup effdsdv
+ * \brief Decodes all messages of an Eff-DSDV control packet in one pass.
+ *
+ * Used with Packet::PeekHeader, which hands Deserialize an iterator over the
+ * whole packet without copying it. Every record is checked against the bytes
+ * left before it is read. Decoding stops at the first unknown or truncated
+ * message; the messages before it are kept. The message vector keeps its
+ * capacity between packets, so a parser reused for every received packet
+ * does not allocate once it has grown.
+ */
+class ControlPacketParser : public Header
+{
+public:
+  /// One decoded message
+  struct Message
+  {
+    MessageType type; ///< DSDVTYPE_DSDV, DSDVTYPE_RREQ or DSDVTYPE_RACK, for bulk messages one per entry
+    Ipv4Address dst; ///< Destination IP Address
+    uint16_t hopCount; ///< Number of Hops, DSDV and RACK only
+    uint32_t value; ///< Sequence number (DSDV) or update time in milliseconds (RACK) or request ID (RREQ)
+  };
+
+  /// Constructor
+  ControlPacketParser ();
+  virtual ~ControlPacketParser ();
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  /// \returns the number of bytes decoded by the last Deserialize
+  virtual uint32_t GetSerializedSize () const;
+  /// Not supported, the parser only reads
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /**
+   * Get the decoded messages
+   * \returns the messages in packet order
+   */
+  std::vector<Message> const &
+  GetMessages () const
+  {
+    return m_messages;
+  }
+  /**
+   * Check whether the whole packet was decoded
+   * \returns false if decoding stopped at an unknown or truncated message
+   */
+  bool
+  IsComplete () const
+  {
+    return m_complete;
+  }
+  /**
+   * Get the update entries as DSDV header
+   * \param m a message of type DSDVTYPE_DSDV
+   * \returns the header
+   */
+  static DsdvHeader
+  GetDsdvHeader (Message const & m)
+  {
+    return DsdvHeader (m.dst, m.hopCount, m.value);
+  }
+  /**
+   * Get a route request as RREQ header
+   * \param m a message of type DSDVTYPE_RREQ
+   * \returns the header
+   */
+  static RreqHeader
+  GetRreqHeader (Message const & m)
+  {
+    return RreqHeader (m.dst, m.value);
+  }
+  /**
+   * Get a route ack as RACK header
+   * \param m a message of type DSDVTYPE_RACK
+   * \returns the header
+   */
+  static RackHeader
+  GetRackHeader (Message const & m)
+  {
+    return RackHeader (m.dst, m.hopCount, MilliSeconds (m.value));
+  }
+private:
+  /**
+   * Append a decoded message
+   * \param type the message type
+   * \param dst the destination
+   * \param hopCount the hop count
+   * \param value the sequence number or update time
+   */
+  void Add (MessageType type, Ipv4Address dst, uint16_t hopCount, uint32_t value);
+
+  std::vector<Message> m_messages; ///< Decoded messages, reused between packets
+  uint32_t m_size; ///< Bytes decoded
+  bool m_complete; ///< Whether the whole packet was decoded
+};
+
 }
 }
 
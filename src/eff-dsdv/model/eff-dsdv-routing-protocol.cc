@@ -29,7 +29,9 @@
 #include "ns3/boolean.h"
 #include "ns3/double.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
 #include "ns3/dsdv-rtable.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -116,6 +118,12 @@ RoutingProtocol::GetTypeId (void)
                    TimeValue (Seconds (15)),
                    MakeTimeAccessor (&RoutingProtocol::m_periodicUpdateInterval),
                    MakeTimeChecker ())
+    .AddAttribute ("FullDumpInterval","Every how many periodic updates the full routing table is sent. "
+                   "The periodic updates in between only carry routes whose sequence number or metric changed "
+                   "since they were last advertised.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&RoutingProtocol::m_fullDumpInterval),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("SettlingTime", "Minimum time an update is to be stored in adv table before sending out"
                    "in case of change in metric (in seconds)",
                    TimeValue (Seconds (5)),
@@ -129,6 +137,22 @@ RoutingProtocol::GetTypeId (void)
                    UintegerValue (5),
                    MakeUintegerAccessor (&RoutingProtocol::m_maxQueuedPacketsPerDst),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxQueueBytes", "Maximum number of bytes, packets and IPv4 headers, that we allow a routing "
+                   "protocol to buffer. 0 disables the limit.",
+                   UintegerValue (1 << 20),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxQueueBytes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("QueueDropPolicy", "What to drop when a packet does not fit into the buffer.",
+                   EnumValue (PacketQueue::DROP_TAIL),
+                   MakeEnumAccessor (&RoutingProtocol::m_queueDropPolicy),
+                   MakeEnumChecker (PacketQueue::DROP_TAIL, "DropTail",
+                                    PacketQueue::DROP_OLDEST, "DropOldest",
+                                    PacketQueue::FAIR_SHARE, "FairShare",
+                                    PacketQueue::SOJOURN, "Sojourn"))
+    .AddAttribute ("QueueSojournTarget", "Longest time a packet may be buffered under the Sojourn drop policy.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_queueSojournTarget),
+                   MakeTimeChecker ())
     .AddAttribute ("MaxQueueTime","Maximum time packets can be queued (in seconds)",
                    TimeValue (Seconds (30)),
                    MakeTimeAccessor (&RoutingProtocol::m_maxQueueTime),
@@ -138,6 +162,14 @@ RoutingProtocol::GetTypeId (void)
                    MakeBooleanAccessor (&RoutingProtocol::SetEnableBufferFlag,
                                         &RoutingProtocol::GetEnableBufferFlag),
                    MakeBooleanChecker ())
+    .AddAttribute ("QueueDrainBurst","Number of buffered packets sent at once when a route to their destination becomes available",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&RoutingProtocol::m_queueDrainBurst),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("QueueDrainGap","Time between two bursts of buffered packets to the same destination",
+                   TimeValue (MilliSeconds (50)),
+                   MakeTimeAccessor (&RoutingProtocol::m_queueDrainGap),
+                   MakeTimeChecker ())
     .AddAttribute ("EnableWST","Enables Weighted Settling Time for the updates before advertising",
                    BooleanValue (true),
                    MakeBooleanAccessor (&RoutingProtocol::SetWSTFlag,
@@ -156,10 +188,72 @@ RoutingProtocol::GetTypeId (void)
                    MakeBooleanAccessor (&RoutingProtocol::SetEnableRAFlag,
                                         &RoutingProtocol::GetEnableRAFlag),
                    MakeBooleanChecker ())
+    .AddAttribute ("TriggerMinInterval","Minimum time between two triggered updates on an interface. "
+                   "Changes arriving in between are merged into one update.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&RoutingProtocol::m_triggerMinInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("TriggerRate","Bytes per second of triggered updates an interface may send on average, 0 for no limit",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RoutingProtocol::m_triggerRate),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("TriggerBurst","Bytes of triggered updates an interface may send at once when TriggerRate is set",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&RoutingProtocol::m_triggerBurst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RreqRetryInterval","Time before a route request for the same destination may be repeated. "
+                   "Doubles with every further request, up to RreqRetryMaxInterval.",
+                   TimeValue (MilliSeconds (500)),
+                   MakeTimeAccessor (&RoutingProtocol::m_rreqRetryInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("RreqRetryMaxInterval","Upper bound of the time between two route requests for the same destination",
+                   TimeValue (Seconds (8)),
+                   MakeTimeAccessor (&RoutingProtocol::m_rreqRetryMaxInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("RreqIdLifetime","Time a received route request is remembered to recognize duplicates",
+                   TimeValue (Seconds (3)),
+                   MakeTimeAccessor (&RoutingProtocol::m_rreqIdLifetime),
+                   MakeTimeChecker ())
+    .AddAttribute ("RreqBatchWindow","Time route requests are collected and then sent as a single request",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&RoutingProtocol::m_rreqBatchWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("RackBatchWindow","Time route acks for the same requester are collected and then sent as a single packet",
+                   TimeValue (MilliSeconds (5)),
+                   MakeTimeAccessor (&RoutingProtocol::m_rackBatchWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("AlternativeRoutes","Number of alternative routes kept per destination to fail over to",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxAlternatives),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("UpdateSpreadWindow","Time over which the packets of an update too large for one packet are spread",
+                   TimeValue (MilliSeconds (20)),
+                   MakeTimeAccessor (&RoutingProtocol::m_updateSpreadWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("EnableBulkUpdates","Sends all entries of an update behind a single header instead of one DSDV message per route. "
+                   "Nodes that do not know the bulk format cannot parse these updates.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableBulkUpdates),
+                   MakeBooleanChecker ())
     .AddAttribute ("RouteAggregationTime","Time to aggregate updates before sending them out (in seconds)",
                    TimeValue (Seconds (1)),
                    MakeTimeAccessor (&RoutingProtocol::m_routeAggregationTime),
-                   MakeTimeChecker ());
+                   MakeTimeChecker ())
+    .AddTraceSource ("DirtyEntries", "Number of settled changes carried by a triggered update.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_dirtyEntriesTrace),
+                     "ns3::effdsdv::RoutingProtocol::DirtyEntriesTracedCallback")
+    .AddTraceSource ("TriggerSuppressed", "A triggered update was merged into a pending one or held back.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_triggerSuppressedTrace),
+                     "ns3::effdsdv::RoutingProtocol::TriggerSuppressedTracedCallback")
+    .AddTraceSource ("UpdateSplit", "An update was sent on an interface, split into MTU-sized packets.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_updateSplitTrace),
+                     "ns3::effdsdv::RoutingProtocol::UpdateSplitTracedCallback")
+    .AddTraceSource ("QueueDrop", "A packet was dropped from the buffer.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_queueDropTrace),
+                     "ns3::effdsdv::RoutingProtocol::QueueDropTracedCallback")
+    .AddTraceSource ("QueueDequeue", "A buffered packet was sent on its new route.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_queueDequeueTrace),
+                     "ns3::effdsdv::RoutingProtocol::QueueDequeueTracedCallback");
   return tid;
 }
 
@@ -194,6 +288,18 @@ RoutingProtocol::GetEnableRAFlag () const
   return EnableRouteAggregation;
 }
 
+PacketQueue::Stats const &
+RoutingProtocol::GetQueueStats () const
+{
+  return m_queue.GetStats ();
+}
+
+ForwardingTable const &
+RoutingProtocol::GetForwardingTable () const
+{
+  return m_fib;
+}
+
 int64_t
 RoutingProtocol::AssignStreams (int64_t stream)
 {
@@ -203,12 +309,20 @@ RoutingProtocol::AssignStreams (int64_t stream)
 }
 
 RoutingProtocol::RoutingProtocol ()
-  : m_routingTable (),
-    m_advRoutingTable (),
+  : m_periodicUpdates (0),
+    m_routingTable (),
+    m_advRoutingTable (m_routingTable.GetStore (), RouteStore::ADVERTISED),
+    m_altRoutingTable (m_routingTable.GetStore (), RouteStore::ALTERNATIVE),
     m_queue (),
+    m_fragmentsAvoided (0),
+    m_suppressedRequests (0),
+    m_duplicateRequests (0),
+    m_requestId (0),
+    m_alternativeFailovers (0),
     m_periodicUpdateTimer (Timer::CANCEL_ON_DESTROY)
 {
   m_uniformRandomVariable = CreateObject<UniformRandomVariable> ();
+  std::fill (m_suppressedTriggers, m_suppressedTriggers + TriggerDamper::SUPPRESS_REASONS, 0);
 }
 
 RoutingProtocol::~RoutingProtocol ()
@@ -225,6 +339,29 @@ RoutingProtocol::DoDispose ()
       iter->first->Close ();
     }
   m_socketAddresses.clear ();
+  m_neighborRoutes.Clear ();
+  m_lastHeard.clear ();
+  m_settlingScheduler.Clear ();
+  m_rreqBackoff.Clear ();
+  m_rreqIdCache.Clear ();
+  m_requestBatchEvent.Cancel ();
+  m_requestBatch.clear ();
+  m_ackBatchEvent.Cancel ();
+  m_ackBatch.clear ();
+  m_altRoutes.Clear ();
+  m_fib.Clear ();
+  for (AddressMap<EventId>::iterator i = m_queueDrains.begin (); i != m_queueDrains.end (); ++i)
+    {
+      i->second.Cancel ();
+    }
+  m_queueDrains.clear ();
+  m_lastAdvertised.clear ();
+  m_triggeredUpdateEvent.Cancel ();
+  for (std::map<Ptr<Socket>, Ptr<TriggerDamper> >::iterator i = m_triggerDampers.begin (); i != m_triggerDampers.end (); ++i)
+    {
+      i->second->Clear ();
+    }
+  m_triggerDampers.clear ();
   Ipv4RoutingProtocol::DoDispose ();
 }
 
@@ -251,11 +388,25 @@ RoutingProtocol::Start ()
 {
   m_queue.SetMaxPacketsPerDst (m_maxQueuedPacketsPerDst);
   m_queue.SetMaxQueueLen (m_maxQueueLen);
+  m_queue.SetMaxQueueBytes (m_maxQueueBytes);
+  m_queue.SetDropPolicy (m_queueDropPolicy);
+  m_queue.SetSojournTarget (m_queueSojournTarget);
   m_queue.SetQueueTimeout (m_maxQueueTime);
+  m_queue.SetDropCallback (MakeCallback (&TracedCallback<Ptr<const Packet>, Ipv4Header const &, PacketQueue::DropReason>::operator(),
+                                         &m_queueDropTrace));
+  m_queue.SetDequeueCallback (MakeCallback (&TracedCallback<Ptr<const Packet>, Ipv4Header const &, Time>::operator(),
+                                            &m_queueDequeueTrace));
   m_routingTable.Setholddowntime (Time (Holdtimes * m_periodicUpdateInterval));
   m_advRoutingTable.Setholddowntime (Time (Holdtimes * m_periodicUpdateInterval));
   m_scb = MakeCallback (&RoutingProtocol::Send,this);
   m_ecb = MakeCallback (&RoutingProtocol::Drop,this);
+  m_settlingScheduler.SetCallback (MakeCallback (&RoutingProtocol::SendTriggeredUpdate,this));
+  m_rreqBackoff.SetInterval (m_rreqRetryInterval, m_rreqRetryMaxInterval);
+  m_rreqIdCache.SetLifetime (m_rreqIdLifetime);
+  m_altRoutes.SetMaxCandidates (m_maxAlternatives);
+  m_routingTable.SetRouteInstalledCallback (MakeCallback (&RoutingProtocol::RouteInstalled,this));
+  m_routingTable.SetRouteChangedCallback (MakeCallback (&RoutingProtocol::MainRouteChanged,this));
+  m_altRoutingTable.SetRouteInstalledCallback (MakeCallback (&RoutingProtocol::RouteInstalled,this));
   m_periodicUpdateTimer.SetFunction (&RoutingProtocol::SendPeriodicUpdate,this);
   m_periodicUpdateTimer.Schedule (MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)));
   //m_periodicUpdateTimer.Schedule (Seconds (m_uniformRandomVariable->GetInteger (0,10)));
@@ -280,13 +431,25 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p,
       Ptr<Ipv4Route> route;
       return route;
     }
-  std::map<Ipv4Address, RoutingTableEntry> removedAddresses;
-  std::map<Ipv4Address, RoutingTableEntry> invalidatedAddresses;
   sockerr = Socket::ERROR_NOTERROR;
   Ptr<Ipv4Route> route;
   Ipv4Address dst = header.GetDestination ();
   NS_LOG_DEBUG (m_mainAddress << ": Outgoing -> Packet Size: " << p->GetSize ()
                                 << ", Packet id: " << p->GetUid () << ", Destination address in Packet: " << dst);
+  // a forwarding table entry never outlives the routes it was resolved from
+  route = m_fib.Lookup (dst);
+  if (route)
+    {
+      if (oif != 0 && route->GetOutputDevice () != oif)
+        {
+          NS_LOG_DEBUG (m_mainAddress << ": Output device doesn't match. Dropped.");
+          sockerr = Socket::ERROR_NOROUTETOHOST;
+          return Ptr<Ipv4Route> ();
+        }
+      return route;
+    }
+  std::map<Ipv4Address, RoutingTableEntry> removedAddresses;
+  std::map<Ipv4Address, RoutingTableEntry> invalidatedAddresses;
   m_routingTable.Purge (removedAddresses, invalidatedAddresses);
   if (!removedAddresses.empty ())
     {
@@ -297,34 +460,17 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p,
 	      rmItr->second.SetSeqNo (rmItr->second.GetSeqNo () + 1);
 	      m_advRoutingTable.AddRoute (rmItr->second);
 	    }
-      Simulator::Schedule (MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)),&RoutingProtocol::SendTriggeredUpdate,this);
+      ScheduleTriggeredUpdate (MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)));
     }
-  if(!invalidatedAddresses.empty())
-  {
-//	  NS_LOG_DEBUG (m_mainAddress <<": For the recently invalidated...");
-//	  for (std::map<Ipv4Address, RoutingTableEntry>::iterator invItr = invalidatedAddresses.begin ();
-//	  	       invItr != invalidatedAddresses.end (); ++invItr)
-//	  {
-//		  NS_LOG_DEBUG (m_mainAddress <<": ..."<<invItr->first<<", subsequent routes using this one get invalidated too");
-//		  if (invItr -> second.GetDestination() != invItr -> second.GetNextHop())
-//		  {
-//			  //InvalidateOverNextHop(invItr -> second.GetNextHop());
-//		  }
-//	  }
-
-  }
   RoutingTableEntry rt;
   if (LookupRoute(dst,rt))
   //if (m_routingTable.LookupRoute(dst,rt))
     {
-      if (EnableBuffering)
-        {
-          LookForQueuedPackets ();
-        }
       if (rt.GetHop () == 1)
         {
-          route = rt.GetRoute ();
+          route = GetNeighborRoute (rt);
           NS_ASSERT (route != 0);
+          InstallForwardingRoute (dst, route);
           NS_LOG_DEBUG (m_mainAddress << ": A route exists from " << route->GetSource ()
                                                << " to neighboring destination "
                                                << route->GetDestination ());
@@ -342,8 +488,9 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p,
           //if (m_routingTable.LookupRoute (rt.GetNextHop (),newrt))
           if(LookupRoute(rt.GetNextHop(),newrt))
             {
-              route = newrt.GetRoute ();
+              route = GetNeighborRoute (newrt);
               NS_ASSERT (route != 0);
+              InstallForwardingRoute (dst, route);
               NS_LOG_DEBUG (m_mainAddress << ": A route exists from " << route->GetSource ()
                                                    << " to destination " << dst << " via "
                                                    << rt.GetNextHop ());
@@ -471,7 +618,7 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p,
                   //if (m_routingTable.LookupRoute (dst,toBroadcast,true)) //TODO:lookup
                   if (LookupRoute(dst,toBroadcast,true))
                     {
-                      Ptr<Ipv4Route> route = toBroadcast.GetRoute ();
+                      Ptr<Ipv4Route> route = GetNeighborRoute (toBroadcast);
                       ucb (route,packet,header);
                     }
                   else
@@ -511,6 +658,15 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p,
       return true;
     }
 
+  Ptr<Ipv4Route> cached = m_fib.Lookup (dst);
+  if (cached)
+    {
+      NS_LOG_LOGIC (m_mainAddress << ": is forwarding packet " << p->GetUid ()
+                                  << " to " << dst
+                                  << " via cached nexthop neighbor " << cached->GetGateway ());
+      ucb (cached,p,header);
+      return true;
+    }
   RoutingTableEntry toDst;
   //if (m_routingTable.LookupRoute (dst,toDst))
   if (LookupRoute(dst,toDst))
@@ -519,7 +675,8 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p,
      // if (m_routingTable.LookupRoute (toDst.GetNextHop (),ne))
       if (LookupRoute (toDst.GetNextHop(),ne))
         {
-          Ptr<Ipv4Route> route = ne.GetRoute ();
+          Ptr<Ipv4Route> route = GetNeighborRoute (ne);
+          InstallForwardingRoute (dst, route);
           NS_LOG_LOGIC (m_mainAddress << ": is forwarding packet " << p->GetUid ()
                                       << " to " << dst
                                       << " from " << header.GetSource ()
@@ -533,6 +690,12 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p,
   return false;
 }
 
+Ptr<Ipv4Route>
+RoutingProtocol::GetNeighborRoute (RoutingTableEntry const & rt)
+{
+  return m_neighborRoutes.GetRoute (rt.GetNextHop (), rt.GetOutputDevice (), rt.GetInterface ().GetLocal ());
+}
+
 Ptr<Ipv4Route>
 RoutingProtocol::LoopbackRoute (const Ipv4Header & hdr, Ptr<NetDevice> oif) const
 {
@@ -586,7 +749,6 @@ RoutingProtocol::RecvEffDsdv (Ptr<Socket> socket)
 {
 	 NS_LOG_FUNCTION (this << socket);
 	 Address sourceAddress;
-	  Ptr<Packet> advpacket = Create<Packet> ();
 	  Ptr<Packet> packet = socket->RecvFrom (sourceAddress);
 	  InetSocketAddress inetSourceAddr = InetSocketAddress::ConvertFrom (sourceAddress);
 	  Ipv4Address sender = inetSourceAddr.GetIpv4 ();
@@ -596,93 +758,77 @@ RoutingProtocol::RecvEffDsdv (Ptr<Socket> socket)
 	                                 << " and packet id: " << packet->GetUid ());
 	  NS_LOG_DEBUG (m_mainAddress << ": received Eff-DSDV packet of size: " << packetSize
 		                                 << " and packet id: " << packet->GetUid ());
- /*
-  NS_LOG_FUNCTION (this << socket);
-  Address sourceAddress;
-  Ptr<Packet> packet = socket->RecvFrom (sourceAddress);
-  InetSocketAddress inetSourceAddr = InetSocketAddress::ConvertFrom (sourceAddress);
-  Ipv4Address sender = inetSourceAddr.GetIpv4 ();
-  Ipv4Address receiver;
-
-  if (m_socketAddresses.find (socket) != m_socketAddresses.end ())
-    {
-      receiver = m_socketAddresses[socket].GetLocal ();
-    }
-  else if (m_socketSubnetBroadcastAddresses.find (socket) != m_socketSubnetBroadcastAddresses.end ())
-    {
-      receiver = m_socketSubnetBroadcastAddresses[socket].GetLocal ();
-    }
-  else
+  bool containedStandardDSDV = false;
+  m_lastHeard[sender] = Simulator::Now ();
+  // the destinations of a multi-destination request share one request ID
+  bool requestChecked = false, requestDuplicate = false;
+  uint16_t requestId = 0;
+
+  // decode the whole packet before touching the tables
+  packet->PeekHeader (m_parser);
+  if (!m_parser.IsComplete ())
     {
-      NS_ASSERT_MSG (false, "Received a packet from an unknown socket");
+      NS_LOG_DEBUG (m_mainAddress<< "EffDsdv message " << packet->GetUid () << " with unknown type or truncated after "
+                                 << m_parser.GetSerializedSize () << " of " << packetSize << " bytes. Drop the rest");
     }
-  NS_LOG_DEBUG ("EffDSDV node " << this << " received an EffDSDV packet from " << sender << " to " << receiver);
-   */
-  bool containedStandardDSDV = false;
-  int8_t substractionPacketSize = 0;
-
-  for (; packetSize > 0; packetSize = packetSize - substractionPacketSize)
+  for (std::vector<ControlPacketParser::Message>::const_iterator i = m_parser.GetMessages ().begin ();
+       i != m_parser.GetMessages ().end (); ++i)
     {
-	  TypeHeader tHeader (DSDVTYPE_DSDV);
-	  packet->RemoveHeader (tHeader);
-	  if (!tHeader.IsValid ())
-	  {
-		  NS_LOG_DEBUG (m_mainAddress<< "EffDsdv message " << packet->GetUid () << " with unknown type received: " << tHeader.Get () << ". Drop");
-		  return; // drop
-	  }
-	  switch (tHeader.Get ())
-	  {
-	  	  case DSDVTYPE_DSDV:
-	  	  {
-	  		NS_LOG_DEBUG (m_mainAddress<<": Packet "<<packet->GetUid ()<<" contains a DSDV Message");
-	  		  containedStandardDSDV = true;
-	  		  substractionPacketSize = 12;
-	  		  RecvDsdv (packet, receiver, sender);
-	  		  break;
-		  }
-		case DSDVTYPE_RREQ:
-		  {
-			  NS_LOG_DEBUG (m_mainAddress<<": Packet "<<packet->GetUid ()<<" contains a RREQ Message");
-			substractionPacketSize = 8;
-		    RecvRouteRequest (packet, receiver, sender);
-			break;
-		  }
-		case DSDVTYPE_RACK:
-		  {
-			  NS_LOG_DEBUG (m_mainAddress<<": Packet "<<packet->GetUid ()<<" contains a RACK Message");
-			  substractionPacketSize = 12;
-			  RecvRouteAck (packet, receiver, sender);
-			  break;
-		  }
-		default:
-			 NS_LOG_DEBUG (m_mainAddress<<": Unknown package type in EffDSDV based Transmission");
-			 break;
-	  }
+      switch (i->type)
+        {
+        case DSDVTYPE_DSDV:
+          {
+            containedStandardDSDV = true;
+            ProcessUpdate (ControlPacketParser::GetDsdvHeader (*i), receiver, sender);
+            break;
+          }
+        case DSDVTYPE_RREQ:
+          {
+            NS_LOG_DEBUG (m_mainAddress<<": Packet "<<packet->GetUid ()<<" contains a RREQ Message");
+            if (!requestChecked || i->value != requestId)
+              {
+                requestChecked = true;
+                requestId = i->value;
+                requestDuplicate = m_rreqIdCache.IsDuplicate (sender, requestId);
+                if (requestDuplicate)
+                  {
+                    NS_LOG_DEBUG (m_mainAddress<<": discard duplicate RREQ " << requestId << " from " << sender);
+                    m_duplicateRequests++;
+                  }
+              }
+            if (!requestDuplicate)
+              {
+                RecvRouteRequest (ControlPacketParser::GetRreqHeader (*i), receiver, sender);
+              }
+            break;
+          }
+        case DSDVTYPE_RACK:
+          {
+            NS_LOG_DEBUG (m_mainAddress<<": Packet "<<packet->GetUid ()<<" contains a RACK Message");
+            RecvRouteAck (ControlPacketParser::GetRackHeader (*i), receiver, sender);
+            break;
+          }
+        default:
+          break;
+        }
     }
   if (containedStandardDSDV){
-  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
-  m_advRoutingTable.GetListOfAllValidRoutes (allRoutes);
-  if (EnableRouteAggregation && allRoutes.size () > 0)
+  if (EnableRouteAggregation && m_advRoutingTable.GetValidCount () > 0)
     {
-      Simulator::Schedule (m_routeAggregationTime,&RoutingProtocol::SendTriggeredUpdate,this);
+      ScheduleTriggeredUpdate (m_routeAggregationTime);
     }
   else
     {
-      Simulator::Schedule (MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)),&RoutingProtocol::SendTriggeredUpdate,this);
+      ScheduleTriggeredUpdate (MicroSeconds (m_uniformRandomVariable->GetInteger (0,1000)));
     }
   }
 }
 
 void
-RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
+RoutingProtocol::ProcessUpdate (DsdvHeader const & dsdvHeader, Ipv4Address receiver, Ipv4Address src)
 {
-	NS_LOG_FUNCTION (this);
-
 	  uint32_t count = 0;
 	  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (receiver));
-	  DsdvHeader dsdvHeader, tempDsdvHeader;
-	  p->RemoveHeader (dsdvHeader);
-      count = 0;
       NS_LOG_DEBUG (m_mainAddress<<" processes the DSDV packet for " << dsdvHeader.GetDst ());
       /*Verifying if the packets sent by me were returned back to me. If yes, discarding them!*/
       for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
@@ -713,7 +859,6 @@ RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
                     << src << ". Details are: Destination: " << dsdvHeader.GetDst () << ", Seq No: "
                     << dsdvHeader.GetDstSeqno () << ", HopCount: " << dsdvHeader.GetHopCount ());
       RoutingTableEntry fwdTableEntry, advTableEntry;
-      EventId event;
       bool permanentTableVerifier = m_routingTable.LookupRoute (dsdvHeader.GetDst (),fwdTableEntry);
       if (permanentTableVerifier == false)
         {
@@ -740,20 +885,13 @@ RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
               // received update not present in main routing table and also with infinite metric
               NS_LOG_DEBUG (m_mainAddress<<": Discarding this update as this route is not present in "
                             "main routing table and received with infinite metric");
-              m_altRoutingTable.DeleteRoute(dsdvHeader.GetDst());
+              DeleteAlternativeRoute (dsdvHeader.GetDst());
             }
         }
       else
         {
           if (!m_advRoutingTable.LookupRoute (dsdvHeader.GetDst (),advTableEntry))
             {
-              RoutingTableEntry tr;
-              std::map<Ipv4Address, RoutingTableEntry> allRoutes;
-              m_advRoutingTable.GetListOfAllValidRoutes (allRoutes);
-              for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
-                {
-                  NS_LOG_DEBUG (m_mainAddress<<": ADV table routes are:" << i->second.GetDestination ());
-                }
               // present in fwd table and not in advtable
               m_advRoutingTable.AddRoute (fwdTableEntry);
               m_advRoutingTable.LookupRoute (dsdvHeader.GetDst (),advTableEntry);
@@ -763,7 +901,7 @@ RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
               if (dsdvHeader.GetDstSeqno () > advTableEntry.GetSeqNo ())
                 {
                   // Received update with better seq number. Clear any old events that are running
-                  if (m_advRoutingTable.ForceDeleteIpv4Event (dsdvHeader.GetDst ()))
+                  if (m_settlingScheduler.Cancel (dsdvHeader.GetDst ()))
                     {
                       NS_LOG_DEBUG (m_mainAddress<<": Canceling the timer to update route with better seq number");
                     }
@@ -781,9 +919,7 @@ RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
                       advTableEntry.SetSettlingTime (tempSettlingtime);
                       NS_LOG_DEBUG (m_mainAddress<<": Added Settling Time:" << tempSettlingtime.GetSeconds ()
                                                            << "s as there is no event running for this route");
-                      event = Simulator::Schedule (tempSettlingtime,&RoutingProtocol::SendTriggeredUpdate,this);
-                      m_advRoutingTable.AddIpv4Event (dsdvHeader.GetDst (),event);
-                      NS_LOG_DEBUG (m_mainAddress<<": EventCreated EventUID: " << event.GetUid ());
+                      m_settlingScheduler.Schedule (dsdvHeader.GetDst (), tempSettlingtime);
                       // if received changed metric, use it but adv it only after wst
                       m_routingTable.Update (advTableEntry);
                       m_advRoutingTable.Update (advTableEntry);
@@ -800,7 +936,7 @@ RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
                       m_advRoutingTable.Update (advTableEntry);
                       NS_LOG_DEBUG (m_mainAddress<<": Route with better sequence number and same metric received. Advertised without WST");
                     }
-                  m_altRoutingTable.DeleteRoute(dsdvHeader.GetDst());
+                  DeleteAlternativeRoute (dsdvHeader.GetDst());
                 }
               else if (dsdvHeader.GetDstSeqno () == advTableEntry.GetSeqNo ())
                 {
@@ -811,7 +947,7 @@ RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
                        */
                       NS_LOG_DEBUG (m_mainAddress<<": Canceling any existing timer to update route with same sequence number "
                                     "and better hop count");
-                      m_advRoutingTable.ForceDeleteIpv4Event (dsdvHeader.GetDst ());
+                      m_settlingScheduler.Cancel (dsdvHeader.GetDst ());
                       advTableEntry.SetSeqNo (dsdvHeader.GetDstSeqno ());
                       advTableEntry.SetLifeTime (Simulator::Now ());
                       advTableEntry.SetFlag (VALID);
@@ -822,20 +958,18 @@ RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
                       advTableEntry.SetSettlingTime (tempSettlingtime);
                       NS_LOG_DEBUG (m_mainAddress<<": Added Settling Time," << tempSettlingtime.GetSeconds ()
                                                            << " as there is no current event running for this route");
-                      event = Simulator::Schedule (tempSettlingtime,&RoutingProtocol::SendTriggeredUpdate,this);
-                      m_advRoutingTable.AddIpv4Event (dsdvHeader.GetDst (),event);
-                      NS_LOG_DEBUG (m_mainAddress<<": EventCreated EventUID: " << event.GetUid ());
+                      m_settlingScheduler.Schedule (dsdvHeader.GetDst (), tempSettlingtime);
                       // if received changed metric, use it but adv it only after wst
                       m_routingTable.Update (advTableEntry);
                       m_advRoutingTable.Update (advTableEntry);
-                      m_altRoutingTable.DeleteRoute(advTableEntry.GetDestination());
+                      DeleteAlternativeRoute (advTableEntry.GetDestination());
                     }
                   else
                     {
                       /*Received update with same seq number but with same or greater hop count.
                        * Discard that update.
                        */
-                      if (!m_advRoutingTable.AnyRunningEvent (dsdvHeader.GetDst ()))
+                      if (!m_settlingScheduler.IsPending (dsdvHeader.GetDst ()))
                         {
                           /*update the timer only if nexthop address matches thus discarding
                            * updates to that destination from other nodes.
@@ -855,7 +989,7 @@ RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
               else
                 {
                   // Received update with an old sequence number. Discard the update
-                  if (!m_advRoutingTable.AnyRunningEvent (dsdvHeader.GetDst ()))
+                  if (!m_settlingScheduler.IsPending (dsdvHeader.GetDst ()))
                     {
                       m_advRoutingTable.DeleteRoute (dsdvHeader.GetDst ());
                     }
@@ -870,31 +1004,37 @@ RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
               if (src == advTableEntry.GetNextHop ())
                 {
                   NS_LOG_DEBUG ("Triggering an update for this unreachable route:");
-                  std::map<Ipv4Address, RoutingTableEntry> dstsWithNextHopSrc, altDstsWithNextHopSrc;
-                  m_routingTable.GetListOfDestinationWithNextHop (dsdvHeader.GetDst (),dstsWithNextHopSrc);
-                  m_altRoutingTable.GetListOfDestinationWithNextHop (dsdvHeader.GetDst (),altDstsWithNextHopSrc);
-                  m_routingTable.DeleteRoute (dsdvHeader.GetDst ());
-                  m_altRoutingTable.DeleteRoute (dsdvHeader.GetDst ());
+                  // copy the destinations only, the ranges change while routes get deleted
+                  RoutingTable::DestinationRange range = m_routingTable.GetDestinationsWithNextHop (dsdvHeader.GetDst ());
+                  std::vector<Ipv4Address> dstsWithNextHopSrc (range.first, range.second);
+                  range = m_altRoutingTable.GetDestinationsWithNextHop (dsdvHeader.GetDst ());
+                  std::vector<Ipv4Address> altDstsWithNextHopSrc (range.first, range.second);
                   advTableEntry.SetSeqNo (dsdvHeader.GetDstSeqno ());
                   advTableEntry.SetEntriesChanged (true);
                   m_advRoutingTable.Update (advTableEntry);
-                  for (std::map<Ipv4Address, RoutingTableEntry>::iterator i = dstsWithNextHopSrc.begin (); i
+                  for (std::vector<Ipv4Address>::const_iterator i = dstsWithNextHopSrc.begin (); i
                        != dstsWithNextHopSrc.end (); ++i)
                     {
-                      i->second.SetSeqNo (i->second.GetSeqNo () + 1);
-                      i->second.SetEntriesChanged (true);
-                      m_advRoutingTable.AddRoute (i->second);
-                      m_routingTable.DeleteRoute (i->second.GetDestination ());
+                      RoutingTableEntry unreachable;
+                      if (*i != dsdvHeader.GetDst () && m_routingTable.LookupRoute (*i, unreachable))
+                        {
+                          unreachable.SetSeqNo (unreachable.GetSeqNo () + 1);
+                          unreachable.SetEntriesChanged (true);
+                          m_advRoutingTable.AddRoute (unreachable);
+                        }
+                      m_routingTable.DeleteRoute (*i);
+                    }
+                  m_routingTable.DeleteRoute (dsdvHeader.GetDst ());
+                  DeleteAlternativeRoute (dsdvHeader.GetDst ());
+                  for (std::vector<Ipv4Address>::const_iterator i = altDstsWithNextHopSrc.begin (); i
+                       != altDstsWithNextHopSrc.end (); ++i)
+                    {
+                      DeleteAlternativeRoute (*i);
                     }
-                  for (std::map<Ipv4Address, RoutingTableEntry>::iterator i = altDstsWithNextHopSrc.begin (); i
-                                        != altDstsWithNextHopSrc.end (); ++i)
-                                     {
-                	  	  	  	  	  m_altRoutingTable.DeleteRoute(i->second.GetDestination());
-                                     }
                 }
               else
                 {
-                  if (!m_advRoutingTable.AnyRunningEvent (dsdvHeader.GetDst ()))
+                  if (!m_settlingScheduler.IsPending (dsdvHeader.GetDst ()))
                     {
                       m_advRoutingTable.DeleteRoute (dsdvHeader.GetDst ());
                     }
@@ -908,11 +1048,9 @@ RoutingProtocol::RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
 
 
 void
-RoutingProtocol::RecvRouteRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
+RoutingProtocol::RecvRouteRequest (RreqHeader const & rreqHeader, Ipv4Address receiver, Ipv4Address src)
 {
   NS_LOG_FUNCTION (this);
-  RreqHeader rreqHeader;
-  p->RemoveHeader (rreqHeader);
   Ipv4Address dst = rreqHeader.GetDst ();
 
   //check if RREQ can be discarded in favor of next periodic update
@@ -922,8 +1060,8 @@ RoutingProtocol::RecvRouteRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Addr
 	  NS_LOG_DEBUG (m_mainAddress<<": discard RREQ to "<<dst<<" from "<<src<<" in favor of DSDV-Update");
 	  return;
   }
-  NS_LOG_DEBUG (receiver << ": received RREQ to destination " << rreqHeader.GetDst ()<<", Packet: "<< p->GetUid() );
-  NS_LOG_LOGIC (receiver << ": received RREQ to destination " << rreqHeader.GetDst ()<<", Packet: "<< p->GetUid() );
+  NS_LOG_DEBUG (receiver << ": received RREQ to destination " << rreqHeader.GetDst () << " from " << src);
+  NS_LOG_LOGIC (receiver << ": received RREQ to destination " << rreqHeader.GetDst () << " from " << src);
 
   std::map<Ipv4Address, RoutingTableEntry> removedAddresses, allRoutes, invalidatedAddresses;
   m_routingTable.Purge (removedAddresses, invalidatedAddresses);
@@ -973,7 +1111,7 @@ RoutingProtocol::RecvRouteRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Addr
 	  	 //Drop RREQ, This node RREP will make a loop.
 		 NS_LOG_DEBUG (m_mainAddress<<": Drop RREQ from " << src << ", dest next hop " << toDst.GetNextHop ());
 		 //AND Delete alternative Route, as our route towards destination is not functional anymore
-		 m_altRoutingTable.DeleteRoute(dst);
+		 DeleteAlternativeRoute (dst);
 	  	 return;
 	  }
 	  RoutingTableEntry nextHop;
@@ -1007,11 +1145,9 @@ RoutingProtocol::RecvRouteRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Addr
 }
 
 void
-RoutingProtocol::RecvRouteAck (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address sender)
+RoutingProtocol::RecvRouteAck (RackHeader rackHeader, Ipv4Address receiver, Ipv4Address sender)
 {
   NS_LOG_FUNCTION (this << " src " << sender);
-  RackHeader rackHeader;
-  p->RemoveHeader (rackHeader);
   Ipv4Address dst = rackHeader.GetDst ();
   NS_LOG_LOGIC (receiver <<": received RACK for destination " << dst << " from " << sender);
   NS_LOG_DEBUG (receiver <<": received RACK for destination " << dst << " from " << sender);
@@ -1043,42 +1179,31 @@ RoutingProtocol::RecvRouteAck (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address
  	                  true);
  	                newEntry.SetFlag (VALID);
  	                newEntry.SetInstallTime(Simulator::Now ());
- RoutingTableEntry rt;
-  if (m_altRoutingTable.LookupRoute(dst,rt))
-  {
-	  if (rt.GetFlag()==RouteFlags::INSEARCH)
-	  {
-		  m_altRoutingTable.Update(newEntry);
-		  NS_LOG_DEBUG (m_mainAddress<<": Valid alternative to "<<dst<<" saved to Routing Table");
-	  } else
-	  {
-		  if (hop <= rt.GetHop())
-		  {
-			  if (hop == rt.GetHop())
-			  {
-				  if (rackHeader.GetUpdateTime().GetSeconds()<rt.GetLifeTime())
-				  {
-					 rt.SetNextHop(sender);
-					 rt.SetLifeTime(Simulator::Now()-Time(rackHeader.GetUpdateTime()));
-					 rt.SetInstallTime(Simulator::Now ());
-					 m_altRoutingTable.Update(rt);
-					 NS_LOG_DEBUG (m_mainAddress<<": more recent update for "<<dst<<" saved");
-				  }
-			  } else
-			  {
-				  rt.SetNextHop(sender);
-				  rt.SetLifeTime(Simulator::Now()-Time(rackHeader.GetUpdateTime()));
-				  rt.SetHop(hop);
-				  rt.SetInstallTime(Simulator::Now ());
-				  m_altRoutingTable.Update(rt);
-				  NS_LOG_DEBUG (m_mainAddress<<": shorter alternative route to "<<dst<<" saved");
-			  }
-		  }
-	  }
-  } else {
-	  m_altRoutingTable.AddRoute(newEntry);
-		  NS_LOG_DEBUG (m_mainAddress<<": Alternative Route to "<<dst<<" saved to Routing Table. No preliminary entry found to replace.");
-  }
+  // rank it among the other alternatives to fail over to
+  m_altRoutes.Offer (newEntry);
+  // the alternative table holds the best ranked candidate, there is at least the one just offered
+  RoutingTableEntry best;
+  m_altRoutes.GetBest (dst, best);
+  RoutingTableEntry rt;
+  if (m_altRoutingTable.LookupRoute (dst, rt))
+    {
+      m_altRoutingTable.Update (best);
+      if (rt.GetFlag () == RouteFlags::INSEARCH)
+        {
+          m_rreqBackoff.Reset (dst);
+          NS_LOG_DEBUG (m_mainAddress<<": Valid alternative to "<<dst<<" saved to Routing Table");
+        }
+      else if (best.GetNextHop () != rt.GetNextHop ())
+        {
+          NS_LOG_DEBUG (m_mainAddress<<": better alternative route to "<<dst<<" via "<<best.GetNextHop ()<<" saved");
+        }
+    }
+  else
+    {
+      m_altRoutingTable.AddRoute (best);
+      m_rreqBackoff.Reset (dst);
+      NS_LOG_DEBUG (m_mainAddress<<": Alternative Route to "<<dst<<" saved to Routing Table. No preliminary entry found to replace.");
+    }
 }
 
 
@@ -1088,27 +1213,18 @@ RoutingProtocol::SendRouteRequest (Ipv4Address dst)
 {
   NS_LOG_FUNCTION ( this << dst);
   // Create RREQ header
-  RreqHeader rreqHeader;
-  rreqHeader.SetDst (dst);
-  RoutingTableEntry rt;
   /**
-   * Check if Request is already in progress
-   * If lifetime of request is expired, delete
-   * else discard request
+   * Requests for the same destination are spaced out exponentially,
+   * so they grow with route breaks rather than with the data rate
    */
-  if (m_altRoutingTable.LookupRoute(dst,rt))
-  {
-	  if (rt.GetFlag()==RouteFlags::INSEARCH && rt.GetLifeTime()<=Seconds(4)){
-		  //discard
-		 NS_LOG_DEBUG(m_mainAddress <<": RREQ still in progress, discard new request");
-		  return;
-	  }
-	  else if (rt.GetFlag()==RouteFlags::INSEARCH && rt.GetLifeTime()>Seconds(4))
-	  {
-		  NS_LOG_DEBUG(m_mainAddress << ": RREQ not answered in time, send new request");
-		  m_altRoutingTable.DeleteRoute(dst);
-	  }
-  }
+  if (!m_rreqBackoff.TryRequest (dst))
+    {
+      NS_LOG_DEBUG (m_mainAddress <<": RREQ for "<<dst<<" held back until "<<m_rreqBackoff.GetNextAllowed (dst).GetSeconds ());
+      m_suppressedRequests++;
+      return;
+    }
+  NS_LOG_DEBUG (m_mainAddress <<": RREQ for "<<dst<<", attempt "<<m_rreqBackoff.GetAttempts (dst));
+  RoutingTableEntry rt;
   if(!m_altRoutingTable.LookupRoute(dst,rt))
   {
 	  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (m_mainAddress));
@@ -1127,6 +1243,23 @@ RoutingProtocol::SendRouteRequest (Ipv4Address dst)
   }
 
 
+  // requests issued within the batching window go out as one
+  m_requestBatch.push_back (dst);
+  if (!m_requestBatchEvent.IsRunning ())
+    {
+      m_requestBatchEvent = Simulator::Schedule (m_rreqBatchWindow, &RoutingProtocol::SendRequestBatch, this);
+    }
+}
+
+void
+RoutingProtocol::SendRequestBatch ()
+{
+  NS_LOG_FUNCTION (this << m_requestBatch.size ());
+  if (m_requestBatch.empty ())
+    {
+      return;
+    }
+  uint16_t requestId = ++m_requestId;
   // Send RREQ as subnet directed broadcast from each interface used by effdsdv
 	    for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
 	           m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
@@ -1135,9 +1268,21 @@ RoutingProtocol::SendRouteRequest (Ipv4Address dst)
 	        Ipv4InterfaceAddress iface = j->second;
 
 	        Ptr<Packet> packet = Create<Packet> ();
-	        packet->AddHeader (rreqHeader);
-	        TypeHeader tHeader (DSDVTYPE_RREQ);
-	        packet->AddHeader (tHeader);
+	        if (m_requestBatch.size () == 1)
+	          {
+	            packet->AddHeader (RreqHeader (m_requestBatch.front (), requestId));
+	            packet->AddHeader (TypeHeader (DSDVTYPE_RREQ));
+	          }
+	        else
+	          {
+	            BulkRreqHeader bulkHeader (requestId);
+	            for (std::vector<Ipv4Address>::const_iterator i = m_requestBatch.begin (); i != m_requestBatch.end (); ++i)
+	              {
+	                bulkHeader.AddDst (*i);
+	              }
+	            packet->AddHeader (bulkHeader);
+	            packet->AddHeader (TypeHeader (DSDVTYPE_BULK_RREQ));
+	          }
 	        // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
 	        Ipv4Address destination;
 	        if (iface.GetMask () == Ipv4Mask::GetOnes ())
@@ -1148,185 +1293,434 @@ RoutingProtocol::SendRouteRequest (Ipv4Address dst)
 	          {
 	            destination = iface.GetBroadcast ();
 	          }
-	        NS_LOG_DEBUG (m_mainAddress<<": Send RREQ for dst " << rreqHeader.GetDst() << " to socket");
+	        NS_LOG_DEBUG (m_mainAddress<<": Send RREQ "<<requestId<<" for "<<m_requestBatch.size ()<<" destinations to socket");
 	        Simulator::Schedule (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 50))), &RoutingProtocol::SendTo, this, socket, packet, destination);
-	        //SendTo(socket,packet,destination);
 	      }
+  m_requestBatch.clear ();
 }
 
 void
 RoutingProtocol::SendRouteAck (RoutingTableEntry const & toDst, Ipv4Address requester, Ipv4Address acknowledger)
 {
   NS_LOG_FUNCTION (this << acknowledger);
-  RackHeader rackHeader ( /*dst=*/ toDst.GetDestination(), /*hopCount=*/ toDst.GetHop()+1, /*updateTime=*/ toDst.GetLifeTime());
-  Ptr<Packet> packet = Create<Packet> ();
-  packet->AddHeader (rackHeader);
-  TypeHeader tHeader (DSDVTYPE_RACK);
-  packet->AddHeader (tHeader);
-  Ptr<Socket> socket = FindSocketWithInterfaceAddress (m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (m_mainAddress), 0));
-  NS_ASSERT (socket);
-  NS_LOG_DEBUG(m_mainAddress<<": Send RACK to " <<requester<< " from "<<acknowledger<<" for destination "<<toDst.GetDestination() << ", costs "<< toDst.GetHop()+1);
-  NS_LOG_DEBUG(m_mainAddress<<": via Socket: "<<socket);
-  socket->SendTo (packet, 0, InetSocketAddress (requester, DSDV_PORT));
-  //Simulator::Schedule (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), &RoutingProtocol::SendTo, this, socket, packet, requester);
+  NS_LOG_DEBUG(m_mainAddress<<": Queue RACK to " <<requester<< " from "<<acknowledger<<" for destination "<<toDst.GetDestination() << ", costs "<< toDst.GetHop()+1);
+  // acks for the same requester within the batching window go out as one packet;
+  // the route is kept rather than the header, its age is taken when the packet is built
+  std::vector<RoutingTableEntry> & acks = m_ackBatch[requester];
+  std::vector<RoutingTableEntry>::iterator i = acks.begin ();
+  while (i != acks.end () && i->GetDestination () != toDst.GetDestination ())
+    {
+      ++i;
+    }
+  if (i != acks.end ())
+    {
+      *i = toDst;
+    }
+  else
+    {
+      acks.push_back (toDst);
+    }
+  if (!m_ackBatchEvent.IsRunning ())
+    {
+      m_ackBatchEvent = Simulator::Schedule (m_rackBatchWindow, &RoutingProtocol::SendAckBatch, this);
+    }
 }
 
 void
-RoutingProtocol::SendTriggeredUpdate ()
+RoutingProtocol::SendAckBatch ()
 {
-  NS_LOG_FUNCTION (m_mainAddress << " is sending a triggered update");
-  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
-  m_advRoutingTable.GetListOfAllValidRoutes (allRoutes);
-  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
-       != m_socketAddresses.end (); ++j)
+  NS_LOG_FUNCTION (this << m_ackBatch.size ());
+  Ptr<Socket> socket = FindSocketWithInterfaceAddress (m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (m_mainAddress), 0));
+  NS_ASSERT (socket);
+  for (AddressMap<std::vector<RoutingTableEntry> >::const_iterator i = m_ackBatch.begin (); i != m_ackBatch.end (); ++i)
     {
-      DsdvHeader dsdvHeader;
-      Ptr<Socket> socket = j->first;
-      Ipv4InterfaceAddress iface = j->second;
+      std::vector<RackHeader> acks;
+      for (std::vector<RoutingTableEntry>::const_iterator j = i->second.begin (); j != i->second.end (); ++j)
+        {
+          acks.push_back (RackHeader (/*dst=*/ j->GetDestination (), /*hopCount=*/ j->GetHop () + 1, /*updateTime=*/ j->GetLifeTime ()));
+        }
       Ptr<Packet> packet = Create<Packet> ();
-      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+      if (acks.size () == 1)
         {
-          NS_LOG_LOGIC (m_mainAddress<<": Destination: " << i->second.GetDestination ()
-                                        << " SeqNo:" << i->second.GetSeqNo () << " HopCount:"
-                                        << i->second.GetHop () + 1);
-          RoutingTableEntry temp = i->second;
-          if ((i->second.GetEntriesChanged () == true) && (!m_advRoutingTable.AnyRunningEvent (temp.GetDestination ())))
-            {
-              dsdvHeader.SetDst (i->second.GetDestination ());
-              dsdvHeader.SetDstSeqno (i->second.GetSeqNo ());
-              dsdvHeader.SetHopCount (i->second.GetHop () + 1);
-              temp.SetFlag (VALID);
-              temp.SetEntriesChanged (false);
-              m_advRoutingTable.DeleteIpv4Event (temp.GetDestination ());
-              if (!(temp.GetSeqNo () % 2))
-                {
-                  m_routingTable.Update (temp);
-                }
-              packet->AddHeader (dsdvHeader);
-              TypeHeader tHeader (DSDVTYPE_DSDV);
-              packet->AddHeader (tHeader);
-              m_advRoutingTable.DeleteRoute (temp.GetDestination ());
-              NS_LOG_DEBUG (m_mainAddress<<": Deleted this route from the advertised table");
-            }
-          else
-            {
-              EventId event = m_advRoutingTable.GetEventId (temp.GetDestination ());
-              NS_ASSERT (event.GetUid () != 0);
-              NS_LOG_DEBUG (m_mainAddress<<": EventID " << event.GetUid () << " associated with "
-                                       << temp.GetDestination () << " has not expired, waiting in adv table");
-            }
+          packet->AddHeader (acks.front ());
+          packet->AddHeader (TypeHeader (DSDVTYPE_RACK));
         }
-      if (packet->GetSize () >= 12)
+      else
         {
-          RoutingTableEntry temp2;
-          m_routingTable.LookupRoute (m_ipv4->GetAddress (1, 0).GetBroadcast (), temp2);
-          dsdvHeader.SetDst (m_ipv4->GetAddress (1, 0).GetLocal ());
-          dsdvHeader.SetDstSeqno (temp2.GetSeqNo ());
-          dsdvHeader.SetHopCount (temp2.GetHop () + 1);
-          NS_LOG_DEBUG (m_mainAddress<<": Adding my update as well to the packet");
-          packet->AddHeader (dsdvHeader);
-          TypeHeader tHeader (DSDVTYPE_DSDV);
-          packet->AddHeader (tHeader);
-          // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
-          Ipv4Address destination;
-          if (iface.GetMask () == Ipv4Mask::GetOnes ())
+          BulkRackHeader bulkHeader;
+          for (std::vector<RackHeader>::const_iterator j = acks.begin (); j != acks.end (); ++j)
             {
-              destination = Ipv4Address ("255.255.255.255");
+              bulkHeader.AddEntry (*j);
             }
-          else
-            {
-              destination = iface.GetBroadcast ();
-            }
-          socket->SendTo (packet, 0, InetSocketAddress (destination, DSDV_PORT));
-          NS_LOG_FUNCTION (m_mainAddress<<": Sent Triggered Update from "
-                           << dsdvHeader.GetDst ()
-                           << " with packet id : " << packet->GetUid () << " and packet Size: " << packet->GetSize ());
+          packet->AddHeader (bulkHeader);
+          packet->AddHeader (TypeHeader (DSDVTYPE_BULK_RACK));
         }
-      else
+      NS_LOG_DEBUG(m_mainAddress<<": Send RACK with "<<acks.size ()<<" entries to " <<i->first<<" via Socket: "<<socket);
+      socket->SendTo (packet, 0, InetSocketAddress (i->first, DSDV_PORT));
+    }
+  m_ackBatch.clear ();
+}
+
+void
+RoutingProtocol::SendTriggeredUpdate ()
+{
+  NS_LOG_FUNCTION (m_mainAddress << " is sending a triggered update");
+  // the settled changes are collected once and advertised on every interface
+  std::vector<DsdvHeader> updates;
+  GetDirtyRoutes (m_dirtyRoutes);
+  for (std::vector<RoutingTableEntry>::iterator i = m_dirtyRoutes.begin (); i != m_dirtyRoutes.end (); ++i)
+    {
+      NS_LOG_LOGIC (m_mainAddress<<": Destination: " << i->GetDestination ()
+                                    << " SeqNo:" << i->GetSeqNo () << " HopCount:"
+                                    << i->GetHop () + 1);
+      DsdvHeader dsdvHeader;
+      dsdvHeader.SetDst (i->GetDestination ());
+      dsdvHeader.SetDstSeqno (i->GetSeqNo ());
+      dsdvHeader.SetHopCount (i->GetHop () + 1);
+      updates.push_back (dsdvHeader);
+      i->SetFlag (VALID);
+      i->SetEntriesChanged (false);
+      if (!(i->GetSeqNo () % 2))
         {
-          NS_LOG_FUNCTION (m_mainAddress<<": Update not sent as there are no updates to be triggered");
+          m_routingTable.Update (*i);
         }
+      m_advRoutingTable.DeleteRoute (i->GetDestination ());
+      NS_LOG_DEBUG (m_mainAddress<<": Deleted this route from the advertised table");
+    }
+  if (updates.empty ())
+    {
+      NS_LOG_FUNCTION (m_mainAddress<<": Update not sent as there are no updates to be triggered");
+      return;
+    }
+  m_dirtyEntriesTrace (updates.size ());
+  DsdvHeader dsdvHeader;
+  RoutingTableEntry temp2;
+  m_routingTable.LookupRoute (m_ipv4->GetAddress (1, 0).GetBroadcast (), temp2);
+  dsdvHeader.SetDst (m_ipv4->GetAddress (1, 0).GetLocal ());
+  dsdvHeader.SetDstSeqno (temp2.GetSeqNo ());
+  dsdvHeader.SetHopCount (temp2.GetHop () + 1);
+  NS_LOG_DEBUG (m_mainAddress<<": Adding my update as well to the packet");
+  updates.push_back (dsdvHeader);
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
+       != m_socketAddresses.end (); ++j)
+    {
+      // the damper of the interface sends it now or merges it into a later update
+      GetTriggerDamper (j->first, j->second)->Add (updates);
+      NS_LOG_FUNCTION (m_mainAddress<<": Triggered Update from "
+                       << dsdvHeader.GetDst () << " with " << updates.size () << " entries");
+    }
+}
+
+void
+RoutingProtocol::ScheduleTriggeredUpdate (Time delay)
+{
+  if (m_triggeredUpdateEvent.IsRunning ()
+      && Simulator::GetDelayLeft (m_triggeredUpdateEvent) <= delay)
+    {
+      // the pending triggered update collects these changes as well
+      NotifyTriggerSuppressed (TriggerDamper::COALESCED);
+      return;
     }
+  m_triggeredUpdateEvent.Cancel ();
+  m_triggeredUpdateEvent = Simulator::Schedule (delay, &RoutingProtocol::SendTriggeredUpdate, this);
+}
+
+Ptr<TriggerDamper>
+RoutingProtocol::GetTriggerDamper (Ptr<Socket> socket, Ipv4InterfaceAddress const & iface)
+{
+  std::map<Ptr<Socket>, Ptr<TriggerDamper> >::const_iterator i = m_triggerDampers.find (socket);
+  if (i != m_triggerDampers.end ())
+    {
+      return i->second;
+    }
+  Ptr<TriggerDamper> damper = Create<TriggerDamper> (iface);
+  damper->SetFlushCallback (MakeCallback (&RoutingProtocol::FlushTriggeredUpdate, this));
+  damper->SetSuppressCallback (MakeCallback (&RoutingProtocol::NotifyTriggerSuppressed, this));
+  damper->SetMinInterval (m_triggerMinInterval);
+  damper->SetTokenBucket (m_triggerRate, m_triggerBurst);
+  // IP and UDP headers on top of the update itself
+  damper->SetUpdateSize (GetUpdateSize (0) + 28, GetUpdateSize (1) - GetUpdateSize (0));
+  m_triggerDampers.insert (std::make_pair (socket, damper));
+  return damper;
+}
+
+void
+RoutingProtocol::RemoveTriggerDamper (Ptr<Socket> socket)
+{
+  std::map<Ptr<Socket>, Ptr<TriggerDamper> >::iterator i = m_triggerDampers.find (socket);
+  if (i != m_triggerDampers.end ())
+    {
+      i->second->Clear ();
+      m_triggerDampers.erase (i);
+    }
+}
+
+void
+RoutingProtocol::FlushTriggeredUpdate (Ipv4InterfaceAddress iface, std::vector<DsdvHeader> const & updates)
+{
+  Ptr<Socket> socket = FindSocketWithInterfaceAddress (iface);
+  if (socket)
+    {
+      NS_LOG_FUNCTION (m_mainAddress<<": Sent Triggered Update on " << iface.GetLocal ()
+                                    << " with " << updates.size () << " entries");
+      SendUpdate (socket, iface, updates);
+      // recorded only now, the damper may have merged or dropped what was handed to it
+      for (std::vector<DsdvHeader>::const_iterator i = updates.begin (); i != updates.end (); ++i)
+        {
+          m_lastAdvertised[i->GetDst ()] = *i;
+        }
+    }
+}
+
+void
+RoutingProtocol::NotifyTriggerSuppressed (TriggerDamper::SuppressReason reason)
+{
+  ++m_suppressedTriggers[reason];
+  m_triggerSuppressedTrace (reason);
+}
+
+uint64_t
+RoutingProtocol::GetSuppressedTriggers (TriggerDamper::SuppressReason reason) const
+{
+  return m_suppressedTriggers[reason];
 }
 
 void
 RoutingProtocol::SendPeriodicUpdate ()
 {
-  std::map<Ipv4Address, RoutingTableEntry> removedAddresses, allRoutes, invalidatedAddresses;
+  std::map<Ipv4Address, RoutingTableEntry> removedAddresses, invalidatedAddresses;
   m_routingTable.Purge (removedAddresses, invalidatedAddresses);
   MergeTriggerPeriodicUpdates ();
-  m_routingTable.GetListOfAllRoutes (allRoutes);
-  if (allRoutes.empty ())
+  std::vector<Ipv4Address> silent;
+  for (AddressMap<Time>::const_iterator i = m_lastHeard.begin (); i != m_lastHeard.end (); ++i)
+    {
+      if (!IsNeighborHeard (i->first, 2))
+        {
+          silent.push_back (i->first);
+        }
+    }
+  for (std::vector<Ipv4Address>::const_iterator i = silent.begin (); i != silent.end (); ++i)
+    {
+      m_lastHeard.erase (*i);
+    }
+  if (m_routingTable.Begin (RoutingTable::ALL_ROUTES) == m_routingTable.End ())
     {
       return;
     }
-  NS_LOG_FUNCTION (m_mainAddress << " is sending out its periodic update");
-  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
-       != m_socketAddresses.end (); ++j)
+  // in between full dumps only what changed since it was last advertised is sent
+  bool fullDump = m_periodicUpdates++ % m_fullDumpInterval == 0;
+  NS_LOG_FUNCTION (m_mainAddress << " is sending out its periodic update, full dump: " << fullDump);
+  // the same dump is sent on every interface
+  std::vector<DsdvHeader> updates;
+  for (RoutingTable::RouteIterator i = m_routingTable.Begin (RoutingTable::ALL_ROUTES); i != m_routingTable.End (); ++i)
     {
-      Ptr<Socket> socket = j->first;
-      Ipv4InterfaceAddress iface = j->second;
-      Ptr<Packet> packet = Create<Packet> ();
-      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+      DsdvHeader dsdvHeader;
+      if (i->GetHop () == 0)
         {
-          DsdvHeader dsdvHeader;
-          if (i->second.GetHop () == 0)
-            {
-              RoutingTableEntry ownEntry;
-              dsdvHeader.SetDst (m_ipv4->GetAddress (1,0).GetLocal ());
-              dsdvHeader.SetDstSeqno (i->second.GetSeqNo () + 2);
-              dsdvHeader.SetHopCount (i->second.GetHop () + 1);
-              m_routingTable.LookupRoute (m_ipv4->GetAddress (1,0).GetBroadcast (),ownEntry);
-              ownEntry.SetSeqNo (dsdvHeader.GetDstSeqno ());
-              m_routingTable.Update (ownEntry);
-              packet->AddHeader (dsdvHeader);
-              TypeHeader tHeader (DSDVTYPE_DSDV);
-              packet->AddHeader (tHeader);
-            }
-          else
+          RoutingTableEntry ownEntry;
+          dsdvHeader.SetDst (m_ipv4->GetAddress (1,0).GetLocal ());
+          dsdvHeader.SetDstSeqno (i->GetSeqNo () + 2);
+          dsdvHeader.SetHopCount (i->GetHop () + 1);
+          m_routingTable.LookupRoute (m_ipv4->GetAddress (1,0).GetBroadcast (),ownEntry);
+          ownEntry.SetSeqNo (dsdvHeader.GetDstSeqno ());
+          m_routingTable.Update (ownEntry);
+        }
+      else
+        {
+          dsdvHeader.SetDst (i->GetDestination ());
+          dsdvHeader.SetDstSeqno ((i->GetSeqNo ()));
+          dsdvHeader.SetHopCount (i->GetHop () + 1);
+          if (!fullDump && !IsAdvertisementChanged (dsdvHeader))
             {
-              dsdvHeader.SetDst (i->second.GetDestination ());
-              dsdvHeader.SetDstSeqno ((i->second.GetSeqNo ()));
-              dsdvHeader.SetHopCount (i->second.GetHop () + 1);
-              packet->AddHeader (dsdvHeader);
-              TypeHeader tHeader (DSDVTYPE_DSDV);
-              packet->AddHeader (tHeader);
+              continue;
             }
-          NS_LOG_DEBUG (m_mainAddress<<": Forwarding the update for " << i->first);
-          NS_LOG_DEBUG (m_mainAddress<<": Forwarding details are, Destination: " << dsdvHeader.GetDst ()
-                                                                << ", SeqNo:" << dsdvHeader.GetDstSeqno ()
-                                                                << ", HopCount:" << dsdvHeader.GetHopCount ()
-                                                                << ", LifeTime: " << i->second.GetLifeTime ().GetSeconds ());
         }
-      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator rmItr = removedAddresses.begin (); rmItr
-           != removedAddresses.end (); ++rmItr)
+      updates.push_back (dsdvHeader);
+      m_lastAdvertised[dsdvHeader.GetDst ()] = dsdvHeader;
+      NS_LOG_DEBUG (m_mainAddress<<": Forwarding the update for " << i->GetDestination ());
+      NS_LOG_DEBUG (m_mainAddress<<": Forwarding details are, Destination: " << dsdvHeader.GetDst ()
+                                                            << ", SeqNo:" << dsdvHeader.GetDstSeqno ()
+                                                            << ", HopCount:" << dsdvHeader.GetHopCount ()
+                                                            << ", LifeTime: " << i->GetLifeTime ().GetSeconds ());
+    }
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator rmItr = removedAddresses.begin (); rmItr
+       != removedAddresses.end (); ++rmItr)
+    {
+      DsdvHeader removedHeader;
+      removedHeader.SetDst (rmItr->second.GetDestination ());
+      removedHeader.SetDstSeqno (rmItr->second.GetSeqNo () + 1);
+      removedHeader.SetHopCount (rmItr->second.GetHop () + 1);
+      updates.push_back (removedHeader);
+      NS_LOG_DEBUG (m_mainAddress<<": Update for removed record is: Destination: " << removedHeader.GetDst ()
+                                                                  << " SeqNo:" << removedHeader.GetDstSeqno ()
+                                                                  << " HopCount:" << removedHeader.GetHopCount ());
+    }
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j
+       != m_socketAddresses.end (); ++j)
+    {
+      SendUpdate (j->first, j->second, updates);
+      NS_LOG_FUNCTION (m_mainAddress<<": Sent PeriodicUpdate with " << updates.size () << " entries");
+    }
+  m_periodicUpdateTimer.Schedule (m_periodicUpdateInterval + MicroSeconds (25 * m_uniformRandomVariable->GetInteger (0,1000)));
+}
+
+bool
+RoutingProtocol::IsAdvertisementChanged (DsdvHeader const & update) const
+{
+  AddressMap<DsdvHeader>::const_iterator last = m_lastAdvertised.find (update.GetDst ());
+  return last == m_lastAdvertised.end () || last->second.GetDstSeqno () != update.GetDstSeqno ()
+         || last->second.GetHopCount () != update.GetHopCount ();
+}
+
+void
+RoutingProtocol::MainRouteChanged (Ipv4Address dst)
+{
+  RoutingTableEntry rt;
+  bool found = m_routingTable.LookupRoute (dst, rt);
+  if (!found)
+    {
+      // a route advertised again later is compared against nothing
+      m_lastAdvertised.erase (dst);
+    }
+  if (!found || rt.GetSeqNo () % 2 == 1)
+    {
+      // a lost neighbor is no longer handed out as gateway
+      m_neighborRoutes.Remove (dst);
+    }
+  m_fib.Invalidate (dst);
+  RoutingTable::DestinationRange range = m_routingTable.GetDestinationsWithNextHop (dst);
+  for (std::vector<Ipv4Address>::const_iterator i = range.first; i != range.second; ++i)
+    {
+      m_fib.Invalidate (*i);
+    }
+}
+
+void
+RoutingProtocol::SendUpdate (Ptr<Socket> socket, Ipv4InterfaceAddress const & iface,
+                             std::vector<DsdvHeader> const & updates)
+{
+  if (updates.empty ())
+    {
+      return;
+    }
+  // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
+  Ipv4Address destination;
+  if (iface.GetMask () == Ipv4Mask::GetOnes ())
+    {
+      destination = Ipv4Address ("255.255.255.255");
+    }
+  else
+    {
+      destination = iface.GetBroadcast ();
+    }
+  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (iface.GetLocal ()));
+  uint32_t mtu = dev->GetMtu ();
+  uint32_t entriesPerPacket = GetEntriesPerPacket (mtu);
+  uint32_t packets = (updates.size () + entriesPerPacket - 1) / entriesPerPacket;
+  // the first packet goes out at once, the others at a random point of their share of the window
+  if (packets == 0)
+    {
+      return;
+    }
+  int64_t slot = m_updateSpreadWindow.GetNanoSeconds () / packets;
+  std::vector<DsdvHeader>::const_iterator begin = updates.begin ();
+  for (uint32_t k = 0; k < packets; ++k)
+    {
+      std::vector<DsdvHeader>::const_iterator end = begin + std::min<uint32_t> (entriesPerPacket, updates.end () - begin);
+      Ptr<Packet> packet = BuildUpdatePacket (begin, end);
+      if (k == 0)
         {
-          DsdvHeader removedHeader;
-          removedHeader.SetDst (rmItr->second.GetDestination ());
-          removedHeader.SetDstSeqno (rmItr->second.GetSeqNo () + 1);
-          removedHeader.SetHopCount (rmItr->second.GetHop () + 1);
-          packet->AddHeader (removedHeader);
-          TypeHeader tHeader (DSDVTYPE_DSDV);
-          packet->AddHeader (tHeader);
-          NS_LOG_DEBUG (m_mainAddress<<": Update for removed record is: Destination: " << removedHeader.GetDst ()
-                                                                      << " SeqNo:" << removedHeader.GetDstSeqno ()
-                                                                      << " HopCount:" << removedHeader.GetHopCount ());
+          SendTo (socket, packet, destination);
         }
-      socket->Send (packet);
-      // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
-      Ipv4Address destination;
-      if (iface.GetMask () == Ipv4Mask::GetOnes ())
+      else
         {
-          destination = Ipv4Address ("255.255.255.255");
+          Time delay = NanoSeconds (slot * k + static_cast<int64_t> (m_uniformRandomVariable->GetValue (0, slot)));
+          Simulator::Schedule (delay, &RoutingProtocol::SendTo, this, socket, packet, destination);
         }
-      else
+      NS_LOG_LOGIC (m_mainAddress<<": Update packet " << k + 1 << "/" << packets << " UID is : " << packet->GetUid ()
+                                 << ", size: " << packet->GetSize ());
+      begin = end;
+    }
+  // fragments IP would have sent for the update in a single packet
+  uint32_t ipPayload = GetUpdateSize (updates.size ()) + 8;
+  uint32_t fragmentPayload = (mtu - 20) & ~7u;
+  uint32_t fragmentsAvoided = ipPayload + 20 > mtu ? (ipPayload + fragmentPayload - 1) / fragmentPayload : 0;
+  m_fragmentsAvoided += fragmentsAvoided;
+  m_updateSplitTrace (packets, fragmentsAvoided);
+}
+
+uint32_t
+RoutingProtocol::GetEntriesPerPacket (uint32_t mtu) const
+{
+  // room left after the IP and UDP headers
+  uint32_t payload = mtu > 28 ? mtu - 28 : 0;
+  uint32_t entries;
+  if (m_enableBulkUpdates)
+    {
+      uint32_t overhead = TypeHeader ().GetSerializedSize () + BulkDsdvHeader::COUNT_SIZE;
+      entries = payload > overhead ? (payload - overhead) / BulkDsdvHeader::ENTRY_SIZE : 0;
+      entries = std::min<uint32_t> (entries, 0xffff);
+    }
+  else
+    {
+      entries = payload / DsdvBatchHeader::PAIR_SIZE;
+    }
+  return std::max<uint32_t> (entries, 1);
+}
+
+uint32_t
+RoutingProtocol::GetUpdateSize (uint32_t entries) const
+{
+  if (m_enableBulkUpdates)
+    {
+      return TypeHeader ().GetSerializedSize () + BulkDsdvHeader::COUNT_SIZE + entries * BulkDsdvHeader::ENTRY_SIZE;
+    }
+  return entries * DsdvBatchHeader::PAIR_SIZE;
+}
+
+uint64_t
+RoutingProtocol::GetFragmentsAvoided () const
+{
+  return m_fragmentsAvoided;
+}
+
+uint64_t
+RoutingProtocol::GetSuppressedRequests () const
+{
+  return m_suppressedRequests;
+}
+
+uint64_t
+RoutingProtocol::GetDuplicateRequests () const
+{
+  return m_duplicateRequests;
+}
+
+Ptr<Packet>
+RoutingProtocol::BuildUpdatePacket (std::vector<DsdvHeader>::const_iterator begin,
+                                    std::vector<DsdvHeader>::const_iterator end) const
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  if (m_enableBulkUpdates)
+    {
+      BulkDsdvHeader bulkHeader;
+      for (std::vector<DsdvHeader>::const_iterator i = begin; i != end; ++i)
         {
-          destination = iface.GetBroadcast ();
+          bulkHeader.AddEntry (*i);
         }
-      socket->SendTo (packet, 0, InetSocketAddress (destination, DSDV_PORT));
-      NS_LOG_FUNCTION (m_mainAddress<<": PeriodicUpdate Packet UID is : " << packet->GetUid ());
+      packet->AddHeader (bulkHeader);
+      TypeHeader tHeader (DSDVTYPE_BULK);
+      packet->AddHeader (tHeader);
+      return packet;
     }
-  m_periodicUpdateTimer.Schedule (m_periodicUpdateInterval + MicroSeconds (25 * m_uniformRandomVariable->GetInteger (0,1000)));
+  // adding the pairs one by one put the last route first, the batch keeps that layout
+  DsdvBatchHeader batchHeader;
+  for (std::vector<DsdvHeader>::const_iterator i = end; i != begin; )
+    {
+      batchHeader.AddEntry (*--i);
+    }
+  packet->AddHeader (batchHeader);
+  return packet;
 }
 
 void
@@ -1395,6 +1789,9 @@ RoutingProtocol::NotifyInterfaceDown (uint32_t i)
   NS_ASSERT (socket);
   socket->Close ();
   m_socketAddresses.erase (socket);
+  RemoveTriggerDamper (socket);
+  m_neighborRoutes.Clear ();
+  m_fib.InvalidateAll ();
   if (m_socketAddresses.empty ())
     {
       NS_LOG_LOGIC ("No effdsdv interfaces");
@@ -1446,6 +1843,8 @@ RoutingProtocol::NotifyRemoveAddress (uint32_t i,
   if (socket)
     {
       m_socketAddresses.erase (socket);
+      RemoveTriggerDamper (socket);
+      m_fib.InvalidateAll ();
       Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol> ();
       if (l3->GetNAddresses (i))
         {
@@ -1507,82 +1906,118 @@ RoutingProtocol::Drop (Ptr<const Packet> packet,
 }
 
 void
-RoutingProtocol::LookForQueuedPackets ()
+RoutingProtocol::RouteInstalled (Ipv4Address dst)
 {
-  NS_LOG_FUNCTION (this);
+  if (!EnableBuffering || !m_queue.Find (dst))
+    {
+      return;
+    }
+  AddressMap<EventId>::const_iterator i = m_queueDrains.find (dst);
+  if (i != m_queueDrains.end () && i->second.IsRunning ())
+    {
+      return;
+    }
+  NS_LOG_DEBUG (m_mainAddress << ": Route to " << dst << " installed, draining queued packets");
+  // the tables are still being updated, send once they are consistent
+  m_queueDrains[dst] = Simulator::ScheduleNow (&RoutingProtocol::DrainQueue,this,dst);
+}
+
+void
+RoutingProtocol::DrainQueue (Ipv4Address dst)
+{
+  NS_LOG_FUNCTION (this << dst);
+  Ptr<Ipv4Route> route = GetQueueRoute (dst);
+  if (route == 0)
+    {
+      // wait for the next route to this destination
+      m_queueDrains.erase (dst);
+      return;
+    }
+  for (uint32_t n = 0; n < m_queueDrainBurst; ++n)
+    {
+      if (!SendPacketFromQueue (dst,route))
+        {
+          break;
+        }
+    }
+  if (m_queue.Find (dst))
+    {
+      m_queueDrains[dst] = Simulator::Schedule (m_queueDrainGap,&RoutingProtocol::DrainQueue,this,dst);
+    }
+  else
+    {
+      m_queueDrains.erase (dst);
+    }
+}
+
+Ptr<Ipv4Route>
+RoutingProtocol::GetQueueRoute (Ipv4Address dst)
+{
+  RoutingTableEntry rt;
+  if (!m_routingTable.LookupRoute (dst, rt))
+    {
+      return 0;
+    }
+  // same choice as GetListOfAllRoutes: invalid routes are replaced by a valid alternative
+  if (rt.GetFlag () == RouteFlags::INVALID)
+    {
+      RoutingTableEntry altRt;
+      if (!m_altRoutingTable.LookupRoute (dst, altRt) || altRt.GetFlag () != RouteFlags::VALID)
+        {
+          return 0;
+        }
+      rt = altRt;
+    }
   Ptr<Ipv4Route> route;
-  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
-  GetListOfAllRoutes (allRoutes);
-  //m_routingTable.GetListOfAllValidRoutes(allRoutes);
-  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+  if (rt.GetHop () == 1)
     {
-      RoutingTableEntry rt;
-      rt = i->second;
-      if (m_queue.Find (rt.GetDestination ()))
+      route = GetNeighborRoute (rt);
+      NS_LOG_DEBUG (m_mainAddress<<": A route exists from " << route->GetSource ()
+                                                         << " to neighboring destination "
+                                                         << route->GetDestination ());
+    }
+  else
+    {
+      RoutingTableEntry newrt;
+      if (!LookupRoute (rt.GetNextHop (), newrt))
         {
-          if (rt.GetHop () == 1)
-            {
-              route = rt.GetRoute ();
-              NS_LOG_LOGIC (m_mainAddress<<": A route exists from " << route->GetSource ()
-                                                   << " to neighboring destination "
-                                                   << route->GetDestination ());
-              NS_LOG_DEBUG (m_mainAddress<<": A route exists from " << route->GetSource ()
-                                                                 << " to neighboring destination "
-                                                                 << route->GetDestination ());
-              NS_ASSERT (route != 0);
-            }
-          else
-            {
-              RoutingTableEntry newrt;
-              //m_routingTable.LookupRoute (rt.GetNextHop (),newrt);
-              if(LookupRoute(rt.GetNextHop (), newrt))
-              {
-            	  route = newrt.GetRoute ();
-            	                NS_LOG_LOGIC (m_mainAddress<<": A route exists from " << route->GetSource ()
-            	                                                                   << " to destination " << route->GetDestination () << " via "
-            	                                                                   << rt.GetNextHop ());
-            	                NS_LOG_DEBUG (m_mainAddress<<": A route exists from " << route->GetSource ()
-            	                                                     << " to destination " << route->GetDestination () << " via "
-            	                                                     << rt.GetNextHop ());
-            	                NS_ASSERT (route != 0);
-              } else {
-            	  continue;
-              }
-            }
-          SendPacketFromQueue (rt.GetDestination (),route);
+          return 0;
         }
+      route = GetNeighborRoute (newrt);
+      NS_LOG_DEBUG (m_mainAddress<<": A route exists from " << route->GetSource ()
+                                                         << " to destination " << dst << " via "
+                                                         << rt.GetNextHop ());
     }
+  NS_ASSERT (route != 0);
+  return route;
 }
 
-void
+bool
 RoutingProtocol::SendPacketFromQueue (Ipv4Address dst,
                                       Ptr<Ipv4Route> route)
 {
   NS_LOG_DEBUG (m_mainAddress << " is sending a queued packet to destination " << dst);
   QueueEntry queueEntry;
-  if (m_queue.Dequeue (dst,queueEntry))
+  if (!m_queue.Dequeue (dst,queueEntry))
     {
-      DeferredRouteOutputTag tag;
-      Ptr<Packet> p = ConstCast<Packet> (queueEntry.GetPacket ());
-      if (p->RemovePacketTag (tag))
-        {
-          if (tag.oif != -1 && tag.oif != m_ipv4->GetInterfaceForDevice (route->GetOutputDevice ()))
-            {
-              NS_LOG_DEBUG (m_mainAddress<<": Output device doesn't match. Dropped.");
-              return;
-            }
-        }
-      UnicastForwardCallback ucb = queueEntry.GetUnicastForwardCallback ();
-      Ipv4Header header = queueEntry.GetIpv4Header ();
-      header.SetSource (route->GetSource ());
-      header.SetTtl (header.GetTtl () + 1); // compensate extra TTL decrement by fake loopback routing
-      ucb (route,p,header);
-      if (m_queue.GetSize () != 0 && m_queue.Find (dst))
+      return false;
+    }
+  DeferredRouteOutputTag tag;
+  Ptr<Packet> p = ConstCast<Packet> (queueEntry.GetPacket ());
+  if (p->RemovePacketTag (tag))
+    {
+      if (tag.oif != -1 && tag.oif != m_ipv4->GetInterfaceForDevice (route->GetOutputDevice ()))
         {
-          Simulator::Schedule (MilliSeconds (m_uniformRandomVariable->GetInteger (0,100)),
-                               &RoutingProtocol::SendPacketFromQueue,this,dst,route);
+          NS_LOG_DEBUG (m_mainAddress<<": Output device doesn't match. Dropped.");
+          return true;
         }
     }
+  UnicastForwardCallback ucb = queueEntry.GetUnicastForwardCallback ();
+  Ipv4Header header = queueEntry.GetIpv4Header ();
+  header.SetSource (route->GetSource ());
+  header.SetTtl (header.GetTtl () + 1); // compensate extra TTL decrement by fake loopback routing
+  ucb (route,p,header);
+  return true;
 }
 
 Time
@@ -1615,31 +2050,45 @@ void
 RoutingProtocol::MergeTriggerPeriodicUpdates ()
 {
   NS_LOG_FUNCTION (m_mainAddress<<": Merging advertised table changes with main table before sending out periodic update");
-  std::map<Ipv4Address, RoutingTableEntry> allRoutes;
-  m_advRoutingTable.GetListOfAllValidRoutes (allRoutes);
-  if (allRoutes.size () > 0)
+  GetDirtyRoutes (m_dirtyRoutes);
+  for (std::vector<RoutingTableEntry>::iterator i = m_dirtyRoutes.begin (); i != m_dirtyRoutes.end (); ++i)
     {
-      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = allRoutes.begin (); i != allRoutes.end (); ++i)
+      Ipv4Address dst = i->GetDestination ();
+      if (!(i->GetSeqNo () % 2))
         {
-          RoutingTableEntry advEntry = i->second;
-          if ((advEntry.GetEntriesChanged () == true) && (!m_advRoutingTable.AnyRunningEvent (advEntry.GetDestination ())))
-            {
-              if (!(advEntry.GetSeqNo () % 2))
-                {
-                  advEntry.SetFlag (VALID);
-                  advEntry.SetEntriesChanged (false);
-                  m_routingTable.Update (advEntry);
-                  NS_LOG_DEBUG (m_mainAddress<<": Merged update for " << advEntry.GetDestination () << " with main routing Table");
-                }
-              m_advRoutingTable.DeleteRoute (advEntry.GetDestination ());
-            }
-          else
-            {
-              NS_LOG_DEBUG ("Event currently running. Cannot Merge Routing Tables");
-            }
+          i->SetFlag (VALID);
+          i->SetEntriesChanged (false);
+          m_routingTable.Update (*i);
+          NS_LOG_DEBUG (m_mainAddress<<": Merged update for " << dst << " with main routing Table");
         }
+      m_advRoutingTable.DeleteRoute (dst);
     }
 }
+
+void
+RoutingProtocol::GetDirtyRoutes (std::vector<RoutingTableEntry> & routes)
+{
+  routes.clear ();
+  m_advRoutingTable.GetChangedDestinations (m_changedDestinations);
+  for (std::vector<Ipv4Address>::const_iterator i = m_changedDestinations.begin (); i
+       != m_changedDestinations.end (); ++i)
+    {
+      RoutingTableEntry rt;
+      if (*i == Ipv4Address::GetLoopback () || !m_advRoutingTable.LookupRoute (*i, rt) || rt.GetFlag () != VALID)
+        {
+          continue;
+        }
+      if (m_settlingScheduler.IsPending (*i))
+        {
+          NS_LOG_DEBUG (m_mainAddress<<": Settling time of " << *i << " ends at "
+                                     << m_settlingScheduler.GetDeadline (*i).GetSeconds ()
+                                     << "s, waiting in adv table");
+          continue;
+        }
+      routes.push_back (rt);
+    }
+}
+
 bool
 RoutingProtocol::IsMyOwnAddress (Ipv4Address src)
 {
@@ -1659,22 +2108,23 @@ RoutingProtocol::IsMyOwnAddress (Ipv4Address src)
 void
 RoutingProtocol::InvalidateOverNextHop (Ipv4Address nextHop)
 {
-	std::map<Ipv4Address, RoutingTableEntry> dstsWithNextHopSrc, altDstsWithNextHopSrc;
-	m_routingTable.GetListOfDestinationWithNextHop (nextHop,dstsWithNextHopSrc);
-	for (std::map<Ipv4Address, RoutingTableEntry>::iterator k = dstsWithNextHopSrc.begin (); k
-						  != dstsWithNextHopSrc.end (); ++k)
+	// Update keeps the next hop, so the index is not modified while iterating
+	RoutingTable::DestinationRange range = m_routingTable.GetDestinationsWithNextHop (nextHop);
+	for (std::vector<Ipv4Address>::const_iterator k = range.first; k != range.second; ++k)
 	{
-		RoutingTableEntry t = k->second;
-		NS_LOG_DEBUG (m_mainAddress<<": A route ("<<k->second.GetDestination()<<") using "<<nextHop<<" as next hop has also been invalidated");
+		RoutingTableEntry t;
+		m_routingTable.LookupRoute (*k, t);
+		NS_LOG_DEBUG (m_mainAddress<<": A route ("<<*k<<") using "<<nextHop<<" as next hop has also been invalidated");
 		t.SetFlag(RouteFlags::INVALID);
 		m_routingTable.Update(t);
 	}
-	m_altRoutingTable.GetListOfDestinationWithNextHop (nextHop,altDstsWithNextHopSrc);
-	for (std::map<Ipv4Address, RoutingTableEntry>::iterator k = altDstsWithNextHopSrc.begin (); k
+	range = m_altRoutingTable.GetDestinationsWithNextHop (nextHop);
+	std::vector<Ipv4Address> altDstsWithNextHopSrc (range.first, range.second);
+	for (std::vector<Ipv4Address>::const_iterator k = altDstsWithNextHopSrc.begin (); k
 						  != altDstsWithNextHopSrc.end (); ++k)
 	{
-		NS_LOG_DEBUG (m_mainAddress<<": Subsequently, matching alternative routes have been deleted:"<< k->second.GetDestination());
-		m_altRoutingTable.DeleteRoute(k->second.GetDestination());
+		NS_LOG_DEBUG (m_mainAddress<<": Subsequently, matching alternative routes have been deleted:"<< *k);
+		DeleteAlternativeRoute (*k);
 	}
 }
 
@@ -1696,6 +2146,121 @@ RoutingProtocol::IsRouteAlive(RoutingTableEntry rt, double bufferInSec)
 	}
 }
 
+Time
+RoutingProtocol::GetLookupDeadline (Ipv4Address dst)
+{
+  // mirrors the branches of LookupRoute that return the main route as it is
+  RoutingTableEntry rt, nextHop;
+  if (!m_routingTable.LookupRoute (dst, rt))
+    {
+      return Time ();
+    }
+  if (rt.GetNextHop () != dst && !m_routingTable.LookupRoute (rt.GetNextHop (), nextHop))
+    {
+      return Time ();
+    }
+  // the route used as long as the next hop is alive, which is the route itself for a neighbor
+  RoutingTableEntry const & alive = rt.GetNextHop () == dst ? rt : nextHop;
+  if (alive.GetFlag () != VALID)
+    {
+      return Time ();
+    }
+  return Simulator::Now () - alive.GetLifeTime () + m_periodicUpdateInterval + Seconds (2);
+}
+
+void
+RoutingProtocol::InstallForwardingRoute (Ipv4Address dst, Ptr<Ipv4Route> route)
+{
+  RoutingTableEntry rt;
+  if (!m_routingTable.LookupRoute (dst, rt, true))
+    {
+      return;
+    }
+  Ipv4Address nextHop = rt.GetNextHop ();
+  Time deadline = GetLookupDeadline (dst);
+  if (nextHop != dst)
+    {
+      // RouteOutput and RouteInput only agree on routes whose next hop is a neighbor
+      RoutingTableEntry neighbor;
+      if (rt.GetHop () == 1 || !m_routingTable.LookupRoute (nextHop, neighbor) || neighbor.GetNextHop () != nextHop)
+        {
+          return;
+        }
+      deadline = std::min (deadline, GetLookupDeadline (nextHop));
+    }
+  if (deadline > Simulator::Now ())
+    {
+      m_fib.Install (dst, route, deadline);
+    }
+}
+
+bool
+RoutingProtocol::IsNeighborHeard (Ipv4Address neighbor, double bufferInSec) const
+{
+  AddressMap<Time>::const_iterator i = m_lastHeard.find (neighbor);
+  return i != m_lastHeard.end ()
+         && Simulator::Now () - i->second <= m_periodicUpdateInterval + Seconds (bufferInSec);
+}
+
+bool
+RoutingProtocol::SelectAlternative (Ipv4Address dst, RoutingTableEntry & altRt)
+{
+  RoutingTableEntry candidate;
+  bool dropped = false;
+  while (m_altRoutes.GetBest (dst, candidate))
+    {
+      // the next hop must still be reachable itself, with a live route or at least heard from lately
+      RoutingTableEntry nextHop;
+      bool nextHopLost;
+      if (m_routingTable.LookupRoute (candidate.GetNextHop (), nextHop))
+        {
+          nextHopLost = !IsRouteAlive (nextHop, 2);
+        }
+      else
+        {
+          nextHopLost = !IsNeighborHeard (candidate.GetNextHop (), 2);
+        }
+      bool stale = candidate.GetInstallTime ().GetSeconds () > (m_periodicUpdateInterval.GetSeconds () / 3) + 2;
+      if (!nextHopLost && !stale)
+        {
+          if (candidate.GetNextHop () != altRt.GetNextHop ())
+            {
+              if (dropped)
+                {
+                  // fail over without waiting for another RACK
+                  NS_LOG_DEBUG (m_mainAddress<<": Fail over to alternative Route to "<<dst<<" via "<<candidate.GetNextHop ());
+                  m_alternativeFailovers++;
+                }
+              if (!m_altRoutingTable.Update (candidate))
+                {
+                  m_altRoutingTable.AddRoute (candidate);
+                }
+            }
+          altRt = candidate;
+          return true;
+        }
+      NS_LOG_DEBUG (m_mainAddress<<": Drop alternative Route to "<<dst<<" via "<<candidate.GetNextHop ()
+                                 <<(stale ? ", too old" : ", next hop lost"));
+      m_altRoutes.Remove (dst, candidate.GetNextHop ());
+      dropped = true;
+    }
+  return false;
+}
+
+void
+RoutingProtocol::DeleteAlternativeRoute (Ipv4Address dst)
+{
+  m_altRoutingTable.DeleteRoute (dst);
+  // the candidates must not outlive the route, SelectAlternative would bring them back
+  m_altRoutes.Erase (dst);
+}
+
+uint64_t
+RoutingProtocol::GetAlternativeFailovers () const
+{
+  return m_alternativeFailovers;
+}
+
 bool
 RoutingProtocol::LookupRoute (Ipv4Address id,
                            RoutingTableEntry & rt)
@@ -1740,6 +2305,14 @@ RoutingProtocol::LookupRoute (Ipv4Address id,
 			  }
 			  else if (altRt.GetFlag()==RouteFlags::VALID)
 			  {
+				  if (!SelectAlternative(id,altRt))
+				  {
+					  //every known alternative is stale or leads over a lost neighbor
+					  NS_LOG_DEBUG(m_mainAddress<<": No usable alternative Route to "<<id<<" left, sending out request");
+					  DeleteAlternativeRoute (id);
+					  SendRouteRequest(id);
+					  return false;
+				  }
 				  //return the alternative route
 				  NS_LOG_DEBUG (m_mainAddress<<": Found an alternative Route to "<< id <<" via "<<altRt.GetNextHop()<<" instead of "<<rt.GetNextHop());
 				  rt.SetSettlingTime(altRt.GetSettlingTime());
@@ -1750,18 +2323,12 @@ RoutingProtocol::LookupRoute (Ipv4Address id,
 				  rt.SetLifeTime(altRt.GetLifeTime());
 				  rt.SetInterface(altRt.GetInterface());
 				  rt.SetOutputDevice(altRt.GetOutputDevice());
-				  rt.SetRoute(altRt.GetRoute());
 
 				  if (altRt.GetInstallTime().GetSeconds()>(m_periodicUpdateInterval.GetSeconds()/3))
 				  {
 					  NS_LOG_DEBUG(m_mainAddress<<": Alternative route to "<<id<<" installed at "<<altRt.GetInstallTime().GetSeconds()<<" sec. ago, requesting more recent information...");
 					  SendRouteRequest(id);
 				  }
-				  if (altRt.GetInstallTime().GetSeconds()>(m_periodicUpdateInterval.GetSeconds()/3)+2)
-				  {
-					  m_altRoutingTable.DeleteRoute(altRt.GetDestination());
-					  return false;
-				  }
 				  return true;
 			  }
 		  }
@@ -1822,6 +2389,14 @@ RoutingProtocol::LookupRoute (Ipv4Address id,
 				  }
 				  else if (altRt.GetFlag()==RouteFlags::VALID)
 				  {
+					  if (!SelectAlternative(id,altRt))
+					  {
+						  //every known alternative is stale or leads over a lost neighbor
+						  NS_LOG_DEBUG(m_mainAddress<<": No usable alternative Route to "<<id<<" left, sending out request");
+						  DeleteAlternativeRoute (id);
+						  SendRouteRequest(id);
+						  return false;
+					  }
 					  //return the alternative route
 					  NS_LOG_DEBUG (m_mainAddress<<": Found an alternative Route to "<< id <<" via "<<altRt.GetNextHop()<<" instead of "<<rt.GetNextHop());
 					  rt.SetSettlingTime(altRt.GetSettlingTime());
@@ -1832,17 +2407,11 @@ RoutingProtocol::LookupRoute (Ipv4Address id,
 					  				  rt.SetLifeTime(altRt.GetLifeTime());
 					  				  rt.SetInterface(altRt.GetInterface());
 					  				  rt.SetOutputDevice(altRt.GetOutputDevice());
-					  				  rt.SetRoute(altRt.GetRoute());
 					  if (altRt.GetInstallTime().GetSeconds()>(m_periodicUpdateInterval.GetSeconds()/3))
 					  {
 						  NS_LOG_DEBUG(m_mainAddress<<": Alternative route to "<<id<<" installed at "<<altRt.GetInstallTime().GetSeconds()<<" sec. ago, requesting more recent information...");
 						  SendRouteRequest(id);
 					  }
-					  if (altRt.GetInstallTime().GetSeconds()>(m_periodicUpdateInterval.GetSeconds()/3)+2)
-					  {
-						  m_altRoutingTable.DeleteRoute(altRt.GetDestination());
-						  return false;
-					  }
 					  return true;
 				  }
 			  }
@@ -2035,41 +2604,27 @@ RoutingProtocol::LookupRoute (Ipv4Address id,
 void
 RoutingProtocol::GetListOfAllRoutes (std::map<Ipv4Address, RoutingTableEntry> & allRoutes)
 {
-	std::map<Ipv4Address, RoutingTableEntry>  routeCollection;
-	m_routingTable.GetListOfAllRoutes(routeCollection);
-	if (!routeCollection.empty())
+	if (m_routingTable.Begin (RoutingTable::ALL_ROUTES) == m_routingTable.End ())
 	{
-		for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = routeCollection.begin (); i != routeCollection.end (); ++i)
-		{
-			RoutingTableEntry rte;
-			rte = i->second;
-			if (rte.GetFlag()==RouteFlags::INVALID){
-				RoutingTableEntry altRte;
-				if (m_altRoutingTable.LookupRoute(rte.GetDestination(),altRte))
+		NS_LOG_DEBUG (m_mainAddress<<": No entries in main Routing Table");
+		return;
+	}
+	for (RoutingTable::RouteIterator i = m_routingTable.Begin (RoutingTable::ALL_ROUTES); i != m_routingTable.End (); ++i)
+	{
+		if (i->GetFlag()==RouteFlags::INVALID){
+			RoutingTableEntry altRte;
+			if (m_altRoutingTable.LookupRoute(i->GetDestination(),altRte))
+			{
+				if (altRte.GetFlag()==RouteFlags::VALID)
 				{
-					if (altRte.GetFlag()==RouteFlags::VALID)
-					{
-//						rte.SetFlag(altRte.GetFlag());
-//						rte.SetHop(altRte.GetHop());
-//						rte.SetNextHop(altRte.GetNextHop());
-//						rte.SetSeqNo(altRte.GetSeqNo());
-//						rte.SetLifeTime(altRte.GetLifeTime());
-//						rte.SetInterface(altRte.GetInterface());
-//						rte.SetOutputDevice(altRte.GetOutputDevice());
-//						rte.SetRoute(altRte.GetRoute());
-						allRoutes.insert(std::make_pair(altRte.GetDestination(),altRte));
-					}
+					allRoutes.insert(std::make_pair(altRte.GetDestination(),altRte));
 				}
 			}
-			else
-			{
-				allRoutes.insert(std::make_pair(i->first,i->second));
-			}
 		}
-	}
-	else
-	{
-		NS_LOG_DEBUG (m_mainAddress<<": No entries in main Routing Table");
+		else
+		{
+			allRoutes.insert(std::make_pair(i->GetDestination(),*i));
+		}
 	}
 }
 
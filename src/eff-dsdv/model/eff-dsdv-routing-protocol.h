@@ -25,12 +25,21 @@
 #include "eff-dsdv-rtable.h"
 #include "eff-dsdv-packet-queue.h"
 #include "eff-dsdv-packet.h"
+#include "eff-dsdv-neighbor-table.h"
+#include "eff-dsdv-settling-scheduler.h"
+#include "eff-dsdv-trigger-damper.h"
+#include "eff-dsdv-rreq-cache.h"
+#include "eff-dsdv-alt-routes.h"
+#include "eff-dsdv-forwarding-table.h"
 #include "ns3/node.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-interface.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/traced-callback.h"
+
+struct EffDsdvProtocolTestCase;
 
 namespace ns3 {
 namespace effdsdv {
@@ -49,6 +58,44 @@ public:
   static TypeId GetTypeId (void);
   static const uint32_t DSDV_PORT;
 
+  /**
+   * TracedCallback signature for the number of settled changes sent in a triggered update.
+   *
+   * \param [in] count the number of routes in the update
+   */
+  typedef void (* DirtyEntriesTracedCallback)(uint32_t count);
+  /**
+   * TracedCallback signature for triggered updates that did not go out at once.
+   *
+   * \param [in] reason why the update was held back
+   */
+  typedef void (* TriggerSuppressedTracedCallback)(TriggerDamper::SuppressReason reason);
+  /**
+   * TracedCallback signature for updates sent on an interface.
+   *
+   * \param [in] packets the number of MTU-sized packets the update was split into
+   * \param [in] fragmentsAvoided the IP fragments sending it as one packet would have caused, 0 if it fits
+   */
+  typedef void (* UpdateSplitTracedCallback)(uint32_t packets, uint32_t fragmentsAvoided);
+  /**
+   * TracedCallback signature for packets dropped from the buffer.
+   *
+   * \param [in] packet the dropped packet
+   * \param [in] header its IP header
+   * \param [in] reason why it was dropped
+   */
+  typedef void (* QueueDropTracedCallback)(Ptr<const Packet> packet, Ipv4Header const & header,
+                                           PacketQueue::DropReason reason);
+  /**
+   * TracedCallback signature for packets leaving the buffer towards their route.
+   *
+   * \param [in] packet the packet
+   * \param [in] header its IP header
+   * \param [in] sojourn the time it spent in the buffer
+   */
+  typedef void (* QueueDequeueTracedCallback)(Ptr<const Packet> packet, Ipv4Header const & header,
+                                              Time sojourn);
+
   /// c-tor
   RoutingProtocol ();
   virtual
@@ -121,6 +168,42 @@ public:
    * \returns the enable route aggregation (RA) flag
    */
   bool GetEnableRAFlag () const;
+  /**
+   * Get the counters of the packet buffer
+   * \returns drops by reason, enqueue/dequeue counts, high-water marks and sojourn times
+   */
+  PacketQueue::Stats const & GetQueueStats () const;
+  /**
+   * Get the forwarding table of the data path
+   * \returns the forwarding table
+   */
+  ForwardingTable const & GetForwardingTable () const;
+  /**
+   * Get the number of IP fragments avoided by splitting updates
+   * \returns the fragments that unsplit updates would have caused so far
+   */
+  uint64_t GetFragmentsAvoided () const;
+  /**
+   * Get the number of route requests held back by the retry backoff
+   * \returns the number of route requests not sent so far
+   */
+  uint64_t GetSuppressedRequests () const;
+  /**
+   * Get the number of received route requests dropped as duplicates
+   * \returns the number of duplicate route requests so far
+   */
+  uint64_t GetDuplicateRequests () const;
+  /**
+   * Get the number of times a lookup switched to another alternative route
+   * \returns the number of fail overs so far
+   */
+  uint64_t GetAlternativeFailovers () const;
+  /**
+   * Get the number of triggered updates that did not go out at once
+   * \param reason why they were held back
+   * \returns the number of triggered updates so far
+   */
+  uint64_t GetSuppressedTriggers (TriggerDamper::SuppressReason reason) const;
 
   /**
    * Assign a fixed random variable stream number to the random variables
@@ -133,6 +216,9 @@ public:
   int64_t AssignStreams (int64_t stream);
 
 private:
+  /// Drives the protocol in the tests
+  friend struct ::EffDsdvProtocolTestCase;
+
   // Protocol parameters.
   /// Holdtimes is the multiplicative factor of PeriodicUpdateInterval for which the node waits since the last update
   /// before flushing a route from the routing table. If PeriodicUpdateInterval is 8s and Holdtimes is 3, the node
@@ -141,6 +227,12 @@ private:
   /// PeriodicUpdateInterval specifies the periodic time interval between which the a node broadcasts
   /// its entire routing table.
   Time m_periodicUpdateInterval;
+  /// Every how many periodic updates the whole routing table is advertised
+  uint32_t m_fullDumpInterval;
+  /// Number of periodic updates sent so far
+  uint32_t m_periodicUpdates;
+  /// What was last advertised for each destination, to find the changes for incremental dumps
+  AddressMap<DsdvHeader> m_lastAdvertised;
   /// SettlingTime specifies the time for which a node waits before propagating an update.
   /// It waits for this time interval in hope of receiving an update with a better metric.
   Time m_settlingTime;
@@ -154,20 +246,50 @@ private:
   Ptr<NetDevice> m_lo;
   /// Main Routing table for the node
   RoutingTable m_routingTable;
-  /// Advertised Routing table for the node
+  /// Advertised Routing table for the node, shares the store of m_routingTable
   RoutingTable m_advRoutingTable;
-  /// Alternative Routing table for the node
+  /// Alternative Routing table for the node, shares the store of m_routingTable
   RoutingTable m_altRoutingTable;
+  /// Decodes received control packets, its message vector is reused for every packet
+  ControlPacketParser m_parser;
+  /// Routes handed to the IP layer, one per neighbor and device
+  NeighborTable m_neighborRoutes;
+  /// Time a control packet was last received from each neighbor
+  AddressMap<Time> m_lastHeard;
+  /// Holds back advertisements of changed metrics until their settling time has passed
+  SettlingScheduler m_settlingScheduler;
+  /// Scratch space for the changed destinations of the advertised table
+  std::vector<Ipv4Address> m_changedDestinations;
+  /// Scratch space for the routes ready to be advertised
+  std::vector<RoutingTableEntry> m_dirtyRoutes;
+  /// Number of settled changes carried by each triggered update
+  TracedCallback<uint32_t> m_dirtyEntriesTrace;
   /// The maximum number of packets that we allow a routing protocol to buffer.
   uint32_t m_maxQueueLen;
   /// The maximum number of packets that we allow per destination to buffer.
   uint32_t m_maxQueuedPacketsPerDst;
+  /// The maximum number of bytes that we allow a routing protocol to buffer.
+  uint32_t m_maxQueueBytes;
   /// The maximum period of time that a routing protocol is allowed to buffer a packet for.
   Time m_maxQueueTime;
+  /// What the buffer drops when a packet does not fit
+  PacketQueue::DropPolicy m_queueDropPolicy;
+  /// The longest time a packet may be buffered under the Sojourn drop policy
+  Time m_queueSojournTarget;
   /// A "drop front on full" queue used by the routing layer to buffer packets to which it does not have a route.
   PacketQueue m_queue;
+  /// Packets dropped from the buffer
+  TracedCallback<Ptr<const Packet>, Ipv4Header const &, PacketQueue::DropReason> m_queueDropTrace;
+  /// Packets leaving the buffer towards their route
+  TracedCallback<Ptr<const Packet>, Ipv4Header const &, Time> m_queueDequeueTrace;
   /// Flag that is used to enable or disable buffering
   bool EnableBuffering;
+  /// Number of queued packets sent at once when a route becomes available
+  uint32_t m_queueDrainBurst;
+  /// Gap between two bursts of queued packets
+  Time m_queueDrainGap;
+  /// Pending drain event per destination with queued packets
+  AddressMap<EventId> m_queueDrains;
   /// Flag that is used to enable or disable Weighted Settling Time
   bool EnableWST;
   /// This is the wighted factor to determine the weighted settling time
@@ -177,6 +299,64 @@ private:
   bool EnableRouteAggregation;
   /// Parameter that holds the route aggregation time interval
   Time m_routeAggregationTime;
+  /// Send updates as one bulk message instead of one DSDV message per route
+  bool m_enableBulkUpdates;
+  /// Time over which the packets of a split update are spread
+  Time m_updateSpreadWindow;
+  /// Minimum time between two triggered updates on an interface
+  Time m_triggerMinInterval;
+  /// Average bytes per second of triggered updates per interface, 0 for no limit
+  uint32_t m_triggerRate;
+  /// Bytes of triggered updates an interface may send at once
+  uint32_t m_triggerBurst;
+  /// Paces the triggered updates of each interface
+  std::map<Ptr<Socket>, Ptr<TriggerDamper> > m_triggerDampers;
+  /// The next scheduled triggered update
+  EventId m_triggeredUpdateEvent;
+  /// Triggered updates that did not go out at once, by reason
+  uint64_t m_suppressedTriggers[TriggerDamper::SUPPRESS_REASONS];
+  /// Triggered updates that did not go out at once
+  TracedCallback<TriggerDamper::SuppressReason> m_triggerSuppressedTrace;
+  /// IP fragments avoided by splitting updates
+  uint64_t m_fragmentsAvoided;
+  /// Route requests held back by the retry backoff
+  uint64_t m_suppressedRequests;
+  /// Received route requests dropped as duplicates
+  uint64_t m_duplicateRequests;
+  /// ID of the last route request sent
+  uint16_t m_requestId;
+  /// Lookups that switched to another alternative route
+  uint64_t m_alternativeFailovers;
+  /// Number of alternative routes kept per destination
+  uint32_t m_maxAlternatives;
+  /// Ranked alternative routes per destination, the best one mirrored in m_altRoutingTable
+  AlternativeRoutes m_altRoutes;
+  /// Ready-made routes resolved from the main routing table
+  ForwardingTable m_fib;
+  /// Wait after the first route request for a destination
+  Time m_rreqRetryInterval;
+  /// Upper bound of the wait between route requests for a destination
+  Time m_rreqRetryMaxInterval;
+  /// How long a received route request is remembered
+  Time m_rreqIdLifetime;
+  /// Spaces out the route requests for each destination
+  RreqBackoff m_rreqBackoff;
+  /// Route requests received recently, by sender and request ID
+  RreqIdCache m_rreqIdCache;
+  /// Time route requests are collected before they are sent as one
+  Time m_rreqBatchWindow;
+  /// Time route acks for the same requester are collected before they are sent as one
+  Time m_rackBatchWindow;
+  /// Destinations to request routes for with the next route request
+  std::vector<Ipv4Address> m_requestBatch;
+  /// Sends the collected route requests
+  EventId m_requestBatchEvent;
+  /// requester -> routes to acknowledge to it
+  AddressMap<std::vector<RoutingTableEntry> > m_ackBatch;
+  /// Sends the collected route acks
+  EventId m_ackBatchEvent;
+  /// Number of packets and avoided fragments of each update sent on an interface
+  TracedCallback<uint32_t, uint32_t> m_updateSplitTrace;
   /// Unicast callback for own packets
   UnicastForwardCallback m_scb;
   /// Error callback for own packets
@@ -195,15 +375,34 @@ private:
    */
   void
   DeferredRouteOutput (Ptr<const Packet> p, const Ipv4Header & header, UnicastForwardCallback ucb, ErrorCallback ecb);
-  /// Look for any queued packets to send them out
+  /**
+   * Start draining the queued packets of a destination, notified by the routing tables
+   * whenever a route becomes usable
+   * \param dst the destination of the route
+   */
+  void
+  RouteInstalled (Ipv4Address dst);
+  /**
+   * Send up to QueueDrainBurst queued packets to a destination and come back after
+   * QueueDrainGap while packets are left
+   * \param dst the destination
+   */
   void
-  LookForQueuedPackets (void);
+  DrainQueue (Ipv4Address dst);
+  /**
+   * Get the route queued packets to a destination are sent over
+   * \param dst the destination
+   * \returns the route, or 0 if there is no usable route
+   */
+  Ptr<Ipv4Route>
+  GetQueueRoute (Ipv4Address dst);
   /**
    * Send packet from queue
    * \param dst - destination address to which we are sending the packet to
    * \param route - route identified for this packet
+   * \returns false if no packet was queued for the destination
    */
-  void
+  bool
   SendPacketFromQueue (Ipv4Address dst, Ptr<Ipv4Route> route);
   /**
    * Find socket with local interface address iface
@@ -220,27 +419,31 @@ private:
    void RecvEffDsdv (Ptr<Socket> socket);
 
   /**
-   * Receive and process dsdv control packet
-   * \param packet the dsdv packets
+   * Process one advertised route
+   * \param dsdvHeader destination, hop count and sequence number of the route
    * \param receiver Ipv4Address of the receiver
    * \param src the Ipv4Address of the sender
    */
   void
-  RecvDsdv (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src);
+  ProcessUpdate (DsdvHeader const & dsdvHeader, Ipv4Address receiver, Ipv4Address src);
 
   /*
-   * Receive and process RREQ packets
+   * Receive and process RREQ messages
    */
-  void RecvRouteRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src);
+  void RecvRouteRequest (RreqHeader const & rreqHeader, Ipv4Address receiver, Ipv4Address src);
 
   /*
-   * Receive and process RREP packets
+   * Receive and process RACK messages
    */
-  void RecvRouteAck (Ptr<Packet> p, Ipv4Address my,Ipv4Address src);
+  void RecvRouteAck (RackHeader rackHeader, Ipv4Address my,Ipv4Address src);
 
 
   /// Send RREQ
   void SendRouteRequest (Ipv4Address dst);
+  /// Send one RREQ for all destinations collected during the batching window
+  void SendRequestBatch ();
+  /// Send one RACK to each requester for all acks collected during the batching window
+  void SendAckBatch ();
   /// Send RACK
   void SendRouteAck (RoutingTableEntry const & toDst, Ipv4Address requester,Ipv4Address acknowledger);
 
@@ -265,6 +468,39 @@ private:
   void Invalidate(RoutingTableEntry rt);
   void InvalidateOverNextHop (Ipv4Address nextHop);
   bool IsRouteAlive(RoutingTableEntry rt, double bufferInSec);
+  /**
+   * Test whether a neighbor was heard from recently, like a route is alive
+   * when it was updated within a periodic update interval plus a buffer
+   * \param neighbor the neighbor
+   * \param bufferInSec the buffer added to the periodic update interval
+   * \returns true if a control packet was received from the neighbor in time
+   */
+  bool IsNeighborHeard (Ipv4Address neighbor, double bufferInSec) const;
+  /**
+   * Pick the best alternative route whose next hop is not known to be lost,
+   * dropping the unusable ones, and install it in the alternative table
+   * \param dst the destination
+   * \param altRt the current alternative route, replaced by the one picked
+   * \returns false if no usable alternative is left
+   */
+  bool SelectAlternative (Ipv4Address dst, RoutingTableEntry & altRt);
+  /**
+   * Delete the alternative route to a destination together with its ranked candidates
+   * \param dst the destination
+   */
+  void DeleteAlternativeRoute (Ipv4Address dst);
+  /**
+   * Get the time until which LookupRoute keeps resolving a destination to its main route
+   * \param dst the destination
+   * \returns the time, zero if LookupRoute does not resolve it to the main route now
+   */
+  Time GetLookupDeadline (Ipv4Address dst);
+  /**
+   * Cache a route resolved by the data path if it stems from the main table alone
+   * \param dst the destination
+   * \param route the route resolved for it
+   */
+  void InstallForwardingRoute (Ipv4Address dst, Ptr<Ipv4Route> route);
   bool LookupRoute (Ipv4Address id, RoutingTableEntry & rt);
   bool LookupRoute (Ipv4Address id, RoutingTableEntry & rt, bool forRouteInput);
 
@@ -277,6 +513,14 @@ private:
    */
   Ptr<Ipv4Route>
   LoopbackRoute (const Ipv4Header & header, Ptr<NetDevice> oif) const;
+  /**
+   * Get the shared route towards the next hop of an entry
+   *
+   * \param rt the routing table entry of the neighbor
+   * \returns the route
+   */
+  Ptr<Ipv4Route>
+  GetNeighborRoute (RoutingTableEntry const & rt);
 
   /**
     * Lookup list of all addresses in the routing table
@@ -295,12 +539,98 @@ private:
   /// Sends trigger update from a node
   void
   SendTriggeredUpdate ();
+  /**
+   * Send a triggered update after a delay, unless one is already due by then
+   * \param delay the delay
+   */
+  void
+  ScheduleTriggeredUpdate (Time delay);
+  /**
+   * Get the damper of an interface, creating it on first use
+   * \param socket the socket of the interface
+   * \param iface the interface address
+   * \returns the damper
+   */
+  Ptr<TriggerDamper>
+  GetTriggerDamper (Ptr<Socket> socket, Ipv4InterfaceAddress const & iface);
+  /**
+   * Drop the damper of a closed interface
+   * \param socket the socket of the interface
+   */
+  void
+  RemoveTriggerDamper (Ptr<Socket> socket);
+  /**
+   * Send the update a damper released
+   * \param iface the interface
+   * \param updates the advertised routes
+   */
+  void
+  FlushTriggeredUpdate (Ipv4InterfaceAddress iface, std::vector<DsdvHeader> const & updates);
+  /**
+   * Count and trace a triggered update that did not go out at once
+   * \param reason why it was held back
+   */
+  void
+  NotifyTriggerSuppressed (TriggerDamper::SuppressReason reason);
   /// Broadcasts the entire routing table for every PeriodicUpdateInterval
   void
   SendPeriodicUpdate ();
+  /**
+   * Send an update on one interface, split into packets that fit the MTU of its device
+   * \param socket the socket of the interface
+   * \param iface the interface address
+   * \param updates the advertised routes
+   */
+  void
+  SendUpdate (Ptr<Socket> socket, Ipv4InterfaceAddress const & iface, std::vector<DsdvHeader> const & updates);
+  /**
+   * Get the number of update entries that fit into one packet
+   * \param mtu the MTU of the output device
+   * \returns the number of entries, at least one
+   */
+  uint32_t
+  GetEntriesPerPacket (uint32_t mtu) const;
+  /**
+   * Get the size of an update packet payload
+   * \param entries the number of entries
+   * \returns the size in bytes, without IP and UDP headers
+   */
+  uint32_t
+  GetUpdateSize (uint32_t entries) const;
+  /**
+   * Put entries of an update into a packet
+   * \param begin the first advertised route
+   * \param end past the last advertised route
+   * \returns a bulk message, or one DSDV message per route if bulk updates are disabled
+   */
+  Ptr<Packet>
+  BuildUpdatePacket (std::vector<DsdvHeader>::const_iterator begin,
+                     std::vector<DsdvHeader>::const_iterator end) const;
+  /**
+   * Check whether an update differs from what was last advertised for its destination
+   * \param update the update
+   * \returns true if sequence number or hop count changed, or the destination was never advertised
+   */
+  bool
+  IsAdvertisementChanged (DsdvHeader const & update) const;
+  /**
+   * Drop the cached routes depending on a changed main route, the neighbor
+   * route of a deleted or broken one and the last advertisement of a
+   * deleted one
+   * \param dst destination of the changed route
+   */
+  void
+  MainRouteChanged (Ipv4Address dst);
   /// Merge periodic updates
   void
   MergeTriggerPeriodicUpdates ();
+  /**
+   * Collect the advertised routes that changed and whose settling time has passed.
+   * Only the changed routes are visited.
+   * \param routes cleared and filled with the routes
+   */
+  void
+  GetDirtyRoutes (std::vector<RoutingTableEntry> & routes);
   /// Notify that packet is dropped for some reason
   void
   Drop (Ptr<const Packet>, const Ipv4Header &, Socket::SocketErrno);
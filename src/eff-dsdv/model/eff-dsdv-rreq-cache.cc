@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+
+#include <algorithm>
+#include "ns3/simulator.h"
+#include "eff-dsdv-rreq-cache.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+RreqIdCache::RreqIdCache (Time lifetime)
+  : m_lifetime (lifetime)
+{
+}
+
+bool
+RreqIdCache::IsDuplicate (Ipv4Address origin, uint16_t id)
+{
+  std::vector<Id> & ids = m_ids[origin];
+  Purge (ids);
+  for (std::vector<Id>::const_iterator i = ids.begin (); i != ids.end (); ++i)
+    {
+      if (i->id == id)
+        {
+          return true;
+        }
+    }
+  Id entry;
+  entry.id = id;
+  entry.expire = Simulator::Now () + m_lifetime;
+  ids.push_back (entry);
+  return false;
+}
+
+void
+RreqIdCache::Purge ()
+{
+  for (AddressMap<std::vector<Id> >::iterator i = m_ids.begin (); i != m_ids.end (); ++i)
+    {
+      Purge (i->second);
+      if (i->second.empty ())
+        {
+          m_ids.erase (i);
+        }
+    }
+}
+
+void
+RreqIdCache::Purge (std::vector<Id> & ids)
+{
+  // entries are appended with the same lifetime, so they expire in order
+  Time now = Simulator::Now ();
+  std::vector<Id>::iterator i = ids.begin ();
+  while (i != ids.end () && i->expire <= now)
+    {
+      ++i;
+    }
+  ids.erase (ids.begin (), i);
+}
+
+uint32_t
+RreqIdCache::GetSize () const
+{
+  uint32_t size = 0;
+  for (AddressMap<std::vector<Id> >::const_iterator i = m_ids.begin (); i != m_ids.end (); ++i)
+    {
+      size += i->second.size ();
+    }
+  return size;
+}
+
+RreqBackoff::RreqBackoff (Time initial, Time maximum)
+  : m_initial (initial),
+    m_maximum (maximum)
+{
+}
+
+bool
+RreqBackoff::TryRequest (Ipv4Address dst)
+{
+  Time now = Simulator::Now ();
+  AddressMap<State>::iterator i = m_states.find (dst);
+  if (i == m_states.end ())
+    {
+      State state;
+      state.attempts = 0;
+      i = m_states.insert (std::make_pair (dst, state)).first;
+    }
+  else if (now < i->second.next)
+    {
+      return false;
+    }
+  else if (now - i->second.next > m_maximum)
+    {
+      // a new route break rather than a retry
+      i->second.attempts = 0;
+    }
+  Time wait = m_initial;
+  for (uint32_t n = 0; n < i->second.attempts && wait < m_maximum; ++n)
+    {
+      wait = wait + wait;
+    }
+  i->second.attempts++;
+  i->second.next = now + std::min (wait, m_maximum);
+  return true;
+}
+
+uint32_t
+RreqBackoff::GetAttempts (Ipv4Address dst) const
+{
+  AddressMap<State>::const_iterator i = m_states.find (dst);
+  return i == m_states.end () ? 0 : i->second.attempts;
+}
+
+Time
+RreqBackoff::GetNextAllowed (Ipv4Address dst) const
+{
+  AddressMap<State>::const_iterator i = m_states.find (dst);
+  return i == m_states.end () ? Simulator::Now () : i->second.next;
+}
+
+}
+}
@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+
+#ifndef EFFDSDV_RREQ_CACHE_H
+#define EFFDSDV_RREQ_CACHE_H
+
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "eff-dsdv-address-map.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+/**
+ * \ingroup dsdv
+ * \brief Remembers the route requests a node has already handled
+ *
+ * A request is identified by its origin and the request ID the origin assigned.
+ * Entries expire after a lifetime; expired entries of an origin are dropped
+ * whenever that origin is looked up, the others by Purge ().
+ */
+class RreqIdCache
+{
+public:
+  /**
+   * c-tor
+   * \param lifetime how long a request is remembered
+   */
+  RreqIdCache (Time lifetime = Seconds (3));
+  /**
+   * Check whether a request was seen before and remember it if not
+   * \param origin the node that sent the request
+   * \param id the request ID
+   * \returns true if the request is a duplicate
+   */
+  bool
+  IsDuplicate (Ipv4Address origin, uint16_t id);
+  /// Drop all expired entries
+  void
+  Purge ();
+  /// \returns the number of remembered requests, including expired ones not purged yet
+  uint32_t
+  GetSize () const;
+  /**
+   * Set how long a request is remembered
+   * \param lifetime the lifetime
+   */
+  void
+  SetLifetime (Time lifetime)
+  {
+    m_lifetime = lifetime;
+  }
+  /// \returns how long a request is remembered
+  Time
+  GetLifetime () const
+  {
+    return m_lifetime;
+  }
+  /// Forget all requests
+  void
+  Clear ()
+  {
+    m_ids.clear ();
+  }
+
+private:
+  /// A remembered request of an origin
+  struct Id
+  {
+    uint16_t id; ///< the request ID
+    Time expire; ///< the entry is dropped at this time
+  };
+  /**
+   * Drop the expired entries of one origin
+   * \param ids the entries of the origin
+   */
+  static void
+  Purge (std::vector<Id> & ids);
+  /// origin -> its remembered requests, oldest first
+  AddressMap<std::vector<Id> > m_ids;
+  /// how long a request is remembered
+  Time m_lifetime;
+};
+
+/**
+ * \ingroup dsdv
+ * \brief Spaces out the route requests for each destination
+ *
+ * The first request for a destination may go out at once. Each retry has to wait
+ * twice as long as the one before, starting at the initial interval and capped at
+ * the maximum interval. A destination that was not requested for longer than the
+ * maximum interval after its last wait ran out starts over at the initial interval,
+ * as does one that was reset because a route to it was learned.
+ */
+class RreqBackoff
+{
+public:
+  /**
+   * c-tor
+   * \param initial wait after the first request
+   * \param maximum upper bound of the wait
+   */
+  RreqBackoff (Time initial = MilliSeconds (500), Time maximum = Seconds (8));
+  /**
+   * Set the waits between requests
+   * \param initial wait after the first request
+   * \param maximum upper bound of the wait
+   */
+  void
+  SetInterval (Time initial, Time maximum)
+  {
+    m_initial = initial;
+    m_maximum = maximum;
+  }
+  /**
+   * Check whether a request for a destination may be sent now and, if so, start the next wait
+   * \param dst the destination
+   * \returns true if the request may be sent
+   */
+  bool
+  TryRequest (Ipv4Address dst);
+  /**
+   * Start the destination over at the initial interval
+   * \param dst the destination
+   */
+  void
+  Reset (Ipv4Address dst)
+  {
+    m_states.erase (dst);
+  }
+  /**
+   * \param dst the destination
+   * \returns the number of requests sent since the last reset
+   */
+  uint32_t
+  GetAttempts (Ipv4Address dst) const;
+  /**
+   * \param dst the destination
+   * \returns the time the next request for the destination may be sent
+   */
+  Time
+  GetNextAllowed (Ipv4Address dst) const;
+  /// Start all destinations over
+  void
+  Clear ()
+  {
+    m_states.clear ();
+  }
+
+private:
+  /// Backoff state of a destination
+  struct State
+  {
+    uint32_t attempts; ///< requests sent since the last reset
+    Time next;         ///< no request before this time
+  };
+  /// destination -> its backoff state
+  AddressMap<State> m_states;
+  /// wait after the first request
+  Time m_initial;
+  /// upper bound of the wait
+  Time m_maximum;
+};
+
+}
+}
+#endif /* EFFDSDV_RREQ_CACHE_H */
@@ -22,6 +22,8 @@
 #include "eff-dsdv-rtable.h"
 #include "ns3/simulator.h"
 #include <iomanip>
+#include <algorithm>
+#include <functional>
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -33,29 +35,249 @@ RoutingTableEntry::RoutingTableEntry (Ptr<NetDevice> dev,
                                       Ipv4Address dst,
                                       uint32_t seqNo,
                                       Ipv4InterfaceAddress iface,
-                                      uint32_t hops,
+                                      uint16_t hops,
                                       Ipv4Address nextHop,
                                       Time lifetime,
                                       Time SettlingTime,
                                       bool areChanged)
-  : m_seqNo (seqNo),
+  : m_dst (dst),
+    m_nextHop (nextHop),
+    m_seqNo (seqNo),
     m_hops (hops),
-    m_lifeTime (lifetime),
-    m_iface (iface),
     m_flag (VALID),
+    m_entriesChanged (areChanged),
+    m_iface (iface),
+    m_lifeTime (lifetime),
     m_settlingTime (SettlingTime),
-    m_entriesChanged (areChanged)
+    m_dev (dev)
 {
-  m_ipv4Route = Create<Ipv4Route> ();
-  m_ipv4Route->SetDestination (dst);
-  m_ipv4Route->SetGateway (nextHop);
-  m_ipv4Route->SetSource (m_iface.GetLocal ());
-  m_ipv4Route->SetOutputDevice (dev);
 }
 RoutingTableEntry::~RoutingTableEntry ()
 {
 }
+
+Ptr<Ipv4Route>
+RoutingTableEntry::GetRoute () const
+{
+  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+  route->SetDestination (m_dst);
+  route->SetGateway (m_nextHop);
+  route->SetSource (m_iface.GetLocal ());
+  route->SetOutputDevice (m_dev);
+  return route;
+}
+
+bool
+RoutingTableEntry::IsEqual (RoutingTableEntry const & o) const
+{
+  return m_dst == o.m_dst && m_nextHop == o.m_nextHop && m_seqNo == o.m_seqNo && m_hops == o.m_hops
+         && m_flag == o.m_flag && m_entriesChanged == o.m_entriesChanged && m_iface == o.m_iface
+         && m_lifeTime == o.m_lifeTime && m_installTime == o.m_installTime
+         && m_settlingTime == o.m_settlingTime && m_dev == o.m_dev;
+}
+
+void
+RoutingTableEntry::Print (Ptr<OutputStreamWrapper> stream) const
+{
+  *stream->GetStream () << std::setiosflags (std::ios::fixed) << m_dst << "\t\t" << m_nextHop << "\t\t"
+                        << m_iface.GetLocal () << "\t\t" << std::setiosflags (std::ios::left)
+                        << std::setw (10) << m_hops << "\t" << std::setw (10) << m_seqNo << "\t"
+						<< std::setw (10) << (uint32_t) m_flag << "\t"
+                        << std::setprecision (3) << (Simulator::Now () - m_lifeTime).GetSeconds ()
+                        << "s\t\t" << m_settlingTime.GetSeconds ()
+						<< "s\t\t" << m_installTime.GetSeconds () <<"s\n";
+}
+
+const uint32_t RouteStore::NO_SLOT;
+
+RouteStore::RouteStore ()
+{
+}
+
+RoutingTableEntry const *
+RouteStore::Find (Ipv4Address dst, State state) const
+{
+  Records::const_iterator i = m_records.find (dst);
+  if (i == m_records.end () || !i->second.Has (state))
+    {
+      return 0;
+    }
+  return &Get (i->second, state);
+}
+
+bool
+RouteStore::Insert (RoutingTableEntry const & rt, State state)
+{
+  Record empty;
+  empty.advertised = NO_SLOT;
+  empty.alternative = 0;
+  empty.states = 0;
+  empty.shared = false;
+  Record & record = m_records.insert (std::make_pair (rt.GetDestination (), empty)).first->second;
+  if (record.Has (state))
+    {
+      return false;
+    }
+  record.states |= 1 << state;
+  switch (state)
+    {
+    case MAIN:
+      record.main = rt;
+      if (record.Has (ADVERTISED))
+        {
+          Share (record);
+        }
+      break;
+    case ADVERTISED:
+      record.shared = record.Has (MAIN) && record.main.IsEqual (rt);
+      if (!record.shared)
+        {
+          record.advertised = Allocate (rt);
+        }
+      break;
+    case ALTERNATIVE:
+      record.alternative = Allocate (rt);
+      break;
+    }
+  return true;
+}
+
+void
+RouteStore::Set (RoutingTableEntry const & rt, State state)
+{
+  Record & record = m_records.find (rt.GetDestination ())->second;
+  NS_ASSERT (record.Has (state));
+  switch (state)
+    {
+    case MAIN:
+      if (!record.Has (ADVERTISED))
+        {
+          record.main = rt;
+        }
+      else if (!record.shared || !record.main.IsEqual (rt))
+        {
+          // the advertised route only needs a copy of its own if the routes drift apart
+          Unshare (record);
+          record.main = rt;
+          Share (record);
+        }
+      break;
+    case ADVERTISED:
+      if (record.Has (MAIN) && record.main.IsEqual (rt))
+        {
+          record.shared = true;
+        }
+      else
+        {
+          if (record.advertised == NO_SLOT)
+            {
+              record.advertised = Allocate (rt);
+            }
+          else
+            {
+              m_pool[record.advertised] = rt;
+            }
+          record.shared = false;
+        }
+      break;
+    case ALTERNATIVE:
+      m_pool[record.alternative] = rt;
+      break;
+    }
+}
+
+bool
+RouteStore::Erase (Ipv4Address dst, State state)
+{
+  Records::iterator i = m_records.find (dst);
+  if (i == m_records.end () || !i->second.Has (state))
+    {
+      return false;
+    }
+  Record & record = i->second;
+  switch (state)
+    {
+    case MAIN:
+      if (record.Has (ADVERTISED))
+        {
+          Unshare (record);
+        }
+      record.main = RoutingTableEntry ();
+      break;
+    case ADVERTISED:
+      if (record.advertised != NO_SLOT)
+        {
+          m_free.push_back (record.advertised);
+          record.advertised = NO_SLOT;
+        }
+      record.shared = false;
+      break;
+    case ALTERNATIVE:
+      m_free.push_back (record.alternative);
+      break;
+    }
+  record.states &= ~(1 << state);
+  if (record.states == 0)
+    {
+      m_records.erase (i);
+    }
+  return true;
+}
+
+uint32_t
+RouteStore::Allocate (RoutingTableEntry const & rt)
+{
+  if (m_free.empty ())
+    {
+      m_pool.push_back (rt);
+      return m_pool.size () - 1;
+    }
+  uint32_t slot = m_free.back ();
+  m_free.pop_back ();
+  m_pool[slot] = rt;
+  return slot;
+}
+
+void
+RouteStore::Unshare (Record & record)
+{
+  if (!record.shared)
+    {
+      return;
+    }
+  if (record.advertised == NO_SLOT)
+    {
+      record.advertised = Allocate (record.main);
+    }
+  else
+    {
+      m_pool[record.advertised] = record.main;
+    }
+  record.shared = false;
+}
+
+void
+RouteStore::Share (Record & record)
+{
+  if (!record.shared && record.main.IsEqual (m_pool[record.advertised]))
+    {
+      record.shared = true;
+    }
+}
+
 RoutingTable::RoutingTable ()
+  : m_store (Create<RouteStore> ()),
+    m_state (RouteStore::MAIN),
+    m_size (0),
+    m_validSize (0)
+{
+}
+
+RoutingTable::RoutingTable (Ptr<RouteStore> store, RouteStore::State state)
+  : m_store (store),
+    m_state (state),
+    m_size (0),
+    m_validSize (0)
 {
 }
 
@@ -63,17 +285,16 @@ bool
 RoutingTable::LookupRoute (Ipv4Address id,
                            RoutingTableEntry & rt)
 {
-  if (m_ipv4AddressEntry.empty ())
+  if (m_size == 0)
     {
       return false;
     }
-  std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = m_ipv4AddressEntry.find (id);
-  if (i == m_ipv4AddressEntry.end ())
+  RoutingTableEntry const *entry = m_store->Find (id, m_state);
+  if (entry == 0)
     {
       return false;
     }
-  rt = i->second;
-
+  rt = *entry;
   return true;
 }
 
@@ -82,28 +303,30 @@ RoutingTable::LookupRoute (Ipv4Address id,
                            RoutingTableEntry & rt,
                            bool forRouteInput)
 {
-  if (m_ipv4AddressEntry.empty ())
+  if (m_size == 0)
     {
       return false;
     }
-  std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = m_ipv4AddressEntry.find (id);
-  if (i == m_ipv4AddressEntry.end ())
+  RoutingTableEntry const *entry = m_store->Find (id, m_state);
+  if (entry == 0)
     {
       return false;
     }
-  if (forRouteInput == true && id == i->second.GetInterface ().GetBroadcast ())
+  if (forRouteInput == true && id == entry->GetInterface ().GetBroadcast ())
     {
       return false;
     }
-  rt = i->second;
+  rt = *entry;
   return true;
 }
 
 bool
 RoutingTable::DeleteRoute (Ipv4Address dst)
 {
-  if (m_ipv4AddressEntry.erase (dst) != 0)
+  RoutingTableEntry const *entry = m_store->Find (dst, m_state);
+  if (entry != 0)
     {
+      EraseRoute (*entry);
       // NS_LOG_DEBUG("Route erased");
       return true;
     }
@@ -113,74 +336,129 @@ RoutingTable::DeleteRoute (Ipv4Address dst)
 uint32_t
 RoutingTable::RoutingTableSize ()
 {
-  return m_ipv4AddressEntry.size ();
+  return m_size;
 }
 
 bool
 RoutingTable::AddRoute (RoutingTableEntry & rt)
 {
-  std::pair<std::map<Ipv4Address, RoutingTableEntry>::iterator, bool> result = m_ipv4AddressEntry.insert (std::make_pair (
-                                                                                                            rt.GetDestination (),rt));
-  return result.second;
+  if (!m_store->Insert (rt, m_state))
+    {
+      return false;
+    }
+  ++m_size;
+  if (rt.GetFlag () == VALID)
+    {
+      ++m_validSize;
+    }
+  IndexNextHop (rt.GetNextHop (), rt.GetDestination ());
+  ScheduleExpiry (rt);
+  TrackChange (rt);
+  NotifyChanged (rt.GetDestination ());
+  if (rt.GetFlag () == VALID && !m_routeInstalled.IsNull ())
+    {
+      m_routeInstalled (rt.GetDestination ());
+    }
+  return true;
 }
 
 bool
 RoutingTable::Update (RoutingTableEntry & rt)
 {
-  std::map<Ipv4Address, RoutingTableEntry>::iterator i = m_ipv4AddressEntry.find (rt.GetDestination ());
-  if (i == m_ipv4AddressEntry.end ())
+  RoutingTableEntry const *entry = m_store->Find (rt.GetDestination (), m_state);
+  if (entry == 0)
     {
       return false;
     }
-  i->second = rt;
+  if (entry->GetNextHop () != rt.GetNextHop ())
+    {
+      UnindexNextHop (entry->GetNextHop (), rt.GetDestination ());
+      IndexNextHop (rt.GetNextHop (), rt.GetDestination ());
+    }
+  bool refreshed = entry->GetLifeTime () != rt.GetLifeTime ();
+  bool reschedule = refreshed || entry->GetHop () != rt.GetHop ();
+  bool revalidated = entry->GetFlag () != VALID;
+  if (!revalidated)
+    {
+      --m_validSize;
+    }
+  if (rt.GetFlag () == VALID)
+    {
+      ++m_validSize;
+    }
+  m_store->Set (rt, m_state);
+  if (reschedule)
+    {
+      ScheduleExpiry (rt);
+    }
+  TrackChange (rt);
+  NotifyChanged (rt.GetDestination ());
+  if (rt.GetFlag () == VALID && (revalidated || refreshed) && !m_routeInstalled.IsNull ())
+    {
+      m_routeInstalled (rt.GetDestination ());
+    }
   return true;
 }
 
 void
 RoutingTable::DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface)
 {
-  if (m_ipv4AddressEntry.empty ())
+  if (m_size == 0)
     {
       return;
     }
-  for (std::map<Ipv4Address, RoutingTableEntry>::iterator i = m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); )
+  for (RouteIterator i = Begin (ALL_ROUTES); i != End (); ++i)
     {
-      if (i->second.GetInterface () == iface)
+      if (i->GetInterface () == iface)
         {
-          std::map<Ipv4Address, RoutingTableEntry>::iterator tmp = i;
-          ++i;
-          m_ipv4AddressEntry.erase (tmp);
-        }
-      else
-        {
-          ++i;
+          EraseRoute (*i);
         }
     }
 }
 
+void
+RoutingTable::Clear ()
+{
+  std::vector<Ipv4Address> erased;
+  erased.reserve (m_size);
+  for (RouteIterator i = Begin (ALL_ROUTES); i != End (); ++i)
+    {
+      erased.push_back (i->GetDestination ());
+      m_store->Erase (i->GetDestination (), m_state);
+    }
+  // the iterator skips the loopback route
+  if (m_store->Erase (Ipv4Address::GetLoopback (), m_state))
+    {
+      erased.push_back (Ipv4Address::GetLoopback ());
+    }
+  m_size = 0;
+  m_validSize = 0;
+  m_nextHopIndex.clear ();
+  m_expiries.clear ();
+  m_invalidated.clear ();
+  m_changed.clear ();
+  // told once the table is empty, like for a single erased route
+  for (std::vector<Ipv4Address>::const_iterator i = erased.begin (); i != erased.end (); ++i)
+    {
+      NotifyChanged (*i);
+    }
+}
+
 void
 RoutingTable::GetListOfAllValidRoutes (std::map<Ipv4Address, RoutingTableEntry> & allRoutes)
 {
-  for (std::map<Ipv4Address, RoutingTableEntry>::iterator i = m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); ++i)
+  for (RouteIterator i = Begin (VALID_ROUTES); i != End (); ++i)
     {
-      if (i->second.GetDestination () != Ipv4Address ("127.0.0.1") && i->second.GetFlag () == VALID)
-        {
-          allRoutes.insert (
-            std::make_pair (i->first,i->second));
-        }
+      allRoutes.insert (std::make_pair (i->GetDestination (), *i));
     }
 }
 
 void
 RoutingTable::GetListOfAllRoutes (std::map<Ipv4Address, RoutingTableEntry> & allRoutes)
 {
-  for (std::map<Ipv4Address, RoutingTableEntry>::iterator i = m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); ++i)
+  for (RouteIterator i = Begin (ALL_ROUTES); i != End (); ++i)
     {
-      if ((i->second.GetDestination () != Ipv4Address ("127.0.0.1")))
-        {
-          allRoutes.insert (
-            std::make_pair (i->first,i->second));
-        }
+      allRoutes.insert (std::make_pair (i->GetDestination (), *i));
     }
 }
 
@@ -189,173 +467,222 @@ RoutingTable::GetListOfDestinationWithNextHop (Ipv4Address nextHop,
                                                std::map<Ipv4Address, RoutingTableEntry> & unreachable)
 {
   unreachable.clear ();
-  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = m_ipv4AddressEntry.begin (); i
-       != m_ipv4AddressEntry.end (); ++i)
+  DestinationRange range = GetDestinationsWithNextHop (nextHop);
+  for (std::vector<Ipv4Address>::const_iterator i = range.first; i != range.second; ++i)
     {
-      if (i->second.GetNextHop () == nextHop)
-        {
-          unreachable.insert (std::make_pair (i->first,i->second));
-        }
+      unreachable.insert (std::make_pair (*i, *m_store->Find (*i, m_state)));
+    }
+}
+
+RoutingTable::DestinationRange
+RoutingTable::GetDestinationsWithNextHop (Ipv4Address nextHop) const
+{
+  static const std::vector<Ipv4Address> none;
+  AddressMap<std::vector<Ipv4Address> >::const_iterator i = m_nextHopIndex.find (nextHop);
+  if (i == m_nextHopIndex.end ())
+    {
+      return DestinationRange (none.begin (), none.end ());
     }
+  return DestinationRange (i->second.begin (), i->second.end ());
 }
 
 void
-RoutingTableEntry::Print (Ptr<OutputStreamWrapper> stream) const
+RoutingTable::IndexNextHop (Ipv4Address nextHop, Ipv4Address dst)
 {
-  *stream->GetStream () << std::setiosflags (std::ios::fixed) << m_ipv4Route->GetDestination () << "\t\t" << m_ipv4Route->GetGateway () << "\t\t"
-                        << m_iface.GetLocal () << "\t\t" << std::setiosflags (std::ios::left)
-                        << std::setw (10) << m_hops << "\t" << std::setw (10) << m_seqNo << "\t"
-						<< std::setw (10) << m_flag << "\t"
-                        << std::setprecision (3) << (Simulator::Now () - m_lifeTime).GetSeconds ()
-                        << "s\t\t" << m_settlingTime.GetSeconds ()
-						<< "s\t\t" << m_installTime.GetSeconds () <<"s\n";
+  m_nextHopIndex[nextHop].push_back (dst);
+}
+
+void
+RoutingTable::UnindexNextHop (Ipv4Address nextHop, Ipv4Address dst)
+{
+  AddressMap<std::vector<Ipv4Address> >::iterator i = m_nextHopIndex.find (nextHop);
+  NS_ASSERT (i != m_nextHopIndex.end ());
+  std::vector<Ipv4Address> & dsts = i->second;
+  std::vector<Ipv4Address>::iterator j = std::find (dsts.begin (), dsts.end (), dst);
+  NS_ASSERT (j != dsts.end ());
+  *j = dsts.back ();
+  dsts.pop_back ();
+  if (dsts.empty ())
+    {
+      m_nextHopIndex.erase (i);
+    }
 }
 
 void
 RoutingTable::Purge (std::map<Ipv4Address, RoutingTableEntry> & removedAddresses, std::map<Ipv4Address, RoutingTableEntry> & invalidatedAddresses)
 {
-  if (m_ipv4AddressEntry.empty ())
+  if (m_size == 0)
     {
       return;
     }
-  for (std::map<Ipv4Address, RoutingTableEntry>::iterator i = m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); )
+  Time now = Simulator::Now ();
+  while (!m_expiries.empty () && m_expiries.front ().deadline < now)
     {
-      std::map<Ipv4Address, RoutingTableEntry>::iterator itmp = i;
-      if (i->second.GetLifeTime () > m_holddownTime && (i->second.GetHop () > 0))
+      Ipv4Address dst = m_expiries.front ().dst;
+      std::pop_heap (m_expiries.begin (), m_expiries.end (), std::greater<Expiry> ());
+      m_expiries.pop_back ();
+      RoutingTableEntry const *entry = m_store->Find (dst, m_state);
+      if (entry == 0)
+        {
+          continue;
+        }
+      if (entry->GetLifeTime () > m_holddownTime && (entry->GetHop () > 0))
         {
-          for (std::map<Ipv4Address, RoutingTableEntry>::iterator j = m_ipv4AddressEntry.begin (); j != m_ipv4AddressEntry.end (); )
+          RoutingTableEntry expired = *entry;
+          // routes depending on the expired one; copied as erasing modifies the index
+          DestinationRange range = GetDestinationsWithNextHop (dst);
+          std::vector<Ipv4Address> dependents (range.first, range.second);
+          for (std::vector<Ipv4Address>::const_iterator k = dependents.begin (); k != dependents.end (); ++k)
             {
-              if ((j->second.GetNextHop () == i->second.GetDestination ()) && (i->second.GetHop () != j->second.GetHop ()))
+              RoutingTableEntry const *dependent = m_store->Find (*k, m_state);
+              if (expired.GetHop () != dependent->GetHop ())
                 {
-                  std::map<Ipv4Address, RoutingTableEntry>::iterator jtmp = j;
-                  removedAddresses.insert (std::make_pair (j->first,j->second));
-                  ++j;
-                  m_ipv4AddressEntry.erase (jtmp);
-                }
-              else
-                {
-                  ++j;
+                  removedAddresses.insert (std::make_pair (*k, *dependent));
+                  EraseRoute (*dependent);
                 }
             }
-          removedAddresses.insert (std::make_pair (i->first,i->second));
-          ++i;
-          m_ipv4AddressEntry.erase (itmp);
+          removedAddresses.insert (std::make_pair (dst, expired));
+          EraseRoute (expired);
+        }
+      else if (entry->GetLifeTime () > (m_holddownTime/3 + Seconds (1)) && (entry->GetHop () == 1))
+        {
+          m_invalidated.insert (std::make_pair (dst, true));
         }
-      /** invalidate route AT POINT OF LINK BREAKAGE after first overdue routing update*/
-      else if (i->second.GetLifeTime() > (m_holddownTime/3 + Seconds(1)) && (i->second.GetHop () ==1))
-       {
-       ++i;
-       itmp->second.SetFlag(RouteFlags::INVALID);
-       invalidatedAddresses.insert(std::make_pair (itmp->first,itmp->second));
-       NS_LOG_DEBUG("Invalidated Address: "<< itmp->second.GetDestination());
-       }
-     else
-       {
-         ++i;
-       }
+      // otherwise the route has been refreshed and carries a later deadline
     }
-  return;
-}
-
-void
-RoutingTable::Print (Ptr<OutputStreamWrapper> stream) const
-{
-  *stream->GetStream () << "\n Routing table\n" << "Destination\t\tGateway\t\tInterface\t\tHopCount\t\tSeqNum\t\tFlag\t\tLifeTime\t\tSettlingTime\t\tInstallTime\n";
-  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = m_ipv4AddressEntry.begin (); i
-       != m_ipv4AddressEntry.end (); ++i)
+  /** invalidate route AT POINT OF LINK BREAKAGE after first overdue routing update*/
+  for (AddressMap<bool>::iterator k = m_invalidated.begin (); k != m_invalidated.end (); ++k)
     {
-      i->second.Print (stream);
+      RoutingTableEntry const *entry = m_store->Find (k->first, m_state);
+      if (entry == 0 || entry->GetHop () != 1
+          || !(entry->GetLifeTime () > (m_holddownTime/3 + Seconds (1))))
+        {
+          m_invalidated.erase (k);
+          continue;
+        }
+      if (entry->GetFlag () == VALID)
+        {
+          --m_validSize;
+        }
+      RoutingTableEntry invalidated = *entry;
+      invalidated.SetFlag (RouteFlags::INVALID);
+      m_store->Set (invalidated, m_state);
+      NotifyChanged (k->first);
+      invalidatedAddresses.insert (std::make_pair (k->first, invalidated));
+      NS_LOG_DEBUG ("Invalidated Address: " << k->first);
     }
-  *stream->GetStream () << "\n";
-
+  return;
 }
 
-bool
-RoutingTable::AddIpv4Event (Ipv4Address address,
-                            EventId id)
+void
+RoutingTable::Setholddowntime (Time t)
 {
-  std::pair<std::map<Ipv4Address, EventId>::iterator, bool> result = m_ipv4Events.insert (std::make_pair (address,id));
-  return result.second;
+  m_holddownTime = t;
+  RescheduleExpiries ();
 }
 
-bool
-RoutingTable::AnyRunningEvent (Ipv4Address address)
+void
+RoutingTable::ScheduleExpiry (RoutingTableEntry const & rt)
 {
-  EventId event;
-  std::map<Ipv4Address, EventId>::const_iterator i = m_ipv4Events.find (address);
-  if (m_ipv4Events.empty ())
-    {
-      return false;
-    }
-  if (i == m_ipv4Events.end ())
+  if (rt.GetHop () == 0)
     {
-      return false;
+      // own interfaces and broadcast routes never expire
+      return;
     }
-  event = i->second;
-  if (event.IsRunning ())
+  if (m_expiries.size () > 4 * m_size + 64)
     {
-      return true;
+      // mostly deadlines of refreshed routes, start over
+      RescheduleExpiries ();
+      return;
     }
-  else
+  Time lastUpdate = Simulator::Now () - rt.GetLifeTime ();
+  Expiry expiry;
+  expiry.dst = rt.GetDestination ();
+  if (rt.GetHop () == 1)
     {
-      return false;
+      expiry.deadline = lastUpdate + m_holddownTime/3 + Seconds (1);
+      m_expiries.push_back (expiry);
+      std::push_heap (m_expiries.begin (), m_expiries.end (), std::greater<Expiry> ());
     }
+  expiry.deadline = lastUpdate + m_holddownTime;
+  m_expiries.push_back (expiry);
+  std::push_heap (m_expiries.begin (), m_expiries.end (), std::greater<Expiry> ());
 }
 
-bool
-RoutingTable::ForceDeleteIpv4Event (Ipv4Address address)
+void
+RoutingTable::RescheduleExpiries ()
 {
-  EventId event;
-  std::map<Ipv4Address, EventId>::const_iterator i = m_ipv4Events.find (address);
-  if (m_ipv4Events.empty () || i == m_ipv4Events.end ())
+  m_expiries.clear ();
+  for (RouteIterator i = Begin (ALL_ROUTES); i != End (); ++i)
     {
-      return false;
+      ScheduleExpiry (*i);
     }
-  event = i->second;
-  Simulator::Cancel (event);
-  m_ipv4Events.erase (address);
-  return true;
 }
 
-bool
-RoutingTable::DeleteIpv4Event (Ipv4Address address)
+void
+RoutingTable::EraseRoute (RoutingTableEntry const & rt)
 {
-  EventId event;
-  std::map<Ipv4Address, EventId>::const_iterator i = m_ipv4Events.find (address);
-  if (m_ipv4Events.empty () || i == m_ipv4Events.end ())
+  // rt may live in the store, keep what is needed before erasing it
+  Ipv4Address dst = rt.GetDestination ();
+  if (rt.GetFlag () == VALID)
     {
-      return false;
+      --m_validSize;
     }
-  event = i->second;
-  if (event.IsRunning ())
+  UnindexNextHop (rt.GetNextHop (), dst);
+  m_invalidated.erase (dst);
+  m_changed.erase (dst);
+  m_store->Erase (dst, m_state);
+  --m_size;
+  NotifyChanged (dst);
+}
+
+void
+RoutingTable::TrackChange (RoutingTableEntry const & rt)
+{
+  if (rt.GetEntriesChanged ())
     {
-      return false;
+      m_changed[rt.GetDestination ()] = true;
     }
-  if (event.IsExpired ())
+  else
     {
-      event.Cancel ();
-      m_ipv4Events.erase (address);
-      return true;
+      m_changed.erase (rt.GetDestination ());
     }
-  else
+}
+
+void
+RoutingTable::GetChangedDestinations (std::vector<Ipv4Address> & dsts) const
+{
+  dsts.clear ();
+  dsts.reserve (m_changed.size ());
+  for (AddressMap<bool>::const_iterator i = m_changed.begin (); i != m_changed.end (); ++i)
     {
-      m_ipv4Events.erase (address);
-      return true;
+      dsts.push_back (i->first);
     }
 }
 
-EventId
-RoutingTable::GetEventId (Ipv4Address address)
+void
+RoutingTable::Print (Ptr<OutputStreamWrapper> stream) const
 {
-  std::map <Ipv4Address, EventId>::const_iterator i = m_ipv4Events.find (address);
-  if (m_ipv4Events.empty () || i == m_ipv4Events.end ())
+  *stream->GetStream () << "\n Routing table\n" << "Destination\t\tGateway\t\tInterface\t\tHopCount\t\tSeqNum\t\tFlag\t\tLifeTime\t\tSettlingTime\t\tInstallTime\n";
+  // the hash table has no order, print sorted by destination as before
+  std::vector<Ipv4Address> destinations;
+  destinations.reserve (m_size);
+  for (RouteStore::Records::const_iterator i = m_store->GetRecords ().begin (); i
+       != m_store->GetRecords ().end (); ++i)
     {
-      return EventId ();
+      if (i->second.Has (m_state))
+        {
+          destinations.push_back (i->first);
+        }
     }
-  else
+  std::sort (destinations.begin (), destinations.end ());
+  for (std::vector<Ipv4Address>::const_iterator i = destinations.begin (); i != destinations.end (); ++i)
     {
-      return i->second;
+      m_store->Find (*i, m_state)->Print (stream);
     }
+  *stream->GetStream () << "\n";
+
 }
+
 }
 }
@@ -25,12 +25,16 @@
 
 #include <cassert>
 #include <map>
+#include <vector>
 #include <sys/types.h>
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/timer.h"
 #include "ns3/net-device.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/callback.h"
+#include "eff-dsdv-address-map.h"
 
 namespace ns3 {
 namespace effdsdv {
@@ -44,6 +48,9 @@ enum RouteFlags
 /**
  * \ingroup dsdv
  * \brief Routing table entry
+ *
+ * A plain record, copying it does not allocate. The Ipv4Route handed to the IP layer
+ * is built by GetRoute () on demand.
  */
 class RoutingTableEntry
 {
@@ -55,14 +62,14 @@ public:
    * \param dst the destination IP address
    * \param seqNo the sequence number
    * \param iface the interface
-   * \param hops the number of hops
+   * \param hops the number of hops, 16 bit like on the wire
    * \param nextHop the IP address of the next hop
    * \param lifetime the lifetime 
    * \param SettlingTime the settling time
    * \param changedEntries flag for changed entries
    */
   RoutingTableEntry (Ptr<NetDevice> dev = 0, Ipv4Address dst = Ipv4Address (), uint32_t seqNo = 0,
-                     Ipv4InterfaceAddress iface = Ipv4InterfaceAddress (), uint32_t hops = 0, Ipv4Address nextHop = Ipv4Address (),
+                     Ipv4InterfaceAddress iface = Ipv4InterfaceAddress (), uint16_t hops = 0, Ipv4Address nextHop = Ipv4Address (),
                      Time lifetime = Simulator::Now (), Time SettlingTime = Simulator::Now (), bool changedEntries = false);
 
   ~RoutingTableEntry ();
@@ -73,25 +80,24 @@ public:
   Ipv4Address
   GetDestination () const
   {
-    return m_ipv4Route->GetDestination ();
+    return m_dst;
   }
   /**
-   * Get route
+   * Get route. Every call allocates a new route object.
    * \returns the IPv4 route
    */
   Ptr<Ipv4Route>
-  GetRoute () const
-  {
-    return m_ipv4Route;
-  }
+  GetRoute () const;
   /**
-   * Set route
+   * Set destination, next hop and output device from a route
    * \param route the IPv4 route
    */
   void
   SetRoute (Ptr<Ipv4Route> route)
   {
-    m_ipv4Route = route;
+    m_dst = route->GetDestination ();
+    m_nextHop = route->GetGateway ();
+    m_dev = route->GetOutputDevice ();
   }
   /**
    * Set next hop
@@ -100,7 +106,7 @@ public:
   void
   SetNextHop (Ipv4Address nextHop)
   {
-    m_ipv4Route->SetGateway (nextHop);
+    m_nextHop = nextHop;
   }
   /**
    * Get next hop
@@ -109,7 +115,7 @@ public:
   Ipv4Address
   GetNextHop () const
   {
-    return m_ipv4Route->GetGateway ();
+    return m_nextHop;
   }
   /**
    * Set output device
@@ -118,7 +124,7 @@ public:
   void
   SetOutputDevice (Ptr<NetDevice> device)
   {
-    m_ipv4Route->SetOutputDevice (device);
+    m_dev = device;
   }
   /**
    * Get output device
@@ -127,7 +133,7 @@ public:
   Ptr<NetDevice>
   GetOutputDevice () const
   {
-    return m_ipv4Route->GetOutputDevice ();
+    return m_dev;
   }
   /**
    * Get interface address
@@ -167,10 +173,10 @@ public:
   }
   /**
    * Set hop
-   * \param hopCount the hop count
+   * \param hopCount the hop count, 16 bit like on the wire
    */
   void
-  SetHop (uint32_t hopCount)
+  SetHop (uint16_t hopCount)
   {
     m_hops = hopCount;
   }
@@ -199,7 +205,7 @@ public:
      *  should only be used in alternative routing tables
      */
     Time
-    GetInstallTime ()
+    GetInstallTime () const
     {
       return (Simulator::Now () - m_installTime);
     }
@@ -255,7 +261,7 @@ public:
   RouteFlags
   GetFlag () const
   {
-    return m_flag;
+    return static_cast<RouteFlags> (m_flag);
   }
   /**
    * Set entries changed indicator
@@ -283,8 +289,15 @@ public:
   bool
   operator== (Ipv4Address const destination) const
   {
-    return (m_ipv4Route->GetDestination () == destination);
+    return (m_dst == destination);
   }
+  /**
+   * \brief Compare all fields
+   * \param o the other entry
+   * \return true if both entries describe the same route in the same state
+   */
+  bool
+  IsEqual (RoutingTableEntry const & o) const;
   /**
    * Print routing table entry
    * \param stream the output stream
@@ -293,11 +306,21 @@ public:
   Print (Ptr<OutputStreamWrapper> stream) const;
 
 private:
-  // Fields
+  // Fields, ordered to avoid padding
+  /// Destination address
+  Ipv4Address m_dst;
+  /// Next hop address
+  Ipv4Address m_nextHop;
   /// Destination Sequence Number
   uint32_t m_seqNo;
-  /// Hop Count (number of hops needed to reach destination)
-  uint32_t m_hops;
+  /// Hop Count (number of hops needed to reach destination), 16 bit like on the wire
+  uint16_t m_hops;
+  /// Routing flags: valid, invalid or in search, see RouteFlags
+  uint8_t m_flag;
+  /// Flag to show if any of the routing table entries were changed with the routing update.
+  bool m_entriesChanged;
+  /// Output interface address
+  Ipv4InterfaceAddress m_iface;
   /**
    * \brief Expiration or deletion time of the route
    *	Lifetime field in the routing table plays dual role --
@@ -306,34 +329,169 @@ private:
    */
   Time m_lifeTime;
   Time m_installTime;
-  /** Ip route, include
-   *   - destination address
-   *   - source address
-   *   - next hop address (gateway)
-   *   - output device
-   */
-  Ptr<Ipv4Route> m_ipv4Route;
-  /// Output interface address
-  Ipv4InterfaceAddress m_iface;
-  /// Routing flags: valid, invalid or in search
-  RouteFlags m_flag;
   /// Time for which the node retains an update with changed metric before broadcasting it.
   /// A node does that in hope of receiving a better update.
   Time m_settlingTime;
-  /// Flag to show if any of the routing table entries were changed with the routing update.
-  uint32_t m_entriesChanged;
+  /// Output device
+  Ptr<NetDevice> m_dev;
+
+};
+
+/**
+ * \ingroup dsdv
+ * \brief Routes of the main, advertised and alternative routing tables
+ *
+ * Holds one record per destination with the route of every table the destination is
+ * part of and a bit per table. The main route is stored inline, advertised and
+ * alternative routes in a pool. An advertised route equal to the main route takes no
+ * storage of its own: it is marked shared and read from the main route. Putting the
+ * main route into the advertised table, or merging it back, thus only flips bits.
+ * A shared advertised route is copied out only when the main route really changes.
+ * Once a destination needed a pool slot for its advertised route, it keeps the slot
+ * until it leaves the advertised table, so routes drifting apart and merging again
+ * reuse it in place.
+ */
+class RouteStore : public SimpleRefCount<RouteStore>
+{
+public:
+  /// The tables a route can be part of
+  enum State
+  {
+    MAIN = 0,        //!< main routing table
+    ADVERTISED = 1,  //!< advertised routing table, changes waiting to be advertised
+    ALTERNATIVE = 2, //!< alternative routing table
+  };
+  /// Routes of one destination
+  struct Record
+  {
+    RoutingTableEntry main; ///< main route, valid if part of MAIN
+    uint32_t advertised;    ///< pool index of the advertised route or NO_SLOT
+    uint32_t alternative;   ///< pool index of the alternative route
+    uint8_t states;         ///< bit per State the destination is part of
+    bool shared;            ///< the advertised route equals the main route and is read from it
+    /**
+     * \param state the table
+     * \returns true if the destination is part of the table
+     */
+    bool
+    Has (State state) const
+    {
+      return states & (1 << state);
+    }
+  };
+  /// Records by destination
+  typedef AddressMap<Record> Records;
+
+  /// c-tor
+  RouteStore ();
+  /**
+   * \param dst the destination
+   * \param state the table
+   * \returns the route or 0 if dst is not part of the table
+   */
+  RoutingTableEntry const *
+  Find (Ipv4Address dst, State state) const;
+  /**
+   * \param record a record of this store
+   * \param state a table the record is part of
+   * \returns the route of the record in that table
+   */
+  RoutingTableEntry const &
+  Get (Record const & record, State state) const
+  {
+    if (state == MAIN || (state == ADVERTISED && record.shared))
+      {
+        return record.main;
+      }
+    return m_pool[state == ADVERTISED ? record.advertised : record.alternative];
+  }
+  /**
+   * Add a route to a table unless its destination is already part of it
+   * \param rt the route
+   * \param state the table
+   * \returns true if the route was added
+   */
+  bool
+  Insert (RoutingTableEntry const & rt, State state);
+  /**
+   * Replace the route of a destination that is part of the table
+   * \param rt the route
+   * \param state the table
+   */
+  void
+  Set (RoutingTableEntry const & rt, State state);
+  /**
+   * Remove a destination from a table. Does not invalidate iterators of GetRecords ().
+   * \param dst the destination
+   * \param state the table
+   * \returns true if the destination was part of the table
+   */
+  bool
+  Erase (Ipv4Address dst, State state);
+  /// \returns all records, iterators are invalidated by Insert
+  Records const &
+  GetRecords () const
+  {
+    return m_records;
+  }
+  /// \returns the number of pool slots in use, including those kept by shared advertised routes
+  uint32_t
+  GetPooledRoutes () const
+  {
+    return m_pool.size () - m_free.size ();
+  }
 
+private:
+  /// No pool slot assigned
+  static const uint32_t NO_SLOT = 0xffffffff;
+  /**
+   * Copy a route into the pool
+   * \param rt the route
+   * \returns its pool index
+   */
+  uint32_t
+  Allocate (RoutingTableEntry const & rt);
+  /**
+   * Copy a shared advertised route into the pool, into its own slot if it has one
+   * \param record the record
+   */
+  void
+  Unshare (Record & record);
+  /**
+   * Mark the advertised route as shared if it equals the main route, keeping its slot
+   * \param record the record
+   */
+  void
+  Share (Record & record);
+  Records m_records;                     ///< records by destination
+  std::vector<RoutingTableEntry> m_pool; ///< advertised and alternative routes
+  std::vector<uint32_t> m_free;          ///< unused pool indices
 };
 
 /**
  * \ingroup dsdv
  * \brief The Routing table used by DSDV protocol
+ *
+ * A table is a view of one State of a RouteStore. Tables of the same node share their
+ * store, see RoutingTable (Ptr<RouteStore>, RouteStore::State).
  */
 class RoutingTable
 {
 public:
-  /// c-tor
+  /// c-tor, creates a table with a store of its own
   RoutingTable ();
+  /**
+   * c-tor
+   * \param store the store shared with other tables
+   * \param state the part of the store this table shows
+   */
+  RoutingTable (Ptr<RouteStore> store, RouteStore::State state);
+  /// \returns the store of this table
+  Ptr<RouteStore>
+  GetStore () const
+  {
+    return m_store;
+  }
   /**
    * Add routing table entry if it doesn't yet exist in routing table
    * \param r routing table entry
@@ -372,6 +530,8 @@ public:
    */
   bool
   Update (RoutingTableEntry & rt);
+  /// Non-copying view of the destinations that are routed over one next hop
+  typedef std::pair<std::vector<Ipv4Address>::const_iterator, std::vector<Ipv4Address>::const_iterator> DestinationRange;
   /**
    * Lookup list of addresses for which nxtHp is the next Hop address
    * \param nxtHp nexthop's address for which we want the list of destinations
@@ -380,7 +540,121 @@ public:
   void
   GetListOfDestinationWithNextHop (Ipv4Address nxtHp, std::map<Ipv4Address, RoutingTableEntry> & dstList);
   /**
-   * Lookup list of all addresses in the routing table
+   * Lookup the destinations for which nextHop is the next hop address, without copying them.
+   * The range is invalidated by the next call to AddRoute, Update, DeleteRoute, Purge,
+   * DeleteAllRoutesFromInterface or Clear; copy it first if the table is modified meanwhile.
+   * \param nextHop nexthop's address for which we want the destinations
+   * \returns the range of destination addresses, in no particular order
+   */
+  DestinationRange
+  GetDestinationsWithNextHop (Ipv4Address nextHop) const;
+  /// Routes visited when iterating the table
+  enum RouteFilter
+  {
+    ALL_ROUTES,   //!< every route except the one to the loopback address
+    VALID_ROUTES, //!< ALL_ROUTES flagged VALID
+  };
+  /**
+   * \brief Forward iterator over the routes admitted by a RouteFilter
+   *
+   * Dereferencing gives access to the stored entry, nothing is copied. Routes may be
+   * updated or deleted while iterating, a deleted entry must not be accessed anymore.
+   * AddRoute on any table of the store invalidates the iterator. Iteration order is
+   * unspecified.
+   */
+  class RouteIterator
+  {
+  public:
+    /**
+     * c-tor
+     * \param store the store
+     * \param state the table to iterate
+     * \param pos first position to consider
+     * \param filter the routes to visit
+     */
+    RouteIterator (RouteStore const *store, RouteStore::State state,
+                   RouteStore::Records::const_iterator pos, RouteFilter filter)
+      : m_store (store),
+        m_state (state),
+        m_pos (pos),
+        m_filter (filter)
+    {
+      Skip ();
+    }
+    /// \returns the current route
+    RoutingTableEntry const &
+    operator* () const
+    {
+      return m_store->Get (m_pos->second, m_state);
+    }
+    /// \returns the current route
+    RoutingTableEntry const *
+    operator-> () const
+    {
+      return &m_store->Get (m_pos->second, m_state);
+    }
+    /// Advance to the next route admitted by the filter
+    RouteIterator &
+    operator++ ()
+    {
+      ++m_pos;
+      Skip ();
+      return *this;
+    }
+    /**
+     * \param o the other iterator
+     * \returns true if the iterators point to the same route
+     */
+    bool
+    operator== (RouteIterator const & o) const
+    {
+      return m_pos == o.m_pos;
+    }
+    /**
+     * \param o the other iterator
+     * \returns true if the iterators point to different routes
+     */
+    bool
+    operator!= (RouteIterator const & o) const
+    {
+      return m_pos != o.m_pos;
+    }
+
+  private:
+    /// Move forward until a route admitted by the filter or the end is reached
+    void
+    Skip ()
+    {
+      while (m_pos != m_store->GetRecords ().end ()
+             && (!m_pos->second.Has (m_state) || m_pos->first == Ipv4Address::GetLoopback ()
+                 || (m_filter == VALID_ROUTES && m_store->Get (m_pos->second, m_state).GetFlag () != VALID)))
+        {
+          ++m_pos;
+        }
+    }
+    RouteStore const *m_store;                 ///< the store
+    RouteStore::State m_state;                 ///< the table iterated
+    RouteStore::Records::const_iterator m_pos; ///< current position
+    RouteFilter m_filter;                      ///< routes to visit
+  };
+  /**
+   * \param filter the routes to visit
+   * \returns iterator to the first route admitted by filter
+   */
+  RouteIterator
+  Begin (RouteFilter filter) const
+  {
+    return RouteIterator (PeekPointer (m_store), m_state, m_store->GetRecords ().begin (), filter);
+  }
+  /// \returns past-the-end route iterator
+  RouteIterator
+  End () const
+  {
+    return RouteIterator (PeekPointer (m_store), m_state, m_store->GetRecords ().end (), ALL_ROUTES);
+  }
+  /**
+   * Lookup list of all addresses in the routing table. Copies every route, use Begin ()
+   * to iterate the table instead.
    * \param allRoutes is the list that will hold all these addresses present in the nodes routing table
    */
   void
@@ -397,15 +671,14 @@ public:
    */
   void
   DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface);
-  /// Delete all entries from routing table
+  /// Delete all entries from routing table, telling the route changed callback about each
   void
-  Clear ()
-  {
-    m_ipv4AddressEntry.clear ();
-  }
+  Clear ();
   /**
-   * Delete all outdated entries if Lifetime is expired
+   * Delete all outdated entries if Lifetime is expired. Only routes whose deadline
+   * passed since the last call are examined, see m_expiries.
    * \param removedAddresses is the list of addresses to purge
+   * \param invalidatedAddresses is the list of neighbors which missed their last update
    */
   void
   Purge (std::map<Ipv4Address, RoutingTableEntry> & removedAddresses, std::map<Ipv4Address, RoutingTableEntry> &invalidatedAddresses);
@@ -422,45 +695,28 @@ public:
   uint32_t
   RoutingTableSize ();
   /**
-  * Add an event for a destination address so that the update to for that destination is sent
-  * after the event is completed.
-  * \param address destination address for which this event is running.
-  * \param id unique eventid that was generated.
-  * \return true on success
-  */
-  bool
-  AddIpv4Event (Ipv4Address address, EventId id);
-  /**
-  * Clear up the entry from the map after the event is completed
-  * \param address destination address for which this event is running.
-  * \return true on success
-  */
-  bool
-  DeleteIpv4Event (Ipv4Address address);
-  /**
-  * Force delete an update waiting for settling time to complete as a better update to
-  * same destination was received.
-  * \param address destination address for which this event is running.
-  * \return true on success
-  */
-  bool
-  AnyRunningEvent (Ipv4Address address);
+   * \returns the number of valid routes, without walking the shared store
+   */
+  uint32_t
+  GetValidCount () const
+  {
+    return m_validSize;
+  }
   /**
-  * Force delete an update waiting for settling time to complete as a better update to
-  * same destination was received.
-  * \param address destination address for which this event is running.
-  * \return true on finding out that an event is already running for that destination address.
-  */
-  bool
-  ForceDeleteIpv4Event (Ipv4Address address);
+   * \returns the number of routes whose entries changed flag is set
+   */
+  uint32_t
+  GetChangedCount () const
+  {
+    return m_changed.size ();
+  }
   /**
-    * Get the EventId associated with that address.
-    * \param address destination address for which this event is running.
-    * \return EventId on finding out an event is associated else return NULL.
-    */
-  EventId
-  GetEventId (Ipv4Address address);
-
+   * Lookup the destinations of all routes whose entries changed flag is set, without
+   * visiting the unchanged ones
+   * \param dsts cleared and filled with the destinations
+   */
+  void
+  GetChangedDestinations (std::vector<Ipv4Address> & dsts) const;
   /**
    * Get hold down time (time until an invalid route may be deleted)
    * \returns the hold down time
@@ -473,19 +729,116 @@ public:
    * Set hold down time (time until an invalid route may be deleted)
    * \param t the hold down time
    */
-  void Setholddowntime (Time t)
+  void Setholddowntime (Time t);
+  /// Callback notified with the destination of a route that became usable
+  typedef Callback<void, Ipv4Address> RouteInstalledCallback;
+  /**
+   * Set the callback invoked whenever a valid route is added, revalidated or refreshed
+   * \param cb the callback
+   */
+  void SetRouteInstalledCallback (RouteInstalledCallback cb)
   {
-    m_holddownTime = t;
+    m_routeInstalled = cb;
+  }
+  /// Callback notified with the destination of a route that was added, modified or removed
+  typedef Callback<void, Ipv4Address> RouteChangedCallback;
+  /**
+   * Set the callback invoked whenever a route is added, updated, invalidated or removed
+   * \param cb the callback
+   */
+  void SetRouteChangedCallback (RouteChangedCallback cb)
+  {
+    m_routeChanged = cb;
   }
 
 private:
+  /// Point in time at which Purge has to look at a route again
+  struct Expiry
+  {
+    Time deadline;   ///< the route may expire once this time has passed
+    Ipv4Address dst; ///< destination of the route
+    /**
+     * \param o the other expiry
+     * \returns true if this one is due later, used to build a min-heap
+     */
+    bool
+    operator> (Expiry const & o) const
+    {
+      return deadline > o.deadline;
+    }
+  };
+  /**
+   * Queue the deadlines at which the route may be invalidated and removed
+   * \param rt the routing table entry
+   */
+  void
+  ScheduleExpiry (RoutingTableEntry const & rt);
+  /**
+   * Keep m_changed in line with the entries changed flag of a route
+   * \param rt the routing table entry
+   */
+  void
+  TrackChange (RoutingTableEntry const & rt);
+  /// Rebuild m_expiries from the current entries
+  void
+  RescheduleExpiries ();
+  /**
+   * Invoke the route changed callback
+   * \param dst destination of the changed route
+   */
+  void
+  NotifyChanged (Ipv4Address dst)
+  {
+    if (!m_routeChanged.IsNull ())
+      {
+        m_routeChanged (dst);
+      }
+  }
+  /**
+   * Remove a route together with its index entries
+   * \param rt the route
+   */
+  void
+  EraseRoute (RoutingTableEntry const & rt);
+  /**
+   * Record that dst is routed over nextHop
+   * \param nextHop the next hop address
+   * \param dst the destination address
+   */
+  void
+  IndexNextHop (Ipv4Address nextHop, Ipv4Address dst);
+  /**
+   * Remove dst from the destinations routed over nextHop
+   * \param nextHop the next hop address
+   * \param dst the destination address
+   */
+  void
+  UnindexNextHop (Ipv4Address nextHop, Ipv4Address dst);
+
   // Fields
-  /// an entry in the routing table.
-  std::map<Ipv4Address, RoutingTableEntry> m_ipv4AddressEntry;
-  /// an entry in the event table.
-  std::map<Ipv4Address, EventId> m_ipv4Events;
+  /// the routes, shared with the other tables of the node
+  Ptr<RouteStore> m_store;
+  /// the part of m_store this table shows
+  RouteStore::State m_state;
+  /// number of routes in this table
+  uint32_t m_size;
+  /// number of valid routes in this table
+  uint32_t m_validSize;
+  /// reverse index: next hop -> destinations of this table routed over it
+  AddressMap<std::vector<Ipv4Address> > m_nextHopIndex;
+  /// min-heap of route deadlines; entries are checked against the route when popped,
+  /// deadlines of routes refreshed or deleted meanwhile are simply dropped
+  std::vector<Expiry> m_expiries;
+  /// neighbors past their invalidation deadline, reported by every Purge until refreshed or removed
+  AddressMap<bool> m_invalidated;
+  /// destinations whose entries changed flag is set
+  AddressMap<bool> m_changed;
   /// hold down time of an expired route
   Time m_holddownTime;
+  /// notified when a route becomes usable
+  RouteInstalledCallback m_routeInstalled;
+  /// notified when a route is added, modified or removed
+  RouteChangedCallback m_routeChanged;
 
 };
 }
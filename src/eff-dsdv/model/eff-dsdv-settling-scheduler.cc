@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+
+#include <algorithm>
+#include <functional>
+#include "ns3/simulator.h"
+#include "eff-dsdv-settling-scheduler.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+SettlingScheduler::SettlingScheduler ()
+{
+}
+
+SettlingScheduler::~SettlingScheduler ()
+{
+  m_event.Cancel ();
+}
+
+void
+SettlingScheduler::Schedule (Ipv4Address dst, Time delay)
+{
+  Deadline entry;
+  entry.deadline = Simulator::Now () + delay;
+  entry.dst = dst;
+  m_deadlines[dst] = entry.deadline;
+  if (m_heap.size () > 4 * m_deadlines.size () + 64)
+    {
+      // mostly stale deadlines of rescheduled destinations
+      Compact ();
+    }
+  else
+    {
+      m_heap.push_back (entry);
+      std::push_heap (m_heap.begin (), m_heap.end (), std::greater<Deadline> ());
+    }
+  if (!m_event.IsRunning () || entry.deadline < m_armedAt)
+    {
+      m_event.Cancel ();
+      m_armedAt = entry.deadline;
+      m_event = Simulator::Schedule (delay, &SettlingScheduler::Expire, this);
+    }
+}
+
+bool
+SettlingScheduler::Cancel (Ipv4Address dst)
+{
+  // the heap entry goes stale, an event left without due destinations just re-arms
+  return m_deadlines.erase (dst) > 0;
+}
+
+bool
+SettlingScheduler::IsPending (Ipv4Address dst) const
+{
+  return m_deadlines.find (dst) != m_deadlines.end ();
+}
+
+Time
+SettlingScheduler::GetDeadline (Ipv4Address dst) const
+{
+  AddressMap<Time>::const_iterator i = m_deadlines.find (dst);
+  if (i == m_deadlines.end ())
+    {
+      return Time ();
+    }
+  return i->second;
+}
+
+void
+SettlingScheduler::Clear ()
+{
+  m_event.Cancel ();
+  m_deadlines.clear ();
+  m_heap.clear ();
+}
+
+void
+SettlingScheduler::Expire ()
+{
+  Time now = Simulator::Now ();
+  bool due = false;
+  while (!m_heap.empty () && m_heap.front ().deadline <= now)
+    {
+      Deadline entry = m_heap.front ();
+      std::pop_heap (m_heap.begin (), m_heap.end (), std::greater<Deadline> ());
+      m_heap.pop_back ();
+      AddressMap<Time>::iterator i = m_deadlines.find (entry.dst);
+      if (i != m_deadlines.end () && i->second == entry.deadline)
+        {
+          m_deadlines.erase (i);
+          due = true;
+        }
+    }
+  if (due && !m_callback.IsNull ())
+    {
+      m_callback ();
+    }
+  Arm ();
+}
+
+void
+SettlingScheduler::Arm ()
+{
+  while (!m_heap.empty ())
+    {
+      AddressMap<Time>::const_iterator i = m_deadlines.find (m_heap.front ().dst);
+      if (i != m_deadlines.end () && i->second == m_heap.front ().deadline)
+        {
+          break;
+        }
+      std::pop_heap (m_heap.begin (), m_heap.end (), std::greater<Deadline> ());
+      m_heap.pop_back ();
+    }
+  if (m_heap.empty () || m_event.IsRunning ())
+    {
+      return;
+    }
+  m_armedAt = m_heap.front ().deadline;
+  m_event = Simulator::Schedule (m_armedAt - Simulator::Now (), &SettlingScheduler::Expire, this);
+}
+
+void
+SettlingScheduler::Compact ()
+{
+  m_heap.clear ();
+  for (AddressMap<Time>::const_iterator i = m_deadlines.begin (); i != m_deadlines.end (); ++i)
+    {
+      Deadline entry;
+      entry.deadline = i->second;
+      entry.dst = i->first;
+      m_heap.push_back (entry);
+    }
+  std::make_heap (m_heap.begin (), m_heap.end (), std::greater<Deadline> ());
+}
+
+}
+}
@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+
+#ifndef EFFDSDV_SETTLING_SCHEDULER_H
+#define EFFDSDV_SETTLING_SCHEDULER_H
+
+#include <vector>
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "eff-dsdv-address-map.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+/**
+ * \ingroup dsdv
+ * \brief Holds back advertisements until their settling time has passed
+ *
+ * Keeps one deadline per destination and a single simulator event for the earliest
+ * of them. When that event fires, every destination that is due is released and the
+ * callback is invoked once for the whole batch.
+ */
+class SettlingScheduler
+{
+public:
+  /// c-tor
+  SettlingScheduler ();
+  /// d-tor, cancels the pending event
+  ~SettlingScheduler ();
+  /**
+   * Set the function invoked whenever destinations have settled
+   * \param callback the function, typically sending a triggered update
+   */
+  void
+  SetCallback (Callback<void> callback)
+  {
+    m_callback = callback;
+  }
+  /**
+   * Hold back the advertisement of a destination, replacing any earlier deadline
+   * \param dst the destination
+   * \param delay the settling time
+   */
+  void
+  Schedule (Ipv4Address dst, Time delay);
+  /**
+   * Release a destination without invoking the callback
+   * \param dst the destination
+   * \returns true if the destination was held back
+   */
+  bool
+  Cancel (Ipv4Address dst);
+  /**
+   * \param dst the destination
+   * \returns true if the settling time of the destination has not passed yet
+   */
+  bool
+  IsPending (Ipv4Address dst) const;
+  /**
+   * \param dst the destination
+   * \returns the time the destination settles, or zero if it is not held back
+   */
+  Time
+  GetDeadline (Ipv4Address dst) const;
+  /// \returns the number of destinations held back
+  uint32_t
+  GetSize () const
+  {
+    return m_deadlines.size ();
+  }
+  /// Release all destinations and cancel the pending event
+  void
+  Clear ();
+
+private:
+  /// Settling deadline of a destination, stale once the destination is rescheduled
+  struct Deadline
+  {
+    Time deadline;   ///< the destination settles at this time
+    Ipv4Address dst; ///< the destination
+    /**
+     * \param o the other deadline
+     * \returns true if this one is due later, used to build a min-heap
+     */
+    bool
+    operator> (Deadline const & o) const
+    {
+      return deadline > o.deadline;
+    }
+  };
+  /// Release all due destinations, invoke the callback and arm the next event
+  void
+  Expire ();
+  /// Drop stale heap entries and arm the event for the earliest deadline
+  void
+  Arm ();
+  /// Rebuild the heap from the current deadlines
+  void
+  Compact ();
+  /// destination -> its settling deadline
+  AddressMap<Time> m_deadlines;
+  /// min-heap over m_deadlines, possibly containing stale entries
+  std::vector<Deadline> m_heap;
+  /// the single simulator event
+  EventId m_event;
+  /// time m_event fires at
+  Time m_armedAt;
+  /// invoked once per batch of settled destinations
+  Callback<void> m_callback;
+};
+
+}
+}
+#endif /* EFFDSDV_SETTLING_SCHEDULER_H */
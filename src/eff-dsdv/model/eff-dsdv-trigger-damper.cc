@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+
+#include <algorithm>
+#include "ns3/simulator.h"
+#include "eff-dsdv-trigger-damper.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+TriggerDamper::TriggerDamper (Ipv4InterfaceAddress iface)
+  : m_iface (iface),
+    m_flushedOnce (false),
+    m_rate (0),
+    m_burst (0),
+    m_tokens (0),
+    m_overhead (0),
+    m_perEntry (0)
+{
+}
+
+TriggerDamper::~TriggerDamper ()
+{
+  m_event.Cancel ();
+}
+
+void
+TriggerDamper::SetTokenBucket (uint32_t rate, uint32_t burst)
+{
+  m_rate = rate;
+  m_burst = burst;
+  m_tokens = burst;
+  m_refilled = Simulator::Now ();
+}
+
+void
+TriggerDamper::Add (std::vector<DsdvHeader> const & updates)
+{
+  for (std::vector<DsdvHeader>::const_iterator i = updates.begin (); i != updates.end (); ++i)
+    {
+      AddressMap<uint32_t>::iterator j = m_index.find (i->GetDst ());
+      if (j != m_index.end ())
+        {
+          m_pending[j->second] = *i;
+        }
+      else
+        {
+          m_index[i->GetDst ()] = m_pending.size ();
+          m_pending.push_back (*i);
+        }
+    }
+  if (m_pending.empty ())
+    {
+      return;
+    }
+  if (m_event.IsRunning ())
+    {
+      Suppress (COALESCED);
+      return;
+    }
+  Time now = Simulator::Now ();
+  Time at = now;
+  SuppressReason reason = MIN_INTERVAL;
+  if (m_flushedOnce && m_lastFlush + m_minInterval > now)
+    {
+      at = m_lastFlush + m_minInterval;
+    }
+  if (m_rate > 0)
+    {
+      Refill ();
+      double needed = std::min<double> (GetSize (m_pending.size ()), m_burst);
+      Time ready = now + Seconds ((needed - m_tokens) / m_rate);
+      if (ready > at)
+        {
+          at = ready;
+          reason = RATE_LIMIT;
+        }
+    }
+  if (at > now)
+    {
+      Suppress (reason);
+      m_event = Simulator::Schedule (at - now, &TriggerDamper::Flush, this);
+      return;
+    }
+  Flush ();
+}
+
+void
+TriggerDamper::Clear ()
+{
+  m_event.Cancel ();
+  m_pending.clear ();
+  m_index.clear ();
+}
+
+void
+TriggerDamper::Flush ()
+{
+  if (m_rate > 0)
+    {
+      // updates grown while deferred may overdraw the bucket, later ones wait for it
+      Refill ();
+      m_tokens -= GetSize (m_pending.size ());
+    }
+  m_lastFlush = Simulator::Now ();
+  m_flushedOnce = true;
+  m_flushed.swap (m_pending);
+  m_pending.clear ();
+  m_index.clear ();
+  if (!m_flush.IsNull ())
+    {
+      m_flush (m_iface, m_flushed);
+    }
+}
+
+void
+TriggerDamper::Refill ()
+{
+  Time now = Simulator::Now ();
+  m_tokens = std::min<double> (m_burst, m_tokens + m_rate * (now - m_refilled).GetSeconds ());
+  m_refilled = now;
+}
+
+void
+TriggerDamper::Suppress (SuppressReason reason)
+{
+  if (!m_suppress.IsNull ())
+    {
+      m_suppress (reason);
+    }
+}
+
+}
+}
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+
+#ifndef EFFDSDV_TRIGGER_DAMPER_H
+#define EFFDSDV_TRIGGER_DAMPER_H
+
+#include <vector>
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-interface-address.h"
+#include "ns3/nstime.h"
+#include "ns3/simple-ref-count.h"
+#include "eff-dsdv-address-map.h"
+#include "eff-dsdv-packet.h"
+
+namespace ns3 {
+namespace effdsdv {
+
+/**
+ * \ingroup dsdv
+ * \brief Paces the triggered updates of one interface
+ *
+ * Triggered updates handed to the damper are merged into a single pending update,
+ * a newer entry for a destination replacing the older one. The pending update is
+ * flushed at once unless the interface sent one less than the minimum interval ago,
+ * or the token bucket does not hold enough bytes for it; then a single event flushes
+ * it as soon as both allow. An update larger than the bucket goes out when the
+ * bucket is full and leaves it in debt.
+ */
+class TriggerDamper : public SimpleRefCount<TriggerDamper>
+{
+public:
+  /// Why a triggered update did not go out at once
+  enum SuppressReason
+  {
+    COALESCED,    //!< merged into an update that is already pending
+    MIN_INTERVAL, //!< the interface sent a triggered update too recently
+    RATE_LIMIT,   //!< the token bucket holds too few bytes
+    SUPPRESS_REASONS
+  };
+  /// Invoked with the interface and the entries when the pending update may be sent
+  typedef Callback<void, Ipv4InterfaceAddress, std::vector<DsdvHeader> const &> FlushCallback;
+  /// Invoked whenever a triggered update is held back
+  typedef Callback<void, SuppressReason> SuppressCallback;
+
+  /**
+   * c-tor
+   * \param iface the interface the damper paces
+   */
+  TriggerDamper (Ipv4InterfaceAddress iface = Ipv4InterfaceAddress ());
+  /// d-tor, cancels the pending event
+  ~TriggerDamper ();
+  /**
+   * Set the function sending the pending update
+   * \param callback the function
+   */
+  void
+  SetFlushCallback (FlushCallback callback)
+  {
+    m_flush = callback;
+  }
+  /**
+   * Set the function told about held back updates
+   * \param callback the function
+   */
+  void
+  SetSuppressCallback (SuppressCallback callback)
+  {
+    m_suppress = callback;
+  }
+  /**
+   * Set the minimum time between two flushes
+   * \param interval the interval, zero to disable
+   */
+  void
+  SetMinInterval (Time interval)
+  {
+    m_minInterval = interval;
+  }
+  /**
+   * Set the token bucket for the bytes of triggered updates
+   * \param rate refill rate in bytes per second, zero to disable the bucket
+   * \param burst bucket size in bytes
+   */
+  void
+  SetTokenBucket (uint32_t rate, uint32_t burst);
+  /**
+   * Set how the size of an update is computed from its number of entries
+   * \param overhead bytes per update, e.g. IP, UDP and message headers
+   * \param perEntry bytes per entry
+   */
+  void
+  SetUpdateSize (uint32_t overhead, uint32_t perEntry)
+  {
+    m_overhead = overhead;
+    m_perEntry = perEntry;
+  }
+  /**
+   * Merge entries into the pending update and flush it if pacing allows
+   * \param updates the advertised routes
+   */
+  void
+  Add (std::vector<DsdvHeader> const & updates);
+  /// \returns the number of entries waiting to be sent
+  uint32_t
+  GetPendingCount () const
+  {
+    return m_pending.size ();
+  }
+  /// \returns true if a flush is scheduled
+  bool
+  IsDeferred () const
+  {
+    return m_event.IsRunning ();
+  }
+  /// Drop the pending update and cancel the pending event
+  void
+  Clear ();
+
+private:
+  /// Send the pending update
+  void
+  Flush ();
+  /// Add the tokens accumulated since the last refill
+  void
+  Refill ();
+  /**
+   * \param entries number of entries
+   * \returns the bytes an update with this many entries costs
+   */
+  uint32_t
+  GetSize (uint32_t entries) const
+  {
+    return m_overhead + m_perEntry * entries;
+  }
+  /**
+   * Invoke the suppress callback
+   * \param reason why the update is held back
+   */
+  void
+  Suppress (SuppressReason reason);
+
+  /// the paced interface
+  Ipv4InterfaceAddress m_iface;
+  /// destination -> index into m_pending
+  AddressMap<uint32_t> m_index;
+  /// entries of the pending update, at most one per destination
+  std::vector<DsdvHeader> m_pending;
+  /// handed to the flush callback, reused between flushes
+  std::vector<DsdvHeader> m_flushed;
+  /// the deferred flush
+  EventId m_event;
+  /// time of the last flush
+  Time m_lastFlush;
+  /// whether anything was flushed yet
+  bool m_flushedOnce;
+  /// minimum time between two flushes
+  Time m_minInterval;
+  /// token refill rate in bytes per second, zero if the bucket is disabled
+  uint32_t m_rate;
+  /// bucket size in bytes
+  uint32_t m_burst;
+  /// bytes in the bucket, negative while an oversized update is paid off
+  double m_tokens;
+  /// time of the last refill
+  Time m_refilled;
+  /// bytes per update
+  uint32_t m_overhead;
+  /// bytes per entry
+  uint32_t m_perEntry;
+  /// sends the pending update
+  FlushCallback m_flush;
+  /// told about held back updates
+  SuppressCallback m_suppress;
+};
+
+}
+}
+#endif /* EFFDSDV_TRIGGER_DAMPER_H */
@@ -0,0 +1,487 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+/*
+ * Micro benchmarks for the Eff-DSDV data structures. Run with
+ *
+ *   ./waf --run "test-runner --suite=eff-dsdv-benchmark"
+ *
+ * The numbers are printed to stdout; the test cases only check that the
+ * benchmarked code produced the expected results.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/eff-dsdv-address-map.h"
+#include "ns3/eff-dsdv-rtable.h"
+#include "ns3/eff-dsdv-packet.h"
+
+using namespace ns3;
+using namespace effdsdv;
+
+namespace {
+
+/// Number of calls to the global operator new so far
+uint64_t g_allocations = 0;
+
+}
+
+/*
+ * Counting replacements of the global allocation functions. Whether they
+ * also see the allocations of the other ns-3 libraries depends on how the
+ * test runner is linked, so the benchmarks first check that they are in use.
+ */
+void *
+operator new (std::size_t size)
+{
+  ++g_allocations;
+  void *p = std::malloc (size == 0 ? 1 : size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void
+operator delete (void *p) noexcept
+{
+  std::free (p);
+}
+
+#if __cplusplus >= 201402L
+void
+operator delete (void *p, std::size_t) noexcept
+{
+  std::free (p);
+}
+#endif
+
+namespace {
+
+/// Wall clock used to time the benchmarked loops
+typedef std::chrono::steady_clock BenchmarkClock;
+
+/// \returns true if the allocations of the ns-3 libraries are counted
+bool
+IsCountingAllocations ()
+{
+  uint64_t before = g_allocations;
+  // the packet allocates its buffer inside the network library
+  return Create<Packet> (100)->GetSize () == 100 && g_allocations != before;
+}
+
+/**
+ * The layout of RoutingTableEntry before it became a plain record: it
+ * held its own Ipv4Route, created by every constructor call.
+ */
+struct LegacyRoutingTableEntry
+{
+  /**
+   * c-tor
+   * \param dev the output device
+   * \param dst the destination
+   * \param seqNo the sequence number
+   * \param iface the interface
+   * \param hops the number of hops
+   * \param nextHop the next hop
+   * \param lifetime the lifetime
+   */
+  LegacyRoutingTableEntry (Ptr<NetDevice> dev = 0, Ipv4Address dst = Ipv4Address (), uint32_t seqNo = 0,
+                           Ipv4InterfaceAddress iface = Ipv4InterfaceAddress (), uint32_t hops = 0,
+                           Ipv4Address nextHop = Ipv4Address (), Time lifetime = Simulator::Now ())
+    : m_seqNo (seqNo),
+      m_hops (hops),
+      m_lifeTime (lifetime),
+      m_iface (iface),
+      m_flag (VALID),
+      m_settlingTime (Simulator::Now ()),
+      m_entriesChanged (false)
+  {
+    m_ipv4Route = Create<Ipv4Route> ();
+    m_ipv4Route->SetDestination (dst);
+    m_ipv4Route->SetGateway (nextHop);
+    m_ipv4Route->SetSource (m_iface.GetLocal ());
+    m_ipv4Route->SetOutputDevice (dev);
+  }
+  uint32_t m_seqNo;              ///< sequence number
+  uint32_t m_hops;               ///< hop count
+  Time m_lifeTime;               ///< lifetime
+  Time m_installTime;            ///< install time
+  Ptr<Ipv4Route> m_ipv4Route;    ///< the route, one per entry
+  Ipv4InterfaceAddress m_iface;  ///< the interface
+  RouteFlags m_flag;             ///< route flag
+  Time m_settlingTime;           ///< settling time
+  uint32_t m_entriesChanged;     ///< changed flag
+};
+
+/**
+ * \param start start of the measured interval
+ * \param ops number of operations performed in the interval
+ * \returns the average time per operation in nanoseconds
+ */
+double
+NanoSecondsPerOp (BenchmarkClock::time_point start, uint32_t ops)
+{
+  std::chrono::duration<double, std::nano> elapsed = BenchmarkClock::now () - start;
+  return elapsed.count () / ops;
+}
+
+/**
+ * \param n number of destinations
+ * \returns n distinct addresses out of 10.0.0.0/8
+ */
+std::vector<Ipv4Address>
+MakeDestinations (uint32_t n)
+{
+  std::vector<Ipv4Address> destinations;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      destinations.push_back (Ipv4Address (0x0a000001 + i));
+    }
+  return destinations;
+}
+
+/**
+ * \param destinations the known destinations
+ * \param n number of lookups
+ * \returns a pseudo-random lookup sequence over the known destinations
+ */
+std::vector<Ipv4Address>
+MakeLookupSequence (std::vector<Ipv4Address> const & destinations, uint32_t n)
+{
+  std::vector<Ipv4Address> sequence;
+  sequence.reserve (n);
+  uint32_t state = 12345;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      state = state * 1103515245 + 12345;
+      sequence.push_back (destinations[(state >> 8) % destinations.size ()]);
+    }
+  return sequence;
+}
+
+}
+
+/**
+ * \ingroup eff-dsdv-test
+ * \ingroup tests
+ *
+ * \brief Compare RoutingTable::LookupRoute against the former std::map storage
+ */
+class RoutingTableLookupBenchmark : public TestCase
+{
+public:
+  /**
+   * c-tor
+   * \param destinations number of routes in the table
+   */
+  RoutingTableLookupBenchmark (uint32_t destinations)
+    : TestCase ("Eff-DSDV RoutingTable lookup benchmark"),
+      m_destinations (destinations)
+  {
+  }
+  virtual void DoRun ()
+  {
+    const uint32_t lookups = 2000000;
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface (Ipv4Address ("10.255.255.254"), Ipv4Mask ("255.0.0.0"));
+    std::vector<Ipv4Address> destinations = MakeDestinations (m_destinations);
+    std::vector<Ipv4Address> sequence = MakeLookupSequence (destinations, lookups);
+
+    RoutingTable table;
+    std::map<Ipv4Address, RoutingTableEntry> reference;
+    for (uint32_t i = 0; i < destinations.size (); ++i)
+      {
+        RoutingTableEntry entry (/*device=*/ dev, /*dst=*/ destinations[i], /*seqno=*/ 2,
+                                 /*iface=*/ iface, /*hops=*/ 2, /*next hop=*/ destinations[0],
+                                 /*lifetime=*/ Seconds (10));
+        table.AddRoute (entry);
+        reference.insert (std::make_pair (destinations[i], entry));
+      }
+
+    uint32_t hits = 0;
+    RoutingTableEntry rt;
+    BenchmarkClock::time_point start = BenchmarkClock::now ();
+    for (uint32_t i = 0; i < lookups; ++i)
+      {
+        std::map<Ipv4Address, RoutingTableEntry>::const_iterator it = reference.find (sequence[i]);
+        if (it != reference.end ())
+          {
+            rt = it->second;
+            ++hits;
+          }
+      }
+    double mapNs = NanoSecondsPerOp (start, lookups);
+    NS_TEST_EXPECT_MSG_EQ (hits, lookups, "every destination is known to std::map");
+
+    hits = 0;
+    start = BenchmarkClock::now ();
+    for (uint32_t i = 0; i < lookups; ++i)
+      {
+        if (table.LookupRoute (sequence[i], rt))
+          {
+            ++hits;
+          }
+      }
+    double tableNs = NanoSecondsPerOp (start, lookups);
+    NS_TEST_EXPECT_MSG_EQ (hits, lookups, "every destination is known to the routing table");
+
+    std::cout << "RoutingTable::LookupRoute, " << std::setw (5) << m_destinations << " destinations: "
+              << std::fixed << std::setprecision (1) << tableNs << " ns/lookup (std::map: "
+              << mapNs << " ns/lookup)" << std::endl;
+    Simulator::Destroy ();
+  }
+
+private:
+  uint32_t m_destinations; ///< number of routes in the table
+};
+
+/**
+ * \ingroup eff-dsdv-test
+ * \ingroup tests
+ *
+ * \brief Measure the lookup pattern of the routing protocol: a fresh local entry per
+ * lookup, optionally followed by GetRoute (), against the former layout of the entry
+ */
+class RoutingTableEntryBenchmark : public TestCase
+{
+public:
+  RoutingTableEntryBenchmark ()
+    : TestCase ("Eff-DSDV RoutingTableEntry benchmark")
+  {
+  }
+  virtual void DoRun ()
+  {
+    const uint32_t lookups = 2000000;
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface (Ipv4Address ("10.255.255.254"), Ipv4Mask ("255.0.0.0"));
+    std::vector<Ipv4Address> destinations = MakeDestinations (1000);
+    std::vector<Ipv4Address> sequence = MakeLookupSequence (destinations, lookups);
+    RoutingTable table;
+    for (uint32_t i = 0; i < destinations.size (); ++i)
+      {
+        RoutingTableEntry entry (/*device=*/ dev, /*dst=*/ destinations[i], /*seqno=*/ 2,
+                                 /*iface=*/ iface, /*hops=*/ 2, /*next hop=*/ destinations[0],
+                                 /*lifetime=*/ Seconds (10));
+        table.AddRoute (entry);
+      }
+
+    AddressMap<LegacyRoutingTableEntry> legacy;
+    for (uint32_t i = 0; i < destinations.size (); ++i)
+      {
+        legacy[destinations[i]] = LegacyRoutingTableEntry (/*device=*/ dev, /*dst=*/ destinations[i], /*seqno=*/ 2,
+                                                           /*iface=*/ iface, /*hops=*/ 2, /*next hop=*/ destinations[0],
+                                                           /*lifetime=*/ Seconds (10));
+      }
+
+    uint32_t hits = 0;
+    uint64_t allocations = g_allocations;
+    BenchmarkClock::time_point start = BenchmarkClock::now ();
+    for (uint32_t i = 0; i < lookups; ++i)
+      {
+        LegacyRoutingTableEntry rt;
+        AddressMap<LegacyRoutingTableEntry>::const_iterator it = legacy.find (sequence[i]);
+        if (it != legacy.end ())
+          {
+            rt = it->second;
+            ++hits;
+          }
+      }
+    double legacyNs = NanoSecondsPerOp (start, lookups);
+    double legacyAllocs = double (g_allocations - allocations) / lookups;
+    NS_TEST_EXPECT_MSG_EQ (hits, lookups, "every destination is known to the legacy layout");
+
+    hits = 0;
+    allocations = g_allocations;
+    start = BenchmarkClock::now ();
+    for (uint32_t i = 0; i < lookups; ++i)
+      {
+        RoutingTableEntry rt;
+        if (table.LookupRoute (sequence[i], rt))
+          {
+            ++hits;
+          }
+      }
+    double lookupNs = NanoSecondsPerOp (start, lookups);
+    double lookupAllocs = double (g_allocations - allocations) / lookups;
+    NS_TEST_EXPECT_MSG_EQ (hits, lookups, "every destination is known");
+
+    hits = 0;
+    allocations = g_allocations;
+    start = BenchmarkClock::now ();
+    for (uint32_t i = 0; i < lookups; ++i)
+      {
+        RoutingTableEntry rt;
+        if (table.LookupRoute (sequence[i], rt) && rt.GetRoute ()->GetDestination () == sequence[i])
+          {
+            ++hits;
+          }
+      }
+    double routeNs = NanoSecondsPerOp (start, lookups);
+    double routeAllocs = double (g_allocations - allocations) / lookups;
+    NS_TEST_EXPECT_MSG_EQ (hits, lookups, "routes point to the destination");
+
+    std::cout << std::fixed << std::setprecision (1)
+              << "RoutingTableEntry before: " << sizeof (LegacyRoutingTableEntry) << " bytes + "
+              << sizeof (Ipv4Route) << " bytes Ipv4Route, "
+              << legacyNs << " ns/lookup into a local entry" << std::endl
+              << "RoutingTableEntry after:  " << sizeof (RoutingTableEntry) << " bytes, "
+              << lookupNs << " ns/lookup into a local entry, "
+              << routeNs << " ns/lookup with GetRoute ()" << std::endl;
+    if (IsCountingAllocations ())
+      {
+        std::cout << std::setprecision (2)
+                  << "Allocations per lookup: before " << legacyAllocs << ", after " << lookupAllocs
+                  << ", after with GetRoute () " << routeAllocs << std::endl;
+        NS_TEST_EXPECT_MSG_EQ (lookupAllocs, 0, "a lookup into a local entry does not allocate");
+      }
+    else
+      {
+        std::cout << "Allocations per lookup: not counted, operator new is not replaced in this build" << std::endl;
+      }
+    Simulator::Destroy ();
+  }
+};
+
+/**
+ * \ingroup eff-dsdv-test
+ * \ingroup tests
+ *
+ * \brief Compare building an update packet with one AddHeader pair per route
+ * against DsdvBatchHeader and BulkDsdvHeader
+ */
+class UpdatePacketBenchmark : public TestCase
+{
+public:
+  /**
+   * c-tor
+   * \param entries number of routes in the update
+   */
+  UpdatePacketBenchmark (uint32_t entries)
+    : TestCase ("Eff-DSDV update packet construction benchmark"),
+      m_entries (entries)
+  {
+  }
+  virtual void DoRun ()
+  {
+    const uint32_t packets = 1000000 / m_entries;
+    std::vector<Ipv4Address> destinations = MakeDestinations (m_entries);
+    std::vector<DsdvHeader> updates;
+    for (uint32_t i = 0; i < destinations.size (); ++i)
+      {
+        updates.push_back (DsdvHeader (destinations[i], i % 16 + 1, 2 * i));
+      }
+
+    uint64_t bytes = 0;
+    BenchmarkClock::time_point start = BenchmarkClock::now ();
+    for (uint32_t n = 0; n < packets; ++n)
+      {
+        Ptr<Packet> packet = Create<Packet> ();
+        for (std::vector<DsdvHeader>::const_iterator i = updates.begin (); i != updates.end (); ++i)
+          {
+            packet->AddHeader (*i);
+            packet->AddHeader (TypeHeader (DSDVTYPE_DSDV));
+          }
+        bytes += packet->GetSize ();
+      }
+    double pairNs = NanoSecondsPerOp (start, packets);
+    NS_TEST_EXPECT_MSG_EQ (bytes, uint64_t (packets) * m_entries * 12, "12 bytes per route");
+
+    bytes = 0;
+    start = BenchmarkClock::now ();
+    for (uint32_t n = 0; n < packets; ++n)
+      {
+        Ptr<Packet> packet = Create<Packet> ();
+        DsdvBatchHeader batch;
+        for (std::vector<DsdvHeader>::const_iterator i = updates.end (); i != updates.begin (); )
+          {
+            batch.AddEntry (*--i);
+          }
+        packet->AddHeader (batch);
+        bytes += packet->GetSize ();
+      }
+    double batchNs = NanoSecondsPerOp (start, packets);
+    NS_TEST_EXPECT_MSG_EQ (bytes, uint64_t (packets) * m_entries * 12, "12 bytes per route");
+
+    bytes = 0;
+    start = BenchmarkClock::now ();
+    for (uint32_t n = 0; n < packets; ++n)
+      {
+        Ptr<Packet> packet = Create<Packet> ();
+        BulkDsdvHeader bulk;
+        for (std::vector<DsdvHeader>::const_iterator i = updates.begin (); i != updates.end (); ++i)
+          {
+            bulk.AddEntry (*i);
+          }
+        packet->AddHeader (bulk);
+        packet->AddHeader (TypeHeader (DSDVTYPE_BULK));
+        bytes += packet->GetSize ();
+      }
+    double bulkNs = NanoSecondsPerOp (start, packets);
+    NS_TEST_EXPECT_MSG_EQ (bytes, uint64_t (packets) * (4 + m_entries * 9), "9 bytes per route");
+
+    std::cout << "Update packet, " << std::setw (4) << m_entries << " routes: "
+              << std::fixed << std::setprecision (1) << pairNs / 1000 << " us with AddHeader pairs, "
+              << batchNs / 1000 << " us with DsdvBatchHeader, "
+              << bulkNs / 1000 << " us with BulkDsdvHeader" << std::endl;
+    Simulator::Destroy ();
+  }
+
+private:
+  uint32_t m_entries; ///< number of routes in the update
+};
+
+/**
+ * \ingroup eff-dsdv-test
+ * \ingroup tests
+ *
+ * \brief Eff-DSDV benchmark suite
+ */
+class EffDsdvBenchmarkSuite : public TestSuite
+{
+public:
+  EffDsdvBenchmarkSuite ();
+};
+
+EffDsdvBenchmarkSuite::EffDsdvBenchmarkSuite ()
+  : TestSuite ("eff-dsdv-benchmark", PERFORMANCE)
+{
+  AddTestCase (new RoutingTableLookupBenchmark (100), TestCase::QUICK);
+  AddTestCase (new RoutingTableLookupBenchmark (1000), TestCase::QUICK);
+  AddTestCase (new RoutingTableLookupBenchmark (10000), TestCase::QUICK);
+  AddTestCase (new RoutingTableEntryBenchmark (), TestCase::QUICK);
+  AddTestCase (new UpdatePacketBenchmark (10), TestCase::QUICK);
+  AddTestCase (new UpdatePacketBenchmark (100), TestCase::QUICK);
+  AddTestCase (new UpdatePacketBenchmark (1000), TestCase::QUICK);
+}
+
+static EffDsdvBenchmarkSuite effDsdvBenchmarkSuite;
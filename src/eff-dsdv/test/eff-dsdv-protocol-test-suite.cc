@@ -0,0 +1,570 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+* Copyright (c) 2018 Thorben Ole Hellweg
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Thorben Ole Hellweg <t_hell07@uni-muenster.de>
+ *
+ * Based on the corresponding DSDV module, provided by Narra et al.
+*/
+
+/*
+ * Test cases that drive the protocol of a single node and check the control
+ * packets it sends.
+ */
+
+#include <vector>
+#include "ns3/eff-dsdv-routing-protocol.h"
+#include "ns3/eff-dsdv-helper.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/mac48-address.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-l4-protocol.h"
+
+using namespace ns3;
+using namespace effdsdv;
+
+/**
+ * \ingroup eff-dsdv-test
+ * \ingroup tests
+ *
+ * \brief Base of the test cases that drive the protocol of a single node
+ *
+ * The node has one SimpleNetDevice with address 10.1.1.1/24. Every control
+ * packet it sends is decoded and kept with its send time. The base is a
+ * friend of the protocol and hands its internals to the test cases.
+ */
+struct EffDsdvProtocolTestCase : public TestCase
+{
+  /// A control packet sent by the node
+  struct SentPacket
+  {
+    Time time;               ///< when it was sent
+    Ipv4Address destination; ///< where it was sent to
+    std::vector<DsdvHeader> updates;  ///< the routes it advertised
+    std::vector<RreqHeader> requests; ///< the routes it asked for
+    std::vector<RackHeader> acks;     ///< the routes it acknowledged
+  };
+
+  /**
+   * Constructor
+   * \param name the name of the test case
+   */
+  EffDsdvProtocolTestCase (std::string name) : TestCase (name)
+  {
+  }
+  /**
+   * Create the node; its protocol starts with the next run
+   * \param helper the helper holding the attributes of the test case
+   * \param mtu the MTU of the device
+   */
+  void CreateNode (EffDsdvHelper const & helper, uint16_t mtu = 1500)
+  {
+    m_node = CreateObject<Node> ();
+    m_device = CreateObject<SimpleNetDevice> ();
+    m_device->SetAddress (Mac48Address::Allocate ());
+    m_device->SetMtu (mtu);
+    m_device->SetChannel (CreateObject<SimpleChannel> ());
+    m_node->AddDevice (m_device);
+    InternetStackHelper stack;
+    stack.SetRoutingHelper (helper);
+    stack.Install (m_node);
+    Ptr<Ipv4> ipv4 = m_node->GetObject<Ipv4> ();
+    uint32_t i = ipv4->AddInterface (m_device);
+    m_iface = Ipv4InterfaceAddress (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0"));
+    ipv4->AddAddress (i, m_iface);
+    ipv4->SetUp (i);
+    m_node->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("SendOutgoing",
+                                                                      MakeCallback (&EffDsdvProtocolTestCase::SendOutgoing, this));
+    m_protocol = m_node->GetObject<RoutingProtocol> ();
+  }
+  /**
+   * Run the simulation
+   * \param duration how long to run it for
+   */
+  void RunFor (Time duration)
+  {
+    Simulator::Stop (duration);
+    Simulator::Run ();
+  }
+  /**
+   * Build a valid route over the device of the node
+   * \param dst the destination
+   * \param hops the hop count
+   * \param nextHop the next hop
+   * \returns the route, updated just now
+   */
+  RoutingTableEntry MakeRoute (Ipv4Address dst, uint16_t hops, Ipv4Address nextHop) const
+  {
+    RoutingTableEntry rt (/*device=*/ m_device, /*dst=*/ dst, /*seqno=*/ 2, /*iface=*/ m_iface,
+                          /*hops=*/ hops, /*next hop=*/ nextHop, /*lifetime=*/ Simulator::Now ());
+    rt.SetFlag (VALID);
+    return rt;
+  }
+  /// \returns the main routing table of the node
+  RoutingTable & GetRoutingTable ()
+  {
+    return m_protocol->m_routingTable;
+  }
+  /// \returns the alternative routing table of the node
+  RoutingTable & GetAltRoutingTable ()
+  {
+    return m_protocol->m_altRoutingTable;
+  }
+  /// \returns the routes towards the neighbors of the node
+  NeighborTable & GetNeighborRoutes ()
+  {
+    return m_protocol->m_neighborRoutes;
+  }
+  /// \returns the packet buffer of the node
+  PacketQueue & GetQueue ()
+  {
+    return m_protocol->m_queue;
+  }
+  /**
+   * Ask for a route
+   * \param dst the destination
+   */
+  void SendRouteRequest (Ipv4Address dst)
+  {
+    m_protocol->SendRouteRequest (dst);
+  }
+  /**
+   * Acknowledge a route to a requester
+   * \param rt the route
+   * \param requester the node that asked for it
+   */
+  void SendRouteAck (RoutingTableEntry const & rt, Ipv4Address requester)
+  {
+    m_protocol->SendRouteAck (rt, requester, m_iface.GetLocal ());
+  }
+  /**
+   * Receive a route ack
+   * \param rack the ack
+   * \param sender the neighbor it came from
+   */
+  void RecvRouteAck (RackHeader const & rack, Ipv4Address sender)
+  {
+    m_protocol->RecvRouteAck (rack, m_iface.GetLocal (), sender);
+  }
+  /**
+   * Take note of a control packet from a neighbor
+   * \param neighbor the neighbor
+   */
+  void Heard (Ipv4Address neighbor)
+  {
+    m_protocol->m_lastHeard[neighbor] = Simulator::Now ();
+  }
+  /**
+   * Look a route up like the data path does
+   * \param dst the destination
+   * \param rt the route found
+   * \returns true if there is a usable route
+   */
+  bool LookupRoute (Ipv4Address dst, RoutingTableEntry & rt)
+  {
+    return m_protocol->LookupRoute (dst, rt);
+  }
+  /// Send the next periodic update now
+  void SendPeriodicUpdate ()
+  {
+    m_protocol->m_periodicUpdateTimer.Cancel ();
+    m_protocol->SendPeriodicUpdate ();
+  }
+  /**
+   * Find the advertised route to a destination in a sent packet
+   * \param sent the packet
+   * \param dst the destination
+   * \param update the advertisement found
+   * \returns true if the packet advertises a route to the destination
+   */
+  static bool Find (SentPacket const & sent, Ipv4Address dst, DsdvHeader & update)
+  {
+    for (std::vector<DsdvHeader>::const_iterator i = sent.updates.begin (); i != sent.updates.end (); ++i)
+      {
+        if (i->GetDst () == dst)
+          {
+            update = *i;
+            return true;
+          }
+      }
+    return false;
+  }
+  /**
+   * Find the ack for a destination in a sent packet
+   * \param sent the packet
+   * \param dst the destination
+   * \param ack the ack found
+   * \returns true if the packet acknowledges a route to the destination
+   */
+  static bool Find (SentPacket const & sent, Ipv4Address dst, RackHeader & ack)
+  {
+    for (std::vector<RackHeader>::const_iterator i = sent.acks.begin (); i != sent.acks.end (); ++i)
+      {
+        if (i->GetDst () == dst)
+          {
+            ack = *i;
+            return true;
+          }
+      }
+    return false;
+  }
+  /**
+   * Record a control packet sent by the node
+   * \param header the IP header
+   * \param packet the packet, starting with the UDP header
+   */
+  void SendOutgoing (Ipv4Header const & header, Ptr<const Packet> packet, uint32_t)
+  {
+    if (header.GetProtocol () != UdpL4Protocol::PROT_NUMBER)
+      {
+        return;
+      }
+    Ptr<Packet> copy = packet->Copy ();
+    UdpHeader udpHeader;
+    copy->RemoveHeader (udpHeader);
+    if (udpHeader.GetDestinationPort () != RoutingProtocol::DSDV_PORT)
+      {
+        return;
+      }
+    ControlPacketParser parser;
+    copy->PeekHeader (parser);
+    SentPacket sent;
+    sent.time = Simulator::Now ();
+    sent.destination = header.GetDestination ();
+    std::vector<ControlPacketParser::Message> const & messages = parser.GetMessages ();
+    for (std::vector<ControlPacketParser::Message>::const_iterator i = messages.begin (); i != messages.end (); ++i)
+      {
+        switch (i->type)
+          {
+          case DSDVTYPE_DSDV:
+            sent.updates.push_back (ControlPacketParser::GetDsdvHeader (*i));
+            break;
+          case DSDVTYPE_RREQ:
+            sent.requests.push_back (ControlPacketParser::GetRreqHeader (*i));
+            break;
+          case DSDVTYPE_RACK:
+            sent.acks.push_back (ControlPacketParser::GetRackHeader (*i));
+            break;
+          default:
+            break;
+          }
+      }
+    m_sent.push_back (sent);
+  }
+  virtual void DoTeardown ()
+  {
+    m_sent.clear ();
+    m_protocol = 0;
+    m_device = 0;
+    m_node = 0;
+    Simulator::Destroy ();
+  }
+
+  Ptr<Node> m_node;                  ///< the node
+  Ptr<SimpleNetDevice> m_device;     ///< its device
+  Ipv4InterfaceAddress m_iface;      ///< its address
+  Ptr<RoutingProtocol> m_protocol;   ///< the protocol under test
+  std::vector<SentPacket> m_sent;    ///< control packets sent so far
+};
+
+struct EffDsdvQueueDrainTestCase : public EffDsdvProtocolTestCase
+{
+  EffDsdvQueueDrainTestCase () : EffDsdvProtocolTestCase ("Eff-DSDV paced drain of buffered packets")
+  {
+  }
+  virtual void DoRun ()
+  {
+    EffDsdvHelper effDsdv;
+    effDsdv.Set ("PeriodicUpdateInterval", TimeValue (Seconds (1000)));
+    effDsdv.Set ("QueueDrainBurst", UintegerValue (2));
+    effDsdv.Set ("QueueDrainGap", TimeValue (MilliSeconds (50)));
+    CreateNode (effDsdv);
+    RunFor (Seconds (1));
+
+    Ipv4Address dst ("10.1.1.2");
+    Ipv4Header header;
+    header.SetDestination (dst);
+    for (uint32_t i = 0; i < 5; ++i)
+      {
+        QueueEntry entry (Create<Packet> (100), header, MakeCallback (&EffDsdvQueueDrainTestCase::Forward, this));
+        NS_TEST_ASSERT_MSG_EQ (GetQueue ().Enqueue (entry), true, "packet buffered");
+      }
+    RunFor (Seconds (1));
+    NS_TEST_EXPECT_MSG_EQ (m_forwarded.size (), 0, "nothing sent without a route");
+
+    Time installed = Simulator::Now ();
+    RoutingTableEntry rt = MakeRoute (dst, 1, dst);
+    GetRoutingTable ().AddRoute (rt);
+    RunFor (Seconds (1));
+    NS_TEST_ASSERT_MSG_EQ (m_forwarded.size (), 5, "all buffered packets sent");
+    for (uint32_t i = 0; i < m_forwarded.size (); ++i)
+      {
+        // bursts of two, one drain gap apart, starting with the route
+        NS_TEST_EXPECT_MSG_EQ (m_forwarded[i], installed + MilliSeconds (50 * (i / 2)), "packet sent with its burst");
+      }
+    NS_TEST_EXPECT_MSG_EQ (GetQueue ().GetSize (), 0, "buffer drained");
+  }
+  /**
+   * Record a drained packet
+   * \param route the route it was sent on
+   * \param header its IP header
+   */
+  void Forward (Ptr<Ipv4Route> route, Ptr<const Packet>, Ipv4Header const & header)
+  {
+    NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), header.GetDestination (), "sent to the neighbor");
+    m_forwarded.push_back (Simulator::Now ());
+  }
+  std::vector<Time> m_forwarded; ///< when each drained packet was sent
+};
+
+struct EffDsdvIncrementalDumpTestCase : public EffDsdvProtocolTestCase
+{
+  EffDsdvIncrementalDumpTestCase () : EffDsdvProtocolTestCase ("Eff-DSDV incremental dumps between full dumps")
+  {
+  }
+  virtual void DoRun ()
+  {
+    EffDsdvHelper effDsdv;
+    effDsdv.Set ("PeriodicUpdateInterval", TimeValue (Seconds (1000)));
+    effDsdv.Set ("FullDumpInterval", UintegerValue (3));
+    CreateNode (effDsdv);
+    // the first periodic update is a full dump
+    RunFor (Seconds (1));
+
+    Ipv4Address own ("10.1.1.1"), a ("10.1.1.2"), b ("10.1.1.3"), c ("10.1.2.1");
+    RoutingTableEntry rt = MakeRoute (a, 1, a);
+    GetRoutingTable ().AddRoute (rt);
+    rt = MakeRoute (b, 1, b);
+    GetRoutingTable ().AddRoute (rt);
+    rt = MakeRoute (c, 2, a);
+    GetRoutingTable ().AddRoute (rt);
+    DsdvHeader update;
+
+    m_sent.clear ();
+    SendPeriodicUpdate ();
+    NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 1, "second update sent");
+    NS_TEST_EXPECT_MSG_EQ (m_sent[0].updates.size (), 4, "routes never advertised count as changed");
+
+    GetRoutingTable ().LookupRoute (b, rt);
+    rt.SetSeqNo (4);
+    GetRoutingTable ().Update (rt);
+    GetRoutingTable ().LookupRoute (c, rt);
+    rt.SetHop (3);
+    GetRoutingTable ().Update (rt);
+    m_sent.clear ();
+    SendPeriodicUpdate ();
+    NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 1, "third update sent");
+    NS_TEST_EXPECT_MSG_EQ (m_sent[0].updates.size (), 3, "own entry and the two changed routes");
+    NS_TEST_EXPECT_MSG_EQ (Find (m_sent[0], own, update), true, "own entry is always sent");
+    NS_TEST_EXPECT_MSG_EQ (Find (m_sent[0], a, update), false, "unchanged route left out");
+    NS_TEST_ASSERT_MSG_EQ (Find (m_sent[0], b, update), true, "new sequence number sent");
+    NS_TEST_EXPECT_MSG_EQ (update.GetDstSeqno (), 4, "sequence number of b");
+    NS_TEST_ASSERT_MSG_EQ (Find (m_sent[0], c, update), true, "new metric sent");
+    NS_TEST_EXPECT_MSG_EQ (update.GetHopCount (), 4, "metric of c");
+
+    // every third update is a full dump
+    m_sent.clear ();
+    SendPeriodicUpdate ();
+    NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 1, "fourth update sent");
+    NS_TEST_EXPECT_MSG_EQ (m_sent[0].updates.size (), 4, "full dump carries every route");
+
+    m_sent.clear ();
+    SendPeriodicUpdate ();
+    NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 1, "fifth update sent");
+    NS_TEST_EXPECT_MSG_EQ (m_sent[0].updates.size (), 1, "nothing changed since the full dump");
+    NS_TEST_EXPECT_MSG_EQ (Find (m_sent[0], own, update), true, "only the own entry");
+  }
+};
+
+struct EffDsdvUpdateSpreadTestCase : public EffDsdvProtocolTestCase
+{
+  EffDsdvUpdateSpreadTestCase () : EffDsdvProtocolTestCase ("Eff-DSDV updates split by MTU and spread over a window")
+  {
+  }
+  virtual void DoRun ()
+  {
+    EffDsdvHelper effDsdv;
+    effDsdv.Set ("PeriodicUpdateInterval", TimeValue (Seconds (1000)));
+    effDsdv.Set ("UpdateSpreadWindow", TimeValue (MilliSeconds (30)));
+    // room for four DSDV messages behind the IP and UDP headers
+    uint32_t messageSize = TypeHeader ().GetSerializedSize () + DsdvHeader ().GetSerializedSize ();
+    CreateNode (effDsdv, 28 + 4 * messageSize + 3);
+    RunFor (Seconds (1));
+
+    // ten routes and the own entry make three packets
+    for (uint32_t i = 0; i < 10; ++i)
+      {
+        Ipv4Address dst (0x0a010202 + i);
+        RoutingTableEntry rt = MakeRoute (dst, 2, Ipv4Address ("10.1.1.2"));
+        GetRoutingTable ().AddRoute (rt);
+      }
+    m_sent.clear ();
+    Time start = Simulator::Now ();
+    SendPeriodicUpdate ();
+    RunFor (Seconds (1));
+    NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 3, "update split into three packets");
+    uint32_t entries = 0;
+    Time slot = MilliSeconds (10);
+    for (uint32_t k = 0; k < m_sent.size (); ++k)
+      {
+        entries += m_sent[k].updates.size ();
+        NS_TEST_EXPECT_MSG_LT_OR_EQ (m_sent[k].updates.size (), 4, "packet fits the MTU");
+        // each packet goes out within its share of the window
+        NS_TEST_EXPECT_MSG_GT_OR_EQ (m_sent[k].time, start + NanoSeconds (slot.GetNanoSeconds () * k), "not before its slot");
+        NS_TEST_EXPECT_MSG_LT (m_sent[k].time, start + NanoSeconds (slot.GetNanoSeconds () * (k + 1)), "not after its slot");
+      }
+    NS_TEST_EXPECT_MSG_EQ (m_sent[0].time, start, "first packet sent at once");
+    NS_TEST_EXPECT_MSG_EQ (entries, 11, "every entry sent once");
+  }
+};
+
+struct EffDsdvRequestBatchTestCase : public EffDsdvProtocolTestCase
+{
+  EffDsdvRequestBatchTestCase () : EffDsdvProtocolTestCase ("Eff-DSDV route requests and acks batched per window")
+  {
+  }
+  virtual void DoRun ()
+  {
+    EffDsdvHelper effDsdv;
+    effDsdv.Set ("PeriodicUpdateInterval", TimeValue (Seconds (1000)));
+    effDsdv.Set ("RreqBatchWindow", TimeValue (MilliSeconds (10)));
+    effDsdv.Set ("RackBatchWindow", TimeValue (MilliSeconds (5)));
+    CreateNode (effDsdv);
+    RunFor (Seconds (1));
+
+    Ipv4Address a ("10.1.2.1"), b ("10.1.2.2"), c ("10.1.2.3");
+    m_sent.clear ();
+    Time start = Simulator::Now ();
+    SendRouteRequest (a);
+    SendRouteRequest (b);
+    SendRouteRequest (c);
+    NS_TEST_EXPECT_MSG_EQ (m_sent.size (), 0, "requests wait for the window to close");
+    RunFor (Seconds (1));
+    NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 1, "one request for the window");
+    NS_TEST_EXPECT_MSG_GT_OR_EQ (m_sent[0].time, start + MilliSeconds (10), "sent after the window");
+    NS_TEST_EXPECT_MSG_EQ (m_sent[0].destination, m_iface.GetBroadcast (), "request broadcast");
+    NS_TEST_EXPECT_MSG_EQ (m_sent[0].updates.size (), 0, "no advertisements");
+    NS_TEST_ASSERT_MSG_EQ (m_sent[0].requests.size (), 3, "every destination in the request");
+    uint16_t requestId = m_sent[0].requests[0].GetRequestId ();
+    for (uint32_t i = 0; i < m_sent[0].requests.size (); ++i)
+      {
+        NS_TEST_EXPECT_MSG_EQ (m_sent[0].requests[i].GetRequestId (), requestId, "single request ID");
+      }
+
+    // the next window is a request of its own
+    m_sent.clear ();
+    SendRouteRequest (Ipv4Address ("10.1.2.4"));
+    RunFor (Seconds (1));
+    NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 1, "one request for the next window");
+    NS_TEST_ASSERT_MSG_EQ (m_sent[0].requests.size (), 1, "single destination");
+    NS_TEST_EXPECT_MSG_NE (m_sent[0].requests[0].GetRequestId (), requestId, "new request ID");
+
+    // acks for one requester, the later ack for a destination replacing the earlier one
+    Ipv4Address requester ("10.1.1.2"), nextHop ("10.1.1.3");
+    RoutingTableEntry rt = MakeRoute (requester, 1, requester);
+    GetRoutingTable ().AddRoute (rt);
+    m_sent.clear ();
+    start = Simulator::Now ();
+    SendRouteAck (MakeRoute (a, 3, nextHop), requester);
+    SendRouteAck (MakeRoute (b, 2, nextHop), requester);
+    SendRouteAck (MakeRoute (a, 2, nextHop), requester);
+    NS_TEST_EXPECT_MSG_EQ (m_sent.size (), 0, "acks wait for the window to close");
+    RunFor (Seconds (1));
+    NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 1, "one ack packet for the requester");
+    NS_TEST_EXPECT_MSG_GT_OR_EQ (m_sent[0].time, start + MilliSeconds (5), "sent after the window");
+    NS_TEST_EXPECT_MSG_EQ (m_sent[0].destination, requester, "ack sent to the requester");
+    NS_TEST_ASSERT_MSG_EQ (m_sent[0].acks.size (), 2, "one entry per destination");
+    RackHeader ack;
+    NS_TEST_ASSERT_MSG_EQ (Find (m_sent[0], a, ack), true, "ack for a");
+    NS_TEST_EXPECT_MSG_EQ (ack.GetHopCount (), 3, "latest route to a acknowledged");
+    NS_TEST_EXPECT_MSG_EQ (Find (m_sent[0], b, ack), true, "ack for b");
+  }
+};
+
+struct EffDsdvFailoverTestCase : public EffDsdvProtocolTestCase
+{
+  EffDsdvFailoverTestCase () : EffDsdvProtocolTestCase ("Eff-DSDV failover to the ranked alternative routes")
+  {
+  }
+  virtual void DoRun ()
+  {
+    EffDsdvHelper effDsdv;
+    effDsdv.Set ("PeriodicUpdateInterval", TimeValue (Seconds (1000)));
+    CreateNode (effDsdv);
+    RunFor (Seconds (1));
+
+    Ipv4Address dst ("10.1.2.1"), broken ("10.1.1.2"), best ("10.1.1.3"), second ("10.1.1.4"), third ("10.1.1.5");
+    RoutingTableEntry rt = MakeRoute (broken, 1, broken);
+    GetRoutingTable ().AddRoute (rt);
+    rt = MakeRoute (dst, 2, broken);
+    GetRoutingTable ().AddRoute (rt);
+    // the alternative table holds the best ranked candidate, whatever order the acks come in
+    RecvRouteAck (RackHeader (dst, 3, Seconds (0)), second);
+    RecvRouteAck (RackHeader (dst, 2, Seconds (0)), best);
+    RecvRouteAck (RackHeader (dst, 4, Seconds (0)), third);
+    NS_TEST_ASSERT_MSG_EQ (GetAltRoutingTable ().LookupRoute (dst, rt), true, "alternative route installed");
+    NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), best, "best candidate installed");
+
+    // the next hop of the best candidate has gone silent, the second one is still heard
+    Heard (second);
+    Heard (third);
+    GetRoutingTable ().LookupRoute (broken, rt);
+    rt.SetFlag (INVALID);
+    GetRoutingTable ().Update (rt);
+    GetRoutingTable ().LookupRoute (dst, rt);
+    rt.SetFlag (INVALID);
+    GetRoutingTable ().Update (rt);
+    NS_TEST_ASSERT_MSG_EQ (LookupRoute (dst, rt), true, "alternative route used");
+    NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), second, "failed over to the next ranked candidate");
+    NS_TEST_EXPECT_MSG_EQ (m_protocol->GetAlternativeFailovers (), 1, "one failover");
+    NS_TEST_ASSERT_MSG_EQ (GetAltRoutingTable ().LookupRoute (dst, rt), true, "alternative route kept");
+    NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), second, "alternative table follows the failover");
+
+    // a neighbor route goes with the main route to the neighbor
+    GetRoutingTable ().LookupRoute (broken, rt);
+    GetNeighborRoutes ().GetRoute (broken, m_device, m_iface.GetLocal ());
+    NS_TEST_EXPECT_MSG_EQ (GetNeighborRoutes ().GetSize (), 1, "neighbor route handed out");
+    rt.SetSeqNo (rt.GetSeqNo () + 1);
+    GetRoutingTable ().Update (rt);
+    NS_TEST_EXPECT_MSG_EQ (GetNeighborRoutes ().GetSize (), 0, "dropped with an infinite metric");
+    GetNeighborRoutes ().GetRoute (broken, m_device, m_iface.GetLocal ());
+    GetRoutingTable ().DeleteRoute (broken);
+    NS_TEST_EXPECT_MSG_EQ (GetNeighborRoutes ().GetSize (), 0, "dropped with the route");
+  }
+};
+
+class EffDsdvProtocolTestSuite : public TestSuite
+{
+public:
+  EffDsdvProtocolTestSuite ();
+};
+
+EffDsdvProtocolTestSuite::EffDsdvProtocolTestSuite ()
+  : TestSuite ("eff-dsdv-protocol", UNIT)
+{
+	  AddTestCase (new EffDsdvQueueDrainTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvIncrementalDumpTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvUpdateSpreadTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvRequestBatchTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvFailoverTestCase (), TestCase::QUICK);
+}
+
+static EffDsdvProtocolTestSuite effDsdvProtocolTestSuite;
@@ -21,6 +21,7 @@
 */
 
 
+#include <algorithm>
 #include "ns3/eff-dsdv-routing-protocol.h"
 #include "ns3/test.h"
 #include "ns3/mesh-helper.h"
@@ -36,6 +37,13 @@
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/eff-dsdv-packet.h"
 #include "ns3/eff-dsdv-rtable.h"
+#include "ns3/eff-dsdv-packet-queue.h"
+#include "ns3/eff-dsdv-neighbor-table.h"
+#include "ns3/eff-dsdv-settling-scheduler.h"
+#include "ns3/eff-dsdv-trigger-damper.h"
+#include "ns3/eff-dsdv-rreq-cache.h"
+#include "ns3/eff-dsdv-alt-routes.h"
+#include "ns3/eff-dsdv-forwarding-table.h"
 
 
 using namespace ns3;
@@ -119,6 +127,176 @@ EffDsdvHeaderTestCase::DoRun ()
   }
 }
 
+struct BulkDsdvHeaderTest : public TestCase
+{
+  BulkDsdvHeaderTest () : TestCase ("Eff-DSDV bulk update header")
+  {
+  }
+  virtual void DoRun ()
+  {
+    BulkDsdvHeader h;
+    h.AddEntry (DsdvHeader (Ipv4Address ("10.1.1.2"), 2, 2));
+    h.AddEntry (DsdvHeader (Ipv4Address ("10.1.1.3"), 300, 5));
+    h.AddEntry (DsdvHeader (Ipv4Address ("10.1.1.4"), 1, 4));
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (h);
+    p->AddHeader (TypeHeader (DSDVTYPE_BULK));
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 2 + 2 + 3 * 9, "one type header and 9 bytes per entry");
+
+    TypeHeader tHeader;
+    p->RemoveHeader (tHeader);
+    NS_TEST_EXPECT_MSG_EQ (tHeader.IsValid (), true, "bulk type is valid");
+    NS_TEST_EXPECT_MSG_EQ (tHeader.Get (), DSDVTYPE_BULK, "bulk type");
+    BulkDsdvHeader h2;
+    uint32_t bytes = p->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (bytes, 2 + 3 * 9, "bulk header size");
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 0, "whole packet consumed");
+    NS_TEST_ASSERT_MSG_EQ (h2.GetEntryCount (), 3, "entry count");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetEntries ()[0].GetDst (), Ipv4Address ("10.1.1.2"), "entries keep their order");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetEntries ()[0].GetHopCount (), 2, "hop count");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetEntries ()[0].GetDstSeqno (), 2, "sequence number");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetEntries ()[1].GetHopCount (), 255, "hop count saturates at one byte");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetEntries ()[2].GetDst (), Ipv4Address ("10.1.1.4"), "last entry");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetEntries ()[2].GetDstSeqno (), 4, "last sequence number");
+  }
+};
+
+struct BulkRequestHeaderTest : public TestCase
+{
+  BulkRequestHeaderTest () : TestCase ("Eff-DSDV multi-destination RREQ and multi-entry RACK")
+  {
+  }
+  virtual void DoRun ()
+  {
+    BulkRreqHeader rreq (77);
+    rreq.AddDst (Ipv4Address ("10.1.1.2"));
+    rreq.AddDst (Ipv4Address ("10.1.1.3"));
+    BulkRackHeader rack;
+    rack.AddEntry (RackHeader (Ipv4Address ("10.1.1.4"), 2, MilliSeconds (250)));
+    rack.AddEntry (RackHeader (Ipv4Address ("10.1.1.5"), 7, MilliSeconds (9000)));
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (rack);
+    p->AddHeader (TypeHeader (DSDVTYPE_BULK_RACK));
+    p->AddHeader (rreq);
+    p->AddHeader (TypeHeader (DSDVTYPE_BULK_RREQ));
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 2 + 4 + 2 * 4 + 2 + 2 + 2 * 10, "4 bytes per destination, 10 per ack");
+
+    ControlPacketParser parser;
+    NS_TEST_EXPECT_MSG_EQ (p->PeekHeader (parser), p->GetSize (), "whole packet decoded");
+    std::vector<ControlPacketParser::Message> const & m = parser.GetMessages ();
+    NS_TEST_ASSERT_MSG_EQ (m.size (), 4, "one message per destination and ack");
+    NS_TEST_EXPECT_MSG_EQ (m[1].type, DSDVTYPE_RREQ, "bulk destinations are requests");
+    NS_TEST_EXPECT_MSG_EQ (m[1].dst, Ipv4Address ("10.1.1.3"), "second destination");
+    NS_TEST_EXPECT_MSG_EQ (ControlPacketParser::GetRreqHeader (m[1]).GetRequestId (), 77, "destinations share the request ID");
+    NS_TEST_EXPECT_MSG_EQ (m[3].type, DSDVTYPE_RACK, "bulk entries are acks");
+    NS_TEST_EXPECT_MSG_EQ (m[3].hopCount, 7, "per-entry hop count");
+    NS_TEST_EXPECT_MSG_EQ (ControlPacketParser::GetRackHeader (m[3]).GetUpdateTime (), MilliSeconds (9000), "per-entry update time");
+
+    TypeHeader tHeader;
+    p->RemoveHeader (tHeader);
+    NS_TEST_EXPECT_MSG_EQ (tHeader.IsValid (), true, "bulk request type is valid");
+    BulkRreqHeader rreq2;
+    NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (rreq2), 4 + 2 * 4, "bulk request size");
+    NS_TEST_EXPECT_MSG_EQ (rreq2.GetRequestId (), 77, "request ID");
+    NS_TEST_EXPECT_MSG_EQ (rreq2.GetEntryCount (), 2, "destination count");
+    p->RemoveHeader (tHeader);
+    NS_TEST_EXPECT_MSG_EQ (tHeader.Get (), DSDVTYPE_BULK_RACK, "bulk ack type");
+    BulkRackHeader rack2;
+    NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (rack2), 2 + 2 * 10, "bulk ack size");
+    NS_TEST_ASSERT_MSG_EQ (rack2.GetEntryCount (), 2, "ack count");
+    NS_TEST_EXPECT_MSG_EQ (rack2.GetEntries ()[0].GetDst (), Ipv4Address ("10.1.1.4"), "acks keep their order");
+    NS_TEST_EXPECT_MSG_EQ (rack2.GetEntries ()[0].GetUpdateTime (), MilliSeconds (250), "update time");
+  }
+};
+
+struct DsdvBatchHeaderTest : public TestCase
+{
+  DsdvBatchHeaderTest () : TestCase ("Eff-DSDV batch update header")
+  {
+  }
+  virtual void DoRun ()
+  {
+    Ptr<Packet> single = Create<Packet> ();
+    DsdvBatchHeader batch;
+    for (uint32_t i = 0; i < 5; ++i)
+      {
+        DsdvHeader h (Ipv4Address (0x0a010101 + i), i + 1, 2 * i);
+        single->AddHeader (h);
+        single->AddHeader (TypeHeader (DSDVTYPE_DSDV));
+        batch.AddEntry (DsdvHeader (Ipv4Address (0x0a010105 - i), 5 - i, 8 - 2 * i));
+      }
+    Ptr<Packet> batched = Create<Packet> ();
+    batched->AddHeader (batch);
+    NS_TEST_ASSERT_MSG_EQ (batched->GetSize (), single->GetSize (), "same size as one header pair per route");
+    std::vector<uint8_t> singleBytes (single->GetSize ()), batchedBytes (batched->GetSize ());
+    single->CopyData (&singleBytes[0], singleBytes.size ());
+    batched->CopyData (&batchedBytes[0], batchedBytes.size ());
+    NS_TEST_EXPECT_MSG_EQ ((singleBytes == batchedBytes), true, "same bytes as one header pair per route");
+
+    DsdvBatchHeader h2;
+    NS_TEST_EXPECT_MSG_EQ (batched->RemoveHeader (h2), 60, "batch header size");
+    NS_TEST_ASSERT_MSG_EQ (h2.GetEntryCount (), 5, "entry count");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetEntries ()[0].GetDst (), Ipv4Address (0x0a010105), "first entry");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetEntries ()[4].GetDstSeqno (), 0, "last entry");
+  }
+};
+
+struct ControlPacketParserTest : public TestCase
+{
+  ControlPacketParserTest () : TestCase ("Eff-DSDV control packet parser")
+  {
+  }
+  virtual void DoRun ()
+  {
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (RackHeader (Ipv4Address ("10.1.1.5"), 3, MilliSeconds (1500)));
+    p->AddHeader (TypeHeader (DSDVTYPE_RACK));
+    p->AddHeader (RreqHeader (Ipv4Address ("10.1.1.4"), 517));
+    p->AddHeader (TypeHeader (DSDVTYPE_RREQ));
+    BulkDsdvHeader bulk;
+    bulk.AddEntry (DsdvHeader (Ipv4Address ("10.1.1.2"), 2, 6));
+    bulk.AddEntry (DsdvHeader (Ipv4Address ("10.1.1.3"), 3, 8));
+    p->AddHeader (bulk);
+    p->AddHeader (TypeHeader (DSDVTYPE_BULK));
+    p->AddHeader (DsdvHeader (Ipv4Address ("10.1.1.1"), 1, 4));
+    p->AddHeader (TypeHeader (DSDVTYPE_DSDV));
+
+    ControlPacketParser parser;
+    NS_TEST_EXPECT_MSG_EQ (p->PeekHeader (parser), p->GetSize (), "whole packet decoded");
+    NS_TEST_EXPECT_MSG_EQ (parser.IsComplete (), true, "complete");
+    std::vector<ControlPacketParser::Message> const & m = parser.GetMessages ();
+    NS_TEST_ASSERT_MSG_EQ (m.size (), 5, "one message per route, request and ack");
+    NS_TEST_EXPECT_MSG_EQ (m[0].type, DSDVTYPE_DSDV, "update");
+    NS_TEST_EXPECT_MSG_EQ (m[0].dst, Ipv4Address ("10.1.1.1"), "update destination");
+    NS_TEST_EXPECT_MSG_EQ (m[0].value, 4, "update sequence number");
+    NS_TEST_EXPECT_MSG_EQ (m[1].type, DSDVTYPE_DSDV, "bulk entries are updates");
+    NS_TEST_EXPECT_MSG_EQ (m[2].dst, Ipv4Address ("10.1.1.3"), "second bulk entry");
+    NS_TEST_EXPECT_MSG_EQ (m[2].hopCount, 3, "bulk hop count");
+    NS_TEST_EXPECT_MSG_EQ (m[3].type, DSDVTYPE_RREQ, "request");
+    NS_TEST_EXPECT_MSG_EQ (m[3].dst, Ipv4Address ("10.1.1.4"), "request destination");
+    NS_TEST_EXPECT_MSG_EQ (ControlPacketParser::GetRreqHeader (m[3]).GetRequestId (), 517, "request ID");
+    NS_TEST_EXPECT_MSG_EQ (m[4].type, DSDVTYPE_RACK, "ack");
+    NS_TEST_EXPECT_MSG_EQ (ControlPacketParser::GetRackHeader (m[4]).GetUpdateTime (), MilliSeconds (1500), "ack update time");
+
+    // an update header followed by fewer bytes than an update needs
+    Ptr<Packet> truncated = Create<Packet> ();
+    truncated->AddHeader (RreqHeader (Ipv4Address ("10.1.1.4")));
+    truncated->AddHeader (TypeHeader (DSDVTYPE_DSDV));
+    truncated->AddHeader (RreqHeader (Ipv4Address ("10.1.1.4")));
+    truncated->AddHeader (TypeHeader (DSDVTYPE_RREQ));
+    NS_TEST_EXPECT_MSG_EQ (truncated->PeekHeader (parser), 8, "decoding stops before the truncated update");
+    NS_TEST_EXPECT_MSG_EQ (parser.IsComplete (), false, "truncated");
+    NS_TEST_EXPECT_MSG_EQ (parser.GetMessages ().size (), 1, "request before it is kept");
+
+    Ptr<Packet> unknown = Create<Packet> ();
+    unknown->AddHeader (RreqHeader (Ipv4Address ("10.1.1.4")));
+    unknown->AddHeader (TypeHeader (MessageType (9)));
+    NS_TEST_EXPECT_MSG_EQ (unknown->PeekHeader (parser), 0, "unknown type");
+    NS_TEST_EXPECT_MSG_EQ (parser.IsComplete (), false, "unknown type stops decoding");
+    NS_TEST_EXPECT_MSG_EQ (parser.GetMessages ().size (), 0, "nothing decoded");
+  }
+};
+
 struct RreqHeaderTest : public TestCase
 {
   RreqHeaderTest () : TestCase ("Eff-DSDV Rreq")
@@ -126,12 +304,13 @@ struct RreqHeaderTest : public TestCase
   }
   virtual void DoRun ()
   {
-    effdsdv::RreqHeader h (/*dst*/ Ipv4Address ("1.2.3.4"),/*reserved*/0);
+    effdsdv::RreqHeader h (/*dst*/ Ipv4Address ("1.2.3.4"),/*requestId*/ 4242);
     Ptr<Packet> p = Create<Packet> ();
         p->AddHeader (h);
         RreqHeader h2;
         uint32_t bytes = p->RemoveHeader (h2);
         NS_TEST_EXPECT_MSG_EQ (bytes, 6, "RREP is 6 bytes long");
+        NS_TEST_EXPECT_MSG_EQ (h2.GetRequestId (), 4242, "request ID survives serialization");
      //   NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
   }
 };
@@ -211,6 +390,12 @@ struct EffDsdvTableTestCase : public TestCase{
 		        NS_TEST_ASSERT_MSG_EQ (rEntry.GetDestination (),Ipv4Address ("10.1.1.4"),"100");
 		        NS_TEST_ASSERT_MSG_EQ (rEntry.GetSeqNo (),2,"101");
 		        NS_TEST_ASSERT_MSG_EQ (rEntry.GetHop (),2,"102");
+		        Ptr<Ipv4Route> route = rEntry.GetRoute ();
+		        NS_TEST_ASSERT_MSG_EQ (route->GetDestination (),Ipv4Address ("10.1.1.4"),"route destination");
+		        NS_TEST_ASSERT_MSG_EQ (route->GetGateway (),Ipv4Address ("10.1.1.2"),"route gateway");
+		        NS_TEST_ASSERT_MSG_EQ (route->GetSource (),Ipv4Address ("10.1.1.1"),"route source");
+		        route->SetGateway (Ipv4Address ("10.1.1.3"));
+		        NS_TEST_ASSERT_MSG_EQ (rEntry.GetNextHop (),Ipv4Address ("10.1.1.2"),"route is not shared with the entry");
 		      }
 		    if (rtable.LookupRoute (Ipv4Address ("10.1.1.2"), rEntry))
 		      {
@@ -238,6 +423,933 @@ struct EffDsdvTableTestCase : public TestCase{
 	}
 };
 
+struct EffDsdvNextHopIndexTestCase : public TestCase
+{
+  EffDsdvNextHopIndexTestCase () : TestCase ("Eff-DSDV next hop index")
+  {
+  }
+  /// \returns the number of destinations routed over nextHop
+  static uint32_t
+  Count (effdsdv::RoutingTable const & rtable, Ipv4Address nextHop)
+  {
+    effdsdv::RoutingTable::DestinationRange range = rtable.GetDestinationsWithNextHop (nextHop);
+    return range.second - range.first;
+  }
+  virtual void DoRun ()
+  {
+    effdsdv::RoutingTable rtable;
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0"));
+    Ipv4Address relay ("10.1.1.2");
+    Ipv4Address other ("10.1.1.3");
+    for (uint32_t i = 0; i < 10; ++i)
+      {
+        effdsdv::RoutingTableEntry rt (/*device=*/ dev, /*dst=*/ Ipv4Address (0x0a010110 + i), /*seqno=*/ 2,
+                                       /*iface=*/ iface, /*hops=*/ 2, /*next hop=*/ relay,
+                                       /*lifetime=*/ Simulator::Now ());
+        rtable.AddRoute (rt);
+      }
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, relay), 10, "all routes use the relay");
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, other), 0, "no route uses the other neighbor");
+
+    effdsdv::RoutingTableEntry rt;
+    rtable.LookupRoute (Ipv4Address (0x0a010110), rt);
+    rt.SetNextHop (other);
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, other), 0, "changing a copy does not touch the table");
+    rtable.Update (rt);
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, relay), 9, "update moves the route away from the relay");
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, other), 1, "update moves the route to the other neighbor");
+
+    rtable.DeleteRoute (Ipv4Address (0x0a010111));
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, relay), 8, "delete removes the route from the index");
+    std::map<Ipv4Address, effdsdv::RoutingTableEntry> viaRelay;
+    rtable.GetListOfDestinationWithNextHop (relay, viaRelay);
+    NS_TEST_EXPECT_MSG_EQ (viaRelay.size (), 8, "copying lookup agrees with the index");
+    NS_TEST_EXPECT_MSG_EQ ((viaRelay.find (Ipv4Address (0x0a010111)) == viaRelay.end ()), true, "deleted route is gone");
+
+    rtable.DeleteAllRoutesFromInterface (iface);
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, relay), 0, "interface removal empties the index");
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, other), 0, "interface removal empties the index");
+    Simulator::Destroy ();
+  }
+};
+
+struct EffDsdvPurgeTestCase : public TestCase
+{
+  EffDsdvPurgeTestCase () : TestCase ("Eff-DSDV routing table purge"),
+                            m_neighbor ("10.1.1.2"),
+                            m_otherNeighbor ("10.1.1.3"),
+                            m_remote ("10.1.2.1")
+  {
+  }
+  /// Add a route with the last update at the current time
+  void
+  Add (Ipv4Address dst, uint32_t hops, Ipv4Address nextHop)
+  {
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0"));
+    effdsdv::RoutingTableEntry rt (/*device=*/ dev, /*dst=*/ dst, /*seqno=*/ 2,
+                                   /*iface=*/ iface, /*hops=*/ hops, /*next hop=*/ nextHop,
+                                   /*lifetime=*/ Simulator::Now ());
+    m_rtable.AddRoute (rt);
+  }
+  /// Mark a route as updated now
+  void
+  Refresh (Ipv4Address dst)
+  {
+    effdsdv::RoutingTableEntry rt;
+    m_rtable.LookupRoute (dst, rt);
+    rt.SetLifeTime (Simulator::Now ());
+    m_rtable.Update (rt);
+  }
+  /// Purge the table and check the number of removed and invalidated routes
+  void
+  Purge (uint32_t removed, uint32_t invalidated)
+  {
+    std::map<Ipv4Address, effdsdv::RoutingTableEntry> removedAddresses, invalidatedAddresses;
+    m_rtable.Purge (removedAddresses, invalidatedAddresses);
+    NS_TEST_EXPECT_MSG_EQ (removedAddresses.size (), removed, "removed routes at " << Simulator::Now ().GetSeconds ());
+    NS_TEST_EXPECT_MSG_EQ (invalidatedAddresses.size (), invalidated, "invalidated routes at " << Simulator::Now ().GetSeconds ());
+    if (removed)
+      {
+        NS_TEST_EXPECT_MSG_EQ ((removedAddresses.find (m_remote) != removedAddresses.end ()), true, "dependent route removed");
+      }
+  }
+  virtual void DoRun ()
+  {
+    // invalidation after 9 / 3 + 1 = 4 s, removal after 9 s
+    m_rtable.Setholddowntime (Seconds (9));
+    Add (m_neighbor, 1, m_neighbor);
+    Add (m_otherNeighbor, 1, m_otherNeighbor);
+    Add (m_remote, 2, m_neighbor);
+    Simulator::Schedule (Seconds (3), &EffDsdvPurgeTestCase::Refresh, this, m_otherNeighbor);
+    Simulator::Schedule (Seconds (3), &EffDsdvPurgeTestCase::Refresh, this, m_remote);
+    Simulator::Schedule (Seconds (2), &EffDsdvPurgeTestCase::Purge, this, 0, 0);
+    Simulator::Schedule (Seconds (5), &EffDsdvPurgeTestCase::Purge, this, 0, 1);
+    // invalidated neighbors are reported by every purge
+    Simulator::Schedule (Seconds (6), &EffDsdvPurgeTestCase::Purge, this, 0, 1);
+    Simulator::Schedule (Seconds (10), &EffDsdvPurgeTestCase::Purge, this, 2, 1);
+    Simulator::Run ();
+    NS_TEST_EXPECT_MSG_EQ (m_rtable.RoutingTableSize (), 1, "only the refreshed neighbor is left");
+    Simulator::Destroy ();
+  }
+  effdsdv::RoutingTable m_rtable; ///< the table under test
+  Ipv4Address m_neighbor;         ///< neighbor that stops sending updates
+  Ipv4Address m_otherNeighbor;    ///< neighbor refreshed once
+  Ipv4Address m_remote;           ///< two hop destination behind m_neighbor
+};
+
+struct EffDsdvRouteIteratorTestCase : public TestCase
+{
+  EffDsdvRouteIteratorTestCase () : TestCase ("Eff-DSDV routing table iteration")
+  {
+  }
+  /// \returns the number of routes visited with the given filter
+  static uint32_t
+  Count (effdsdv::RoutingTable const & rtable, effdsdv::RoutingTable::RouteFilter filter)
+  {
+    uint32_t n = 0;
+    for (effdsdv::RoutingTable::RouteIterator i = rtable.Begin (filter); i != rtable.End (); ++i)
+      {
+        NS_ASSERT (i->GetDestination () != Ipv4Address::GetLoopback ());
+        ++n;
+      }
+    return n;
+  }
+  virtual void DoRun ()
+  {
+    effdsdv::RoutingTable rtable;
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0"));
+    NS_TEST_EXPECT_MSG_EQ ((rtable.Begin (effdsdv::RoutingTable::ALL_ROUTES) == rtable.End ()), true, "empty table");
+    effdsdv::RoutingTableEntry lo (/*device=*/ dev, /*dst=*/ Ipv4Address::GetLoopback (), /*seqno=*/ 0,
+                                   /*iface=*/ iface, /*hops=*/ 0, /*next hop=*/ Ipv4Address::GetLoopback (),
+                                   /*lifetime=*/ Simulator::Now ());
+    rtable.AddRoute (lo);
+    NS_TEST_EXPECT_MSG_EQ ((rtable.Begin (effdsdv::RoutingTable::ALL_ROUTES) == rtable.End ()), true, "loopback is skipped");
+    for (uint32_t i = 0; i < 20; ++i)
+      {
+        effdsdv::RoutingTableEntry rt (/*device=*/ dev, /*dst=*/ Ipv4Address (0x0a010110 + i), /*seqno=*/ 2,
+                                       /*iface=*/ iface, /*hops=*/ 2, /*next hop=*/ Ipv4Address ("10.1.1.2"),
+                                       /*lifetime=*/ Simulator::Now ());
+        rt.SetFlag (i % 4 ? effdsdv::VALID : effdsdv::INVALID);
+        rtable.AddRoute (rt);
+      }
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, effdsdv::RoutingTable::ALL_ROUTES), 20, "all routes but loopback");
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, effdsdv::RoutingTable::VALID_ROUTES), 15, "valid routes");
+
+    // delete every visited route with an odd address while iterating
+    uint32_t visited = 0;
+    for (effdsdv::RoutingTable::RouteIterator i = rtable.Begin (effdsdv::RoutingTable::ALL_ROUTES); i != rtable.End (); ++i)
+      {
+        ++visited;
+        if (i->GetDestination ().Get () % 2)
+          {
+            rtable.DeleteRoute (i->GetDestination ());
+          }
+      }
+    NS_TEST_EXPECT_MSG_EQ (visited, 20, "deleting does not disturb the iteration");
+    NS_TEST_EXPECT_MSG_EQ (Count (rtable, effdsdv::RoutingTable::ALL_ROUTES), 10, "odd routes deleted");
+    std::map<Ipv4Address, effdsdv::RoutingTableEntry> allRoutes;
+    rtable.GetListOfAllRoutes (allRoutes);
+    NS_TEST_EXPECT_MSG_EQ (allRoutes.size (), 10, "copying list agrees with the iterator");
+    Simulator::Destroy ();
+  }
+};
+
+struct EffDsdvChangedRoutesTestCase : public TestCase
+{
+  EffDsdvChangedRoutesTestCase () : TestCase ("Eff-DSDV tracking of changed routes")
+  {
+  }
+  virtual void DoRun ()
+  {
+    effdsdv::RoutingTable rtable;
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0"));
+    for (uint32_t i = 0; i < 10; ++i)
+      {
+        effdsdv::RoutingTableEntry rt (/*device=*/ dev, /*dst=*/ Ipv4Address (0x0a010110 + i), /*seqno=*/ 2,
+                                       /*iface=*/ iface, /*hops=*/ 2, /*next hop=*/ Ipv4Address ("10.1.1.2"),
+                                       /*lifetime=*/ Simulator::Now (), /*settling time=*/ Seconds (5),
+                                       /*entries changed=*/ i < 3);
+        rtable.AddRoute (rt);
+      }
+    NS_TEST_EXPECT_MSG_EQ (rtable.GetChangedCount (), 3, "changed routes added");
+
+    effdsdv::RoutingTableEntry rt;
+    rtable.LookupRoute (Ipv4Address (0x0a010110), rt);
+    rt.SetEntriesChanged (false);
+    rtable.Update (rt);
+    rtable.LookupRoute (Ipv4Address (0x0a010119), rt);
+    rt.SetEntriesChanged (true);
+    rtable.Update (rt);
+    rtable.DeleteRoute (Ipv4Address (0x0a010111));
+
+    std::vector<Ipv4Address> changed;
+    rtable.GetChangedDestinations (changed);
+    std::sort (changed.begin (), changed.end ());
+    NS_TEST_ASSERT_MSG_EQ (changed.size (), 2, "one change cleared, one added, one deleted");
+    NS_TEST_EXPECT_MSG_EQ (changed[0], Ipv4Address (0x0a010112), "unchanged route still changed");
+    NS_TEST_EXPECT_MSG_EQ (changed[1], Ipv4Address (0x0a010119), "updated route changed");
+    rtable.Clear ();
+    NS_TEST_EXPECT_MSG_EQ (rtable.GetChangedCount (), 0, "nothing changed in an empty table");
+    Simulator::Destroy ();
+  }
+};
+
+struct EffDsdvRouteInstalledTestCase : public TestCase
+{
+  EffDsdvRouteInstalledTestCase () : TestCase ("Eff-DSDV notification of usable routes")
+  {
+  }
+  /// records a notification
+  void Installed (Ipv4Address dst)
+  {
+    m_installed.push_back (dst);
+  }
+  virtual void DoRun ()
+  {
+    effdsdv::RoutingTable rtable;
+    rtable.SetRouteInstalledCallback (MakeCallback (&EffDsdvRouteInstalledTestCase::Installed, this));
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0"));
+    Ipv4Address a ("10.1.1.2"), b ("10.1.1.3");
+    effdsdv::RoutingTableEntry rt (/*device=*/ dev, /*dst=*/ a, /*seqno=*/ 2,
+                                   /*iface=*/ iface, /*hops=*/ 1, /*next hop=*/ a,
+                                   /*lifetime=*/ Simulator::Now ());
+    rt.SetFlag (effdsdv::VALID);
+    rtable.AddRoute (rt);
+    rt = effdsdv::RoutingTableEntry (/*device=*/ dev, /*dst=*/ b, /*seqno=*/ 2,
+                                     /*iface=*/ iface, /*hops=*/ 2, /*next hop=*/ a,
+                                     /*lifetime=*/ Simulator::Now ());
+    rt.SetFlag (effdsdv::INVALID);
+    rtable.AddRoute (rt);
+    NS_TEST_ASSERT_MSG_EQ (m_installed.size (), 1, "valid route added");
+    NS_TEST_EXPECT_MSG_EQ (m_installed[0], a, "route to a added");
+
+    rt.SetSeqNo (4);
+    rtable.Update (rt);
+    NS_TEST_EXPECT_MSG_EQ (m_installed.size (), 1, "invalid route updated");
+    rt.SetFlag (effdsdv::VALID);
+    rtable.Update (rt);
+    NS_TEST_ASSERT_MSG_EQ (m_installed.size (), 2, "route revalidated");
+    NS_TEST_EXPECT_MSG_EQ (m_installed[1], b, "route to b revalidated");
+    rt.SetSeqNo (6);
+    rtable.Update (rt);
+    NS_TEST_EXPECT_MSG_EQ (m_installed.size (), 2, "valid route updated without refresh");
+    rt.SetLifeTime (Seconds (1));
+    rtable.Update (rt);
+    NS_TEST_EXPECT_MSG_EQ (m_installed.size (), 3, "valid route refreshed");
+    Simulator::Destroy ();
+  }
+  std::vector<Ipv4Address> m_installed; ///< notified destinations
+};
+
+struct EffDsdvNeighborTableTestCase : public TestCase
+{
+  EffDsdvNeighborTableTestCase () : TestCase ("Eff-DSDV neighbor route sharing")
+  {
+  }
+  virtual void DoRun ()
+  {
+    effdsdv::NeighborTable neighbors;
+    Ptr<NetDevice> dev;
+    Ipv4Address local ("10.1.1.1");
+    Ipv4Address neighbor ("10.1.1.2");
+    Ptr<Ipv4Route> route = neighbors.GetRoute (neighbor, dev, local);
+    NS_TEST_EXPECT_MSG_EQ (route->GetDestination (), neighbor, "route destination");
+    NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), neighbor, "route gateway");
+    NS_TEST_EXPECT_MSG_EQ (route->GetSource (), local, "route source");
+    NS_TEST_EXPECT_MSG_EQ ((neighbors.GetRoute (neighbor, dev, local) == route), true, "route is shared");
+    NS_TEST_EXPECT_MSG_EQ ((neighbors.GetRoute (Ipv4Address ("10.1.1.3"), dev, local) != route), true, "one route per neighbor");
+    NS_TEST_EXPECT_MSG_EQ (neighbors.GetSize (), 2, "two neighbors");
+
+    Ptr<Ipv4Route> renumbered = neighbors.GetRoute (neighbor, dev, Ipv4Address ("10.1.1.4"));
+    NS_TEST_EXPECT_MSG_EQ ((renumbered != route), true, "handed out routes are not modified");
+    NS_TEST_EXPECT_MSG_EQ (route->GetSource (), local, "old route keeps its source");
+    NS_TEST_EXPECT_MSG_EQ (neighbors.GetSize (), 2, "new source replaces the route");
+
+    neighbors.Remove (neighbor);
+    NS_TEST_EXPECT_MSG_EQ (neighbors.GetSize (), 1, "neighbor removed");
+    neighbors.Clear ();
+    NS_TEST_EXPECT_MSG_EQ (neighbors.GetSize (), 0, "all neighbors removed");
+  }
+};
+
+struct EffDsdvSettlingSchedulerTestCase : public TestCase
+{
+  EffDsdvSettlingSchedulerTestCase () : TestCase ("Eff-DSDV settling scheduler batches due advertisements")
+  {
+  }
+  /// records one batch
+  void Settled ()
+  {
+    m_batches.push_back (Simulator::Now ());
+    m_pending.push_back (m_scheduler.GetSize ());
+  }
+  /// reschedules a destination
+  void Reschedule (Ipv4Address dst, Time delay)
+  {
+    m_scheduler.Schedule (dst, delay);
+  }
+  virtual void DoRun ()
+  {
+    Ipv4Address a ("10.1.1.1"), b ("10.1.1.2"), c ("10.1.1.3"), d ("10.1.1.4"), e ("10.1.1.5");
+    m_scheduler.SetCallback (MakeCallback (&EffDsdvSettlingSchedulerTestCase::Settled, this));
+    m_scheduler.Schedule (a, Seconds (1));
+    m_scheduler.Schedule (b, Seconds (1));
+    m_scheduler.Schedule (c, Seconds (2));
+    m_scheduler.Schedule (d, Seconds (3));
+    m_scheduler.Schedule (e, Seconds (4));
+    NS_TEST_EXPECT_MSG_EQ (m_scheduler.IsPending (d), true, "d is held back");
+    NS_TEST_EXPECT_MSG_EQ (m_scheduler.Cancel (d), true, "d was held back");
+    NS_TEST_EXPECT_MSG_EQ (m_scheduler.IsPending (d), false, "d is released");
+    NS_TEST_EXPECT_MSG_EQ (m_scheduler.Cancel (d), false, "d is no longer held back");
+    NS_TEST_EXPECT_MSG_EQ (m_scheduler.GetDeadline (c), Seconds (2), "deadline of c");
+    Simulator::Schedule (Seconds (0.5), &EffDsdvSettlingSchedulerTestCase::Reschedule, this, e, Seconds (0.5));
+    Simulator::Run ();
+
+    NS_TEST_ASSERT_MSG_EQ (m_batches.size (), 2, "one callback per distinct deadline");
+    NS_TEST_EXPECT_MSG_EQ (m_batches[0], Seconds (1), "a, b and the rescheduled e settle together");
+    NS_TEST_EXPECT_MSG_EQ (m_pending[0], 1, "c is still held back");
+    NS_TEST_EXPECT_MSG_EQ (m_batches[1], Seconds (2), "c settles");
+    NS_TEST_EXPECT_MSG_EQ (m_pending[1], 0, "nothing is held back");
+    Simulator::Destroy ();
+  }
+  SettlingScheduler m_scheduler;   ///< the scheduler under test
+  std::vector<Time> m_batches;     ///< times the callback was invoked
+  std::vector<uint32_t> m_pending; ///< destinations still held back at each callback
+};
+
+struct EffDsdvTriggerDamperTestCase : public TestCase
+{
+  EffDsdvTriggerDamperTestCase () : TestCase ("Eff-DSDV trigger damper paces and merges triggered updates")
+  {
+  }
+  /// records one flushed update
+  void Flushed (Ipv4InterfaceAddress iface, std::vector<DsdvHeader> const & updates)
+  {
+    m_flushes.push_back (Simulator::Now ());
+    m_ifaces.push_back (iface);
+    m_updates.push_back (updates);
+  }
+  /// counts one held back update
+  void Suppressed (TriggerDamper::SuppressReason reason)
+  {
+    m_suppressed.push_back (reason);
+  }
+  /// hands one entry to a damper
+  void Add (Ptr<TriggerDamper> damper, Ipv4Address dst, uint32_t seqNo)
+  {
+    damper->Add (std::vector<DsdvHeader> (1, DsdvHeader (dst, 1, seqNo)));
+  }
+  virtual void DoRun ()
+  {
+    Ipv4Address a ("10.1.1.1"), b ("10.1.1.2");
+    Ipv4InterfaceAddress pacedIface (Ipv4Address ("10.1.2.1"), Ipv4Mask ("255.255.255.0"));
+    Ipv4InterfaceAddress limitedIface (Ipv4Address ("10.1.3.1"), Ipv4Mask ("255.255.255.0"));
+    Ptr<TriggerDamper> paced = Create<TriggerDamper> (pacedIface);
+    paced->SetFlushCallback (MakeCallback (&EffDsdvTriggerDamperTestCase::Flushed, this));
+    paced->SetSuppressCallback (MakeCallback (&EffDsdvTriggerDamperTestCase::Suppressed, this));
+    paced->SetMinInterval (Seconds (1));
+    Add (paced, a, 2);
+    NS_TEST_EXPECT_MSG_EQ (m_flushes.size (), 1, "the first update goes out at once");
+    NS_TEST_EXPECT_MSG_EQ (paced->GetPendingCount (), 0, "nothing is pending");
+    Simulator::Schedule (Seconds (0.5), &EffDsdvTriggerDamperTestCase::Add, this, paced, a, 4);
+    Simulator::Schedule (Seconds (0.6), &EffDsdvTriggerDamperTestCase::Add, this, paced, b, 2);
+    Simulator::Schedule (Seconds (0.7), &EffDsdvTriggerDamperTestCase::Add, this, paced, a, 6);
+
+    Ptr<TriggerDamper> limited = Create<TriggerDamper> (limitedIface);
+    limited->SetFlushCallback (MakeCallback (&EffDsdvTriggerDamperTestCase::Flushed, this));
+    limited->SetSuppressCallback (MakeCallback (&EffDsdvTriggerDamperTestCase::Suppressed, this));
+    limited->SetTokenBucket (100, 100);
+    limited->SetUpdateSize (50, 10);
+    Simulator::Schedule (Seconds (2), &EffDsdvTriggerDamperTestCase::Add, this, limited, a, 8);
+    Simulator::Schedule (Seconds (2), &EffDsdvTriggerDamperTestCase::Add, this, limited, b, 4);
+    Simulator::Run ();
+
+    NS_TEST_ASSERT_MSG_EQ (m_flushes.size (), 4, "one flush per paced update");
+    NS_TEST_EXPECT_MSG_EQ (m_flushes[1], Seconds (1), "held back for the minimum interval");
+    NS_TEST_ASSERT_MSG_EQ (m_updates[1].size (), 2, "entries merged by destination");
+    NS_TEST_EXPECT_MSG_EQ (m_updates[1][0].GetDst (), a, "first merged entry");
+    NS_TEST_EXPECT_MSG_EQ (m_updates[1][0].GetDstSeqno (), 6, "the newest entry for a wins");
+    NS_TEST_EXPECT_MSG_EQ (m_flushes[2], Seconds (2), "the full bucket sends at once");
+    NS_TEST_EXPECT_MSG_EQ (m_flushes[3], Seconds (2.2), "waits for 60 bytes at 100 bytes/s with 40 left");
+    NS_TEST_EXPECT_MSG_EQ (m_ifaces[0], pacedIface, "flushed for the paced interface");
+    NS_TEST_EXPECT_MSG_EQ (m_ifaces[1], pacedIface, "deferred flush for the paced interface");
+    NS_TEST_EXPECT_MSG_EQ (m_ifaces[2], limitedIface, "flushed for the limited interface");
+    NS_TEST_EXPECT_MSG_EQ (m_ifaces[3], limitedIface, "deferred flush for the limited interface");
+    NS_TEST_ASSERT_MSG_EQ (m_suppressed.size (), 4, "held back updates reported");
+    NS_TEST_EXPECT_MSG_EQ (m_suppressed[0], TriggerDamper::MIN_INTERVAL, "too soon after the first flush");
+    NS_TEST_EXPECT_MSG_EQ (m_suppressed[1], TriggerDamper::COALESCED, "merged into the deferred update");
+    NS_TEST_EXPECT_MSG_EQ (m_suppressed[2], TriggerDamper::COALESCED, "merged into the deferred update");
+    NS_TEST_EXPECT_MSG_EQ (m_suppressed[3], TriggerDamper::RATE_LIMIT, "too few tokens");
+    Simulator::Destroy ();
+  }
+  std::vector<Time> m_flushes;                        ///< times an update was flushed
+  std::vector<Ipv4InterfaceAddress> m_ifaces;         ///< interfaces an update was flushed for
+  std::vector<std::vector<DsdvHeader> > m_updates;    ///< the flushed updates
+  std::vector<TriggerDamper::SuppressReason> m_suppressed; ///< reasons of held back updates
+};
+
+struct EffDsdvRreqCacheTestCase : public TestCase
+{
+  EffDsdvRreqCacheTestCase () : TestCase ("Eff-DSDV route request duplicate cache and retry backoff")
+  {
+  }
+  /// records whether a request for dst may be sent now
+  void Request (Ipv4Address dst)
+  {
+    m_allowed.push_back (m_backoff.TryRequest (dst));
+  }
+  /// checks the duplicate cache now
+  void Receive (Ipv4Address origin, uint16_t id)
+  {
+    m_duplicate.push_back (m_cache.IsDuplicate (origin, id));
+  }
+  virtual void DoRun ()
+  {
+    Ipv4Address a ("10.1.1.1"), b ("10.1.1.2");
+    m_cache.SetLifetime (Seconds (3));
+    Receive (a, 1);
+    Receive (a, 1);
+    Receive (b, 1);
+    Receive (a, 2);
+    NS_TEST_EXPECT_MSG_EQ (m_cache.GetSize (), 3, "one entry per origin and ID");
+    Simulator::Schedule (Seconds (4), &EffDsdvRreqCacheTestCase::Receive, this, a, 1);
+
+    m_backoff.SetInterval (Seconds (1), Seconds (4));
+    // requests at 0, 1, 3 and 7 s pass, the ones in between are held back
+    double times[] = { 0, 0.5, 1, 2, 3, 6, 7, 20 };
+    for (uint32_t i = 0; i < sizeof (times) / sizeof (times[0]); ++i)
+      {
+        Simulator::Schedule (Seconds (times[i]), &EffDsdvRreqCacheTestCase::Request, this, b);
+      }
+    Simulator::Run ();
+
+    NS_TEST_ASSERT_MSG_EQ (m_duplicate.size (), 5, "all receptions checked");
+    NS_TEST_EXPECT_MSG_EQ (m_duplicate[0], false, "first reception");
+    NS_TEST_EXPECT_MSG_EQ (m_duplicate[1], true, "same origin and ID");
+    NS_TEST_EXPECT_MSG_EQ (m_duplicate[2], false, "other origin");
+    NS_TEST_EXPECT_MSG_EQ (m_duplicate[3], false, "other ID");
+    NS_TEST_EXPECT_MSG_EQ (m_duplicate[4], false, "expired");
+    m_cache.Purge ();
+    NS_TEST_EXPECT_MSG_EQ (m_cache.GetSize (), 0, "every entry has expired by the last request");
+
+    bool expected[] = { true, false, true, false, true, false, true, true };
+    NS_TEST_ASSERT_MSG_EQ (m_allowed.size (), 8, "all requests checked");
+    for (uint32_t i = 0; i < m_allowed.size (); ++i)
+      {
+        NS_TEST_EXPECT_MSG_EQ (m_allowed[i], expected[i], "request " << i);
+      }
+    NS_TEST_EXPECT_MSG_EQ (m_backoff.GetAttempts (b), 1, "a long pause starts over");
+    m_backoff.Reset (b);
+    NS_TEST_EXPECT_MSG_EQ (m_backoff.GetAttempts (b), 0, "reset once a route is learned");
+    Simulator::Destroy ();
+  }
+  RreqIdCache m_cache;             ///< the cache under test
+  RreqBackoff m_backoff;           ///< the backoff under test
+  std::vector<bool> m_duplicate;   ///< results of the duplicate checks
+  std::vector<bool> m_allowed;     ///< results of the request checks
+};
+
+struct EffDsdvAlternativeRoutesTestCase : public TestCase
+{
+  EffDsdvAlternativeRoutesTestCase () : TestCase ("Eff-DSDV ranked alternative routes")
+  {
+  }
+  /// \returns a route to dst via nextHop, acknowledged age ago
+  static effdsdv::RoutingTableEntry
+  Route (Ipv4Address dst, Ipv4Address nextHop, uint32_t hops, Time age)
+  {
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0"));
+    effdsdv::RoutingTableEntry rt (/*device=*/ dev, /*dst=*/ dst, /*seqno=*/ 0,
+                                   /*iface=*/ iface, /*hops=*/ hops, /*next hop=*/ nextHop,
+                                   /*lifetime=*/ Simulator::Now () - age);
+    rt.SetInstallTime (Simulator::Now ());
+    return rt;
+  }
+  virtual void DoRun ()
+  {
+    Ipv4Address dst ("10.1.1.9"), n1 ("10.1.1.2"), n2 ("10.1.1.3"), n3 ("10.1.1.4");
+    AlternativeRoutes routes (2);
+    effdsdv::RoutingTableEntry best;
+    NS_TEST_EXPECT_MSG_EQ (routes.Offer (Route (dst, n1, 3, Seconds (0))), true, "first candidate");
+    NS_TEST_EXPECT_MSG_EQ (routes.Offer (Route (dst, n2, 2, Seconds (3))), true, "fewer hops");
+    NS_TEST_EXPECT_MSG_EQ (routes.Offer (Route (dst, n3, 4, Seconds (0))), false, "ranks below the kept candidates");
+    NS_TEST_ASSERT_MSG_EQ (routes.GetBest (dst, best), true, "destination has candidates");
+    NS_TEST_EXPECT_MSG_EQ (best.GetNextHop (), n2, "fewest hops first");
+
+    NS_TEST_EXPECT_MSG_EQ (routes.Offer (Route (dst, n1, 2, Seconds (1))), true, "same next hop is replaced");
+    NS_TEST_ASSERT_MSG_NE (routes.GetCandidates (dst), 0, "candidates");
+    NS_TEST_EXPECT_MSG_EQ (routes.GetCandidates (dst)->size (), 2, "one candidate per next hop");
+    routes.GetBest (dst, best);
+    NS_TEST_EXPECT_MSG_EQ (best.GetNextHop (), n1, "fresher information wins on equal hops");
+
+    NS_TEST_EXPECT_MSG_EQ (routes.Remove (dst, n1), true, "next hop lost");
+    routes.GetBest (dst, best);
+    NS_TEST_EXPECT_MSG_EQ (best.GetNextHop (), n2, "fail over to the next candidate");
+    NS_TEST_EXPECT_MSG_EQ (routes.Remove (dst, n3), false, "never kept");
+    routes.Remove (dst, n2);
+    NS_TEST_EXPECT_MSG_EQ (routes.GetBest (dst, best), false, "no candidate left");
+    NS_TEST_EXPECT_MSG_EQ (routes.GetSize (), 0, "destination dropped");
+  }
+};
+
+struct EffDsdvForwardingTableTestCase : public TestCase
+{
+  EffDsdvForwardingTableTestCase () : TestCase ("Eff-DSDV forwarding table of ready-made routes")
+  {
+  }
+  /// records a notification
+  void Changed (Ipv4Address dst)
+  {
+    m_changed.push_back (dst);
+  }
+  /// checks the table at the time it is scheduled for
+  void CheckExpiry (Ipv4Address dst, bool present)
+  {
+    NS_TEST_EXPECT_MSG_EQ ((m_fib.Lookup (dst) != 0), present, "entry expires on time");
+  }
+  virtual void DoRun ()
+  {
+    Ipv4Address a ("10.1.1.2"), b ("10.1.1.3");
+    Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+    route->SetDestination (a);
+    route->SetGateway (a);
+
+    NS_TEST_EXPECT_MSG_EQ (m_fib.Lookup (a), 0, "empty table");
+    m_fib.Install (a, route, Seconds (2));
+    m_fib.Install (b, route, Seconds (5));
+    NS_TEST_EXPECT_MSG_EQ (m_fib.Lookup (a), route, "installed route found");
+    NS_TEST_EXPECT_MSG_EQ (m_fib.GetHits (), 1, "one hit");
+    NS_TEST_EXPECT_MSG_EQ (m_fib.GetMisses (), 1, "one miss");
+    Simulator::Schedule (Seconds (1), &EffDsdvForwardingTableTestCase::CheckExpiry, this, a, true);
+    Simulator::Schedule (Seconds (2), &EffDsdvForwardingTableTestCase::CheckExpiry, this, a, false);
+    Simulator::Schedule (Seconds (3), &EffDsdvForwardingTableTestCase::CheckExpiry, this, b, true);
+    Simulator::Run ();
+    Simulator::Destroy ();
+
+    m_fib.Install (a, route, Seconds (10));
+    m_fib.Invalidate (b);
+    NS_TEST_EXPECT_MSG_EQ (m_fib.Lookup (b), 0, "invalidated entry dropped");
+    NS_TEST_EXPECT_MSG_EQ (m_fib.Lookup (a), route, "other entries kept");
+    uint32_t version = m_fib.GetVersion ();
+    m_fib.InvalidateAll ();
+    NS_TEST_EXPECT_MSG_EQ (m_fib.GetVersion (), version + 1, "version bumped");
+    NS_TEST_EXPECT_MSG_EQ (m_fib.Lookup (a), 0, "entries of an older version dropped");
+    m_fib.Install (a, route, Seconds (10));
+    NS_TEST_EXPECT_MSG_EQ (m_fib.Lookup (a), route, "reinstalled under the new version");
+    m_fib.Clear ();
+    NS_TEST_EXPECT_MSG_EQ (m_fib.Lookup (a), 0, "table cleared");
+
+    // the routing table reports every change a cached route may depend on
+    effdsdv::RoutingTable rtable;
+    rtable.SetRouteChangedCallback (MakeCallback (&EffDsdvForwardingTableTestCase::Changed, this));
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0"));
+    effdsdv::RoutingTableEntry rt (/*device=*/ dev, /*dst=*/ a, /*seqno=*/ 2,
+                                   /*iface=*/ iface, /*hops=*/ 1, /*next hop=*/ a,
+                                   /*lifetime=*/ Simulator::Now ());
+    rt.SetFlag (effdsdv::VALID);
+    rtable.AddRoute (rt);
+    NS_TEST_ASSERT_MSG_EQ (m_changed.size (), 1, "route added");
+    rt.SetSeqNo (4);
+    rtable.Update (rt);
+    NS_TEST_ASSERT_MSG_EQ (m_changed.size (), 2, "route updated");
+    rtable.DeleteRoute (a);
+    NS_TEST_ASSERT_MSG_EQ (m_changed.size (), 3, "route deleted");
+    NS_TEST_EXPECT_MSG_EQ (m_changed[2], a, "route to a changed");
+    rtable.AddRoute (rt);
+    rtable.Clear ();
+    NS_TEST_ASSERT_MSG_EQ (m_changed.size (), 5, "cleared route reported");
+    NS_TEST_EXPECT_MSG_EQ (m_changed[4], a, "route to a cleared");
+    Simulator::Destroy ();
+  }
+  effdsdv::ForwardingTable m_fib;  ///< the table under test
+  std::vector<Ipv4Address> m_changed; ///< notified destinations
+};
+
+struct EffDsdvRouteStoreTestCase : public TestCase
+{
+  EffDsdvRouteStoreTestCase () : TestCase ("Eff-DSDV route store shared by the routing tables")
+  {
+  }
+  virtual void DoRun ()
+  {
+    effdsdv::RoutingTable mainTable;
+    effdsdv::RoutingTable advTable (mainTable.GetStore (), effdsdv::RouteStore::ADVERTISED);
+    effdsdv::RoutingTable altTable (mainTable.GetStore (), effdsdv::RouteStore::ALTERNATIVE);
+    Ptr<effdsdv::RouteStore> store = mainTable.GetStore ();
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0"));
+    Ipv4Address dst ("10.1.2.1");
+    for (uint32_t i = 0; i < 10; ++i)
+      {
+        effdsdv::RoutingTableEntry rt (/*device=*/ dev, /*dst=*/ Ipv4Address (0x0a010201 + i), /*seqno=*/ 2,
+                                       /*iface=*/ iface, /*hops=*/ 2, /*next hop=*/ Ipv4Address ("10.1.1.2"),
+                                       /*lifetime=*/ Simulator::Now ());
+        mainTable.AddRoute (rt);
+        advTable.AddRoute (rt);
+      }
+    NS_TEST_EXPECT_MSG_EQ (store->GetPooledRoutes (), 0, "advertised copies of main routes are shared");
+
+    effdsdv::RoutingTableEntry rt;
+    advTable.LookupRoute (dst, rt);
+    rt.SetSeqNo (4);
+    advTable.Update (rt);
+    NS_TEST_EXPECT_MSG_EQ (store->GetPooledRoutes (), 1, "changed advertised route is stored on its own");
+    effdsdv::RoutingTableEntry mainRt;
+    mainTable.LookupRoute (dst, mainRt);
+    NS_TEST_EXPECT_MSG_EQ (mainRt.GetSeqNo (), 2, "main route is not changed");
+    mainTable.Update (rt);
+    NS_TEST_EXPECT_MSG_EQ (store->GetPooledRoutes (), 1, "merged route is shared again and keeps its slot");
+    mainTable.Update (rt);
+    NS_TEST_EXPECT_MSG_EQ (store->GetPooledRoutes (), 1, "unchanged main route is not copied out");
+    rt.SetSeqNo (6);
+    mainTable.Update (rt);
+    NS_TEST_EXPECT_MSG_EQ (store->GetPooledRoutes (), 1, "diverging routes reuse the slot");
+    effdsdv::RoutingTableEntry advRt;
+    advTable.LookupRoute (dst, advRt);
+    NS_TEST_EXPECT_MSG_EQ (advRt.GetSeqNo (), 4, "advertised route is copied out before the main route changes");
+
+    mainTable.DeleteRoute (Ipv4Address ("10.1.2.2"));
+    NS_TEST_EXPECT_MSG_EQ (advTable.LookupRoute (Ipv4Address ("10.1.2.2"), advRt), true, "advertised route outlives the main route");
+    NS_TEST_EXPECT_MSG_EQ (mainTable.RoutingTableSize (), 9, "main table size");
+    NS_TEST_EXPECT_MSG_EQ (advTable.RoutingTableSize (), 10, "advertised table size");
+    NS_TEST_EXPECT_MSG_EQ (mainTable.GetValidCount (), 9, "valid main routes");
+    advTable.LookupRoute (Ipv4Address ("10.1.2.3"), advRt);
+    advRt.SetFlag (effdsdv::INVALID);
+    advTable.Update (advRt);
+    NS_TEST_EXPECT_MSG_EQ (advTable.GetValidCount (), 9, "invalidated route no longer counted");
+    advTable.DeleteRoute (Ipv4Address ("10.1.2.3"));
+    NS_TEST_EXPECT_MSG_EQ (advTable.GetValidCount (), 9, "deleted invalid route not counted twice");
+
+    effdsdv::RoutingTableEntry alternative (/*device=*/ dev, /*dst=*/ dst, /*seqno=*/ 6,
+                                            /*iface=*/ iface, /*hops=*/ 3, /*next hop=*/ Ipv4Address ("10.1.1.3"),
+                                            /*lifetime=*/ Simulator::Now ());
+    altTable.AddRoute (alternative);
+    mainTable.LookupRoute (dst, mainRt);
+    NS_TEST_EXPECT_MSG_EQ (mainRt.GetNextHop (), Ipv4Address ("10.1.1.2"), "tables keep their own route");
+    mainTable.Clear ();
+    advTable.Clear ();
+    NS_TEST_EXPECT_MSG_EQ (altTable.RoutingTableSize (), 1, "clearing a table leaves the others alone");
+    NS_TEST_EXPECT_MSG_EQ (altTable.LookupRoute (dst, rt), true, "alternative route still present");
+    NS_TEST_EXPECT_MSG_EQ (store->GetPooledRoutes (), 1, "only the alternative route is left");
+    Simulator::Destroy ();
+  }
+};
+
+struct EffDsdvPacketQueueTestCase : public TestCase
+{
+  EffDsdvPacketQueueTestCase () : TestCase ("Eff-DSDV packet queue")
+  {
+  }
+  /**
+   * \param p the packet
+   * \param dst the destination
+   * \returns a queue entry for the packet
+   */
+  static effdsdv::QueueEntry
+  MakeEntry (Ptr<const Packet> p, Ipv4Address dst)
+  {
+    Ipv4Header h;
+    h.SetDestination (dst);
+    return effdsdv::QueueEntry (p, h);
+  }
+  virtual void DoRun ()
+  {
+    effdsdv::PacketQueue q;
+    q.SetMaxQueueLen (4);
+    q.SetMaxPacketsPerDst (3);
+    q.SetQueueTimeout (Seconds (10));
+    Ipv4Address a ("10.1.1.1"), b ("10.1.1.2");
+    std::vector<Ptr<Packet> > packets;
+    for (uint32_t i = 0; i < 5; ++i)
+      {
+        packets.push_back (Create<Packet> ());
+      }
+
+    effdsdv::QueueEntry e = MakeEntry (packets[0], a);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), true, "first packet to a");
+    e = MakeEntry (packets[0], a);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), false, "duplicate packet");
+    e = MakeEntry (packets[1], a);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), true, "second packet to a");
+    e = MakeEntry (packets[2], a);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), true, "third packet to a");
+    e = MakeEntry (packets[3], a);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), false, "per destination limit");
+    e = MakeEntry (packets[3], b);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), true, "first packet to b");
+    e = MakeEntry (packets[4], b);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), false, "queue limit");
+    NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 4, "queued packets");
+    NS_TEST_EXPECT_MSG_EQ (q.GetCountForPacketsWithDst (a), 3, "packets to a");
+    NS_TEST_EXPECT_MSG_EQ (q.GetDestinationCount (), 2, "destinations");
+
+    NS_TEST_EXPECT_MSG_EQ (q.Dequeue (a, e), true, "dequeue a");
+    NS_TEST_EXPECT_MSG_EQ (e.GetPacket ()->GetUid (), packets[0]->GetUid (), "oldest packet first");
+    e = MakeEntry (packets[0], a);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), true, "dequeued packet may be queued again");
+    q.DropPacketWithDst (a);
+    NS_TEST_EXPECT_MSG_EQ (q.Find (a), false, "packets to a dropped");
+    NS_TEST_EXPECT_MSG_EQ (q.Find (b), true, "packets to b kept");
+    NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 1, "one packet left");
+
+    Simulator::Stop (Seconds (11));
+    Simulator::Run ();
+    NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 0, "packets expired");
+    NS_TEST_EXPECT_MSG_EQ (q.GetDestinationCount (), 0, "no destinations left");
+    NS_TEST_EXPECT_MSG_EQ (q.GetBytes (), 0, "no bytes left");
+
+    // a 100 byte packet and its IPv4 header
+    q.SetMaxQueueBytes (2 * 120 - 1);
+    e = MakeEntry (Create<Packet> (100), a);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), true, "packet within the byte budget");
+    NS_TEST_EXPECT_MSG_EQ (q.GetBytes (), 120, "bytes of the packet and its header");
+    e = MakeEntry (Create<Packet> (100), b);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), false, "byte budget exhausted");
+    NS_TEST_EXPECT_MSG_EQ (q.Dequeue (a, e), true, "dequeue a");
+    e = MakeEntry (Create<Packet> (100), b);
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), true, "dequeue returns the bytes");
+    Simulator::Destroy ();
+  }
+};
+
+struct EffDsdvQueueDropPolicyTestCase : public TestCase
+{
+  EffDsdvQueueDropPolicyTestCase () : TestCase ("Eff-DSDV packet queue drop policies")
+  {
+  }
+  /**
+   * Fill a queue of 4 packets, at most 3 per destination, with 3 packets to a and 1 to b,
+   * then offer one more packet to a, c and b each
+   * \param policy the drop policy
+   * \param q the queue
+   * \returns the number of offered packets that were accepted
+   */
+  static uint32_t
+  Fill (effdsdv::PacketQueue::DropPolicy policy, effdsdv::PacketQueue & q)
+  {
+    q.SetMaxQueueLen (4);
+    q.SetMaxPacketsPerDst (3);
+    q.SetQueueTimeout (Seconds (10));
+    q.SetDropPolicy (policy);
+    Ipv4Address dsts[] = { Ipv4Address ("10.1.1.1"), Ipv4Address ("10.1.1.1"), Ipv4Address ("10.1.1.1"),
+                           Ipv4Address ("10.1.1.2"), Ipv4Address ("10.1.1.1"), Ipv4Address ("10.1.1.3"),
+                           Ipv4Address ("10.1.1.2") };
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < 7; ++i)
+      {
+        effdsdv::QueueEntry e = EffDsdvPacketQueueTestCase::MakeEntry (Create<Packet> (), dsts[i]);
+        if (q.Enqueue (e) && i >= 4)
+          {
+            ++accepted;
+          }
+      }
+    return accepted;
+  }
+  /// checks the SOJOURN policy one second after the packets to a were queued
+  void CheckSojourn ()
+  {
+    effdsdv::QueueEntry e = EffDsdvPacketQueueTestCase::MakeEntry (Create<Packet> (), Ipv4Address ("10.1.1.3"));
+    NS_TEST_EXPECT_MSG_EQ (m_queue.Enqueue (e), true, "stale packet gives way");
+    NS_TEST_EXPECT_MSG_EQ (m_queue.GetCountForPacketsWithDst (Ipv4Address ("10.1.1.1")), 2, "one stale packet dropped");
+    NS_TEST_EXPECT_MSG_EQ (m_queue.Dequeue (Ipv4Address ("10.1.1.1"), e), false, "stale packets dropped on dequeue");
+    NS_TEST_EXPECT_MSG_EQ (m_queue.GetCountForPacketsWithDst (Ipv4Address ("10.1.1.2")), 1, "fresh packet kept");
+  }
+  /// queues a packet to b
+  void EnqueueFresh ()
+  {
+    effdsdv::QueueEntry e = EffDsdvPacketQueueTestCase::MakeEntry (Create<Packet> (), Ipv4Address ("10.1.1.2"));
+    m_queue.Enqueue (e);
+  }
+  /**
+   * Offer a packet to b to the queue with a stale packet to a
+   * \param accepted whether the packet is expected to be accepted
+   */
+  void CheckDestinationLimit (bool accepted)
+  {
+    effdsdv::QueueEntry e = EffDsdvPacketQueueTestCase::MakeEntry (Create<Packet> (), Ipv4Address ("10.1.1.2"));
+    NS_TEST_EXPECT_MSG_EQ (m_limited.Enqueue (e), accepted, "only a stale packet to b gives way");
+    NS_TEST_EXPECT_MSG_EQ (m_limited.GetCountForPacketsWithDst (Ipv4Address ("10.1.1.1")), 1, "other destinations keep their stale packets");
+    NS_TEST_EXPECT_MSG_EQ (m_limited.GetCountForPacketsWithDst (Ipv4Address ("10.1.1.2")), 3, "packets to b");
+  }
+  /// fills the bucket of b in the queue with a stale packet to a
+  void FillLimited ()
+  {
+    for (uint32_t i = 0; i < 3; ++i)
+      {
+        effdsdv::QueueEntry e = EffDsdvPacketQueueTestCase::MakeEntry (Create<Packet> (), Ipv4Address ("10.1.1.2"));
+        m_limited.Enqueue (e);
+      }
+  }
+  virtual void DoRun ()
+  {
+    Ipv4Address a ("10.1.1.1"), b ("10.1.1.2"), c ("10.1.1.3");
+    effdsdv::PacketQueue tail;
+    NS_TEST_EXPECT_MSG_EQ (Fill (effdsdv::PacketQueue::DROP_TAIL, tail), 0, "drop tail rejects new packets");
+    NS_TEST_EXPECT_MSG_EQ (tail.GetCountForPacketsWithDst (a), 3, "drop tail keeps old packets");
+
+    effdsdv::PacketQueue oldest;
+    NS_TEST_EXPECT_MSG_EQ (Fill (effdsdv::PacketQueue::DROP_OLDEST, oldest), 3, "drop oldest accepts new packets");
+    NS_TEST_EXPECT_MSG_EQ (oldest.GetCountForPacketsWithDst (a), 1, "oldest packets to a dropped");
+    NS_TEST_EXPECT_MSG_EQ (oldest.GetCountForPacketsWithDst (b), 2, "packets to b");
+    NS_TEST_EXPECT_MSG_EQ (oldest.GetCountForPacketsWithDst (c), 1, "packet to c");
+
+    effdsdv::PacketQueue fair;
+    NS_TEST_EXPECT_MSG_EQ (Fill (effdsdv::PacketQueue::FAIR_SHARE, fair), 2, "fair share accepts the new packets to a and c");
+    NS_TEST_EXPECT_MSG_EQ (fair.GetCountForPacketsWithDst (a), 2, "a gave way to c");
+    NS_TEST_EXPECT_MSG_EQ (fair.GetCountForPacketsWithDst (b), 1, "b may not take from a");
+    NS_TEST_EXPECT_MSG_EQ (fair.GetCountForPacketsWithDst (c), 1, "packet to c");
+
+    m_queue.SetSojournTarget (Seconds (1));
+    Fill (effdsdv::PacketQueue::SOJOURN, m_queue);
+    NS_TEST_EXPECT_MSG_EQ (m_queue.GetCountForPacketsWithDst (c), 0, "no stale packets to give way yet");
+    m_queue.DropPacketWithDst (b);
+    Simulator::Schedule (Seconds (1.5), &EffDsdvQueueDropPolicyTestCase::EnqueueFresh, this);
+    Simulator::Schedule (Seconds (2), &EffDsdvQueueDropPolicyTestCase::CheckSojourn, this);
+
+    // a full bucket only makes room by dropping its own stale packets
+    m_limited.SetMaxQueueLen (8);
+    m_limited.SetMaxPacketsPerDst (3);
+    m_limited.SetQueueTimeout (Seconds (10));
+    m_limited.SetDropPolicy (effdsdv::PacketQueue::SOJOURN);
+    m_limited.SetSojournTarget (Seconds (1));
+    effdsdv::QueueEntry e = EffDsdvPacketQueueTestCase::MakeEntry (Create<Packet> (), a);
+    m_limited.Enqueue (e);
+    Simulator::Schedule (Seconds (1.5), &EffDsdvQueueDropPolicyTestCase::FillLimited, this);
+    Simulator::Schedule (Seconds (2), &EffDsdvQueueDropPolicyTestCase::CheckDestinationLimit, this, false);
+    Simulator::Schedule (Seconds (3), &EffDsdvQueueDropPolicyTestCase::CheckDestinationLimit, this, true);
+    Simulator::Run ();
+    Simulator::Destroy ();
+  }
+  effdsdv::PacketQueue m_queue; ///< queue with the SOJOURN policy
+  effdsdv::PacketQueue m_limited; ///< queue with the SOJOURN policy hitting the per destination limit
+};
+
+struct EffDsdvQueueStatsTestCase : public TestCase
+{
+  EffDsdvQueueStatsTestCase () : TestCase ("Eff-DSDV packet queue statistics")
+  {
+  }
+  virtual void DoRun ()
+  {
+    Ipv4Address a ("10.1.1.1"), b ("10.1.1.2");
+    effdsdv::PacketQueue q;
+    EffDsdvQueueDropPolicyTestCase::Fill (effdsdv::PacketQueue::DROP_TAIL, q);
+    effdsdv::QueueEntry e = EffDsdvPacketQueueTestCase::MakeEntry (Create<Packet> (), a);
+    NS_TEST_EXPECT_MSG_EQ (q.Dequeue (a, e), true, "dequeue");
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), true, "requeue");
+    NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e), false, "duplicate");
+    q.DropPacketWithDst (b);
+
+    effdsdv::PacketQueue::Stats const & stats = q.GetStats ();
+    NS_TEST_EXPECT_MSG_EQ (stats.enqueued, 5, "enqueued");
+    NS_TEST_EXPECT_MSG_EQ (stats.dequeued, 1, "dequeued");
+    NS_TEST_EXPECT_MSG_EQ (stats.highWater, 4, "high-water mark");
+    NS_TEST_EXPECT_MSG_EQ (stats.sojourn[0], 1, "sojourn below 1ms");
+    NS_TEST_EXPECT_MSG_EQ (stats.drops[effdsdv::PacketQueue::DROP_DESTINATION_LIMIT], 1, "drops at the destination limit");
+    NS_TEST_EXPECT_MSG_EQ (stats.drops[effdsdv::PacketQueue::DROP_QUEUE_LIMIT], 2, "drops at the queue limit");
+    NS_TEST_EXPECT_MSG_EQ (stats.drops[effdsdv::PacketQueue::DROP_DUPLICATE], 1, "duplicate drops");
+    NS_TEST_EXPECT_MSG_EQ (stats.drops[effdsdv::PacketQueue::DROP_FLUSHED], 1, "flushed packets");
+    NS_TEST_EXPECT_MSG_EQ (stats.drops[effdsdv::PacketQueue::DROP_TIMEOUT], 0, "no timeouts");
+
+    q.ResetStats ();
+    NS_TEST_EXPECT_MSG_EQ (stats.enqueued, 0, "counters reset");
+    NS_TEST_EXPECT_MSG_EQ (stats.highWater, 3, "high-water mark restarts at the occupancy");
+  }
+};
+
+struct EffDsdvAddressMapTestCase : public TestCase
+{
+  EffDsdvAddressMapTestCase () : TestCase ("Eff-DSDV AddressMap")
+  {
+  }
+  virtual void DoRun ()
+  {
+    effdsdv::AddressMap<uint32_t> map;
+    NS_TEST_EXPECT_MSG_EQ (map.empty (), true, "new map is empty");
+    NS_TEST_EXPECT_MSG_EQ ((map.find (Ipv4Address ("10.1.1.1")) == map.end ()), true, "lookup in empty map");
+    // enough elements to force several rehashes
+    for (uint32_t i = 0; i < 1000; ++i)
+      {
+        NS_TEST_EXPECT_MSG_EQ (map.insert (std::make_pair (Ipv4Address (0x0a010000 + i), i)).second, true, "insert");
+      }
+    NS_TEST_EXPECT_MSG_EQ (map.insert (std::make_pair (Ipv4Address (0x0a010005), 0u)).second, false, "duplicate insert");
+    NS_TEST_EXPECT_MSG_EQ (map.size (), 1000, "size after insert");
+    NS_TEST_EXPECT_MSG_EQ (map.find (Ipv4Address (0x0a010005))->second, 5, "value kept on duplicate insert");
+    // erase every second element while iterating
+    for (effdsdv::AddressMap<uint32_t>::iterator i = map.begin (); i != map.end (); ++i)
+      {
+        if (i->second % 2)
+          {
+            map.erase (i);
+          }
+      }
+    NS_TEST_EXPECT_MSG_EQ (map.size (), 500, "size after erase");
+    uint32_t visited = 0;
+    for (effdsdv::AddressMap<uint32_t>::const_iterator i = map.begin (); i != map.end (); ++i)
+      {
+        NS_TEST_EXPECT_MSG_EQ (i->second % 2, 0, "only even values left");
+        NS_TEST_EXPECT_MSG_EQ (i->first, Ipv4Address (0x0a010000 + i->second), "key matches value");
+        ++visited;
+      }
+    NS_TEST_EXPECT_MSG_EQ (visited, 500, "iteration visits every element");
+    NS_TEST_EXPECT_MSG_EQ (map.erase (Ipv4Address (0x0a010001)), 0, "erase of missing key");
+    NS_TEST_EXPECT_MSG_EQ (map.erase (Ipv4Address (0x0a010002)), 1, "erase of present key");
+    NS_TEST_EXPECT_MSG_EQ ((map.find (Ipv4Address (0x0a010002)) == map.end ()), true, "erased key is gone");
+    map[Ipv4Address (0x0a010002)] = 7;
+    NS_TEST_EXPECT_MSG_EQ (map.find (Ipv4Address (0x0a010002))->second, 7, "reinsert into tombstone");
+    map.clear ();
+    NS_TEST_EXPECT_MSG_EQ (map.size (), 0, "size after clear");
+    NS_TEST_EXPECT_MSG_EQ ((map.begin () == map.end ()), true, "nothing to iterate after clear");
+  }
+};
+
 
 
 
@@ -254,10 +1366,31 @@ EffDsdvTestSuite::EffDsdvTestSuite ()
 	//Packet Tests
 	  AddTestCase (new EffDsdvHeaderTestCase (), TestCase::QUICK);
 	  AddTestCase (new TypeHeaderTest(), TestCase::QUICK);
+	  AddTestCase (new BulkDsdvHeaderTest (), TestCase::QUICK);
+	  AddTestCase (new BulkRequestHeaderTest (), TestCase::QUICK);
+	  AddTestCase (new DsdvBatchHeaderTest (), TestCase::QUICK);
+	  AddTestCase (new ControlPacketParserTest (), TestCase::QUICK);
 	  AddTestCase (new RreqHeaderTest(), TestCase::QUICK);
 	  AddTestCase (new RackHeaderTest(), TestCase::QUICK);
 	//Table Tests
 	  AddTestCase (new EffDsdvTableTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvAddressMapTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvNextHopIndexTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvPurgeTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvRouteIteratorTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvChangedRoutesTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvRouteInstalledTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvNeighborTableTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvRouteStoreTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvSettlingSchedulerTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvTriggerDamperTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvRreqCacheTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvAlternativeRoutesTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvForwardingTableTestCase (), TestCase::QUICK);
+	//Queue Tests
+	  AddTestCase (new EffDsdvPacketQueueTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvQueueDropPolicyTestCase (), TestCase::QUICK);
+	  AddTestCase (new EffDsdvQueueStatsTestCase (), TestCase::QUICK);
 }
 
 